@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Application and benchmark suite
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += application \
+    benchmark
+
+application.file = sinusoidalwavegenerator/SinusoidalWaveGenerator.pro
+benchmark.file = benchmark/benchmark.pro
@@ -0,0 +1,45 @@
+#-------------------------------------------------
+#
+# Benchmark suite of the generation, plotting and export
+# code of SinusoidalWaveGenerator
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
+
+TARGET = SinusoidalWaveGeneratorBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG += c++11
+CONFIG -= app_bundle
+
+APPLICATION_DIR = ../sinusoidalwavegenerator
+INCLUDEPATH += $$APPLICATION_DIR
+
+
+SOURCES += main.cpp \
+    $$APPLICATION_DIR/qcustomplot.cpp \
+    $$APPLICATION_DIR/sinusoidalEquation.cpp \
+    $$APPLICATION_DIR/doubleConversion.cpp \
+    $$APPLICATION_DIR/sampleExporter.cpp \
+    $$APPLICATION_DIR/chunkedExporter.cpp \
+    $$APPLICATION_DIR/waveFile.cpp \
+    $$APPLICATION_DIR/csvImporter.cpp \
+    $$APPLICATION_DIR/imageExporter.cpp \
+    $$APPLICATION_DIR/batchRenderer.cpp \
+    $$APPLICATION_DIR/sweepEngine.cpp \
+    $$APPLICATION_DIR/waveStatistics.cpp
+
+HEADERS  += $$APPLICATION_DIR/qcustomplot.h \
+    $$APPLICATION_DIR/sinusoidalEquation.h \
+    $$APPLICATION_DIR/doubleConversion.h \
+    $$APPLICATION_DIR/sampleExporter.h \
+    $$APPLICATION_DIR/chunkedExporter.h \
+    $$APPLICATION_DIR/waveFile.h \
+    $$APPLICATION_DIR/csvImporter.h \
+    $$APPLICATION_DIR/imageExporter.h \
+    $$APPLICATION_DIR/batchRenderer.h \
+    $$APPLICATION_DIR/sweepEngine.h \
+    $$APPLICATION_DIR/waveStatistics.h
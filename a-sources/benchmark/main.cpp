@@ -0,0 +1,437 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <qcustomplot.h>
+#include <algorithm>
+#include "batchRenderer.h"
+#include "chunkedExporter.h"
+#include "csvImporter.h"
+#include "sampleExporter.h"
+#include "sinusoidalEquation.h"
+#include "sweepEngine.h"
+
+
+/**
+ * @brief Timings of one benchmark case.
+ */
+struct BenchmarkResult
+{
+    /**
+     * @brief Name of the benchmarked operation.
+     */
+    QString name;
+    /**
+     * @brief Parameters of the case, as 'key=value' pairs separated by spaces.
+     */
+    QString parameters;
+    /**
+     * @brief Number of timed iterations.
+     */
+    int iterations;
+    /**
+     * @brief Fastest iteration, in milliseconds.
+     */
+    double minMs;
+    /**
+     * @brief Median iteration, in milliseconds.
+     */
+    double medianMs;
+    /**
+     * @brief Mean of the iterations, in milliseconds.
+     */
+    double meanMs;
+};
+
+/**
+ * @brief Graph that gives access to the data preparation step of the drawing, which is protected in QCPGraph.
+ */
+class PreparedDataGraph : public QCPGraph
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param keyAxis Axis used for the keys.
+     * @param valueAxis Axis used for the values.
+     */
+    PreparedDataGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPGraph(keyAxis, valueAxis) {}
+
+    using QCPGraph::getPreparedData;
+};
+
+/**
+ * @brief Minimum number of timed iterations of each case.
+ */
+static const int MinIterations = 3;
+/**
+ * @brief Maximum number of timed iterations of each case.
+ */
+static const int MaxIterations = 1000;
+
+/**
+ * @brief Runs an operation once to warm up, and then repeatedly until the minimum time has passed.
+ * @param name Name of the benchmarked operation.
+ * @param parameters Parameters of the case.
+ * @param minTimeMs Minimum total time of the timed iterations, in milliseconds.
+ * @param operation Operation to be timed.
+ * @return Timings of the case.
+ */
+template <typename Operation>
+static BenchmarkResult measure(const QString &name, const QString &parameters, double minTimeMs, Operation operation)
+{
+    operation();
+
+    QVector<qint64> times;
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    while (times.size() < MinIterations || (totalTimer.elapsed() < minTimeMs && times.size() < MaxIterations))
+    {
+        QElapsedTimer timer;
+        timer.start();
+        operation();
+        times.append(timer.nsecsElapsed());
+    }
+
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for (int i = 0; i < times.size(); ++i)
+        sum += times.at(i);
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.iterations = times.size();
+    result.minMs = times.first() / 1e6;
+    result.medianMs = times.at(times.size() / 2) / 1e6;
+    result.meanMs = sum / times.size() / 1e6;
+
+    QTextStream(stderr) << name << " " << parameters << ": " << result.medianMs << " ms" << endl;
+    return result;
+}
+
+/**
+ * @brief Creates a plot ready to be drawn at the given size, without showing it on screen.
+ * @param plot Plot to be prepared.
+ * @param width Width of the plot, in pixels.
+ * @param height Height of the plot, in pixels.
+ */
+static void preparePlot(QCustomPlot &plot, int width, int height)
+{
+    plot.setAttribute(Qt::WA_DontShowOnScreen);
+    plot.resize(width, height);
+    plot.show();
+    QApplication::processEvents();
+}
+
+/**
+ * @brief Applies one of the styles offered by the application to a graph.
+ * @param graph Graph to be styled.
+ * @param style 'line' for a line without scatters, or 'scatter' for discs without line (default style of the application).
+ */
+static void applyStyle(QCPGraph *graph, const QString &style)
+{
+    graph->setPen(QPen(QColor(0, 0, 255)));
+    if (style == "line")
+    {
+        graph->setLineStyle(QCPGraph::lsLine);
+        graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssNone));
+    }
+    else
+    {
+        graph->setLineStyle(QCPGraph::lsNone);
+        graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 3));
+    }
+}
+
+/**
+ * @brief Writes the results as JSON.
+ * @param results Results of all the cases.
+ * @param device Device where the results are written.
+ */
+static void writeJson(const QVector<BenchmarkResult> &results, QIODevice &device)
+{
+    QJsonArray benchmarks;
+    for (int i = 0; i < results.size(); ++i)
+    {
+        QJsonObject benchmark;
+        benchmark["name"] = results.at(i).name;
+        benchmark["parameters"] = results.at(i).parameters;
+        benchmark["iterations"] = results.at(i).iterations;
+        benchmark["min_ms"] = results.at(i).minMs;
+        benchmark["median_ms"] = results.at(i).medianMs;
+        benchmark["mean_ms"] = results.at(i).meanMs;
+        benchmarks.append(benchmark);
+    }
+
+    QJsonObject root;
+    root["qt_version"] = QString(qVersion());
+    root["build_abi"] = QSysInfo::buildAbi();
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["benchmarks"] = benchmarks;
+    device.write(QJsonDocument(root).toJson());
+}
+
+/**
+ * @brief Writes the results as comma separated values, one line per case.
+ * @param results Results of all the cases.
+ * @param device Device where the results are written.
+ */
+static void writeCsv(const QVector<BenchmarkResult> &results, QIODevice &device)
+{
+    QTextStream stream(&device);
+    stream << "name,parameters,iterations,min_ms,median_ms,mean_ms\n";
+    for (int i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult &result = results.at(i);
+        stream << result.name << ',' << result.parameters << ',' << result.iterations << ','
+               << result.minMs << ',' << result.medianMs << ',' << result.meanMs << '\n';
+    }
+}
+
+/**
+ * @brief Benchmark entry point.
+ * @param argc Number of input arguments.
+ * @param argv Array of input arguments.
+ * @return Exit code.
+ */
+int main(int argc, char *argv[])
+{
+    // Draw offscreen unless a platform is requested, so the suite also runs without display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the generation, plotting and export of sinusoidal waves.");
+    parser.addHelpOption();
+    QCommandLineOption formatOption("format", "Format of the results: json or csv.", "format", "json");
+    QCommandLineOption outputOption("output", "File where the results are written, or '-' for the standard output.", "file", "-");
+    QCommandLineOption minTimeOption("min-time", "Minimum time spent timing each case, in milliseconds.", "ms", "500");
+    QCommandLineOption filterOption("filter", "Only run the cases whose name contains the text.", "text");
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(minTimeOption);
+    parser.addOption(filterOption);
+    parser.process(app);
+
+    QString format = parser.value(formatOption);
+    double minTimeMs = parser.value(minTimeOption).toDouble();
+    QString filter = parser.value(filterOption);
+    if (format != "json" && format != "csv")
+    {
+        QTextStream(stderr) << "Unknown format " << format << endl;
+        return 1;
+    }
+
+    QVector<BenchmarkResult> results;
+    QList<int> sampleCounts = QList<int>() << 1000 << 10000 << 100000 << 1000000;
+    QList<int> drawnSampleCounts = QList<int>() << 10000 << 1000000;
+    QList<QSize> sizes = QList<QSize>() << QSize(400, 300) << QSize(800, 600) << QSize(1920, 1080);
+    QStringList styles = QStringList() << "line" << "scatter";
+
+    // Generation: one period sampled with the given number of samples
+    if (QString("solveEquation").contains(filter))
+    {
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            SinusoidalEquation equation;
+            results.append(measure("solveEquation", QString("samples=%1").arg(samples), minTimeMs, [&]() {
+                equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            }));
+        }
+    }
+
+    // Ingestion of the samples into the graph
+    if (QString("setData").contains(filter))
+    {
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            SinusoidalEquation equation;
+            equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            QVector<double> timeVector = equation.timeVector();
+            QVector<double> elongationVector = equation.elongationVector();
+            QCustomPlot plot;
+            QCPGraph *graph = plot.addGraph();
+            results.append(measure("setData", QString("samples=%1").arg(samples), minTimeMs, [&]() {
+                graph->setData(timeVector, elongationVector);
+            }));
+        }
+    }
+
+    // Rendering: data preparation and full replot at several sizes and styles
+    bool renderingSelected = QString("getPreparedData").contains(filter) || QString("replot").contains(filter);
+    for (int i = 0; i < drawnSampleCounts.size() && renderingSelected; ++i)
+    {
+        int samples = drawnSampleCounts.at(i);
+        SinusoidalEquation equation;
+        equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+        for (int j = 0; j < sizes.size(); ++j)
+        {
+            for (int k = 0; k < styles.size(); ++k)
+            {
+                QString parameters = QString("samples=%1 size=%2x%3 style=%4").arg(samples).arg(sizes.at(j).width()).arg(sizes.at(j).height()).arg(styles.at(k));
+                QCustomPlot plot;
+                PreparedDataGraph *graph = new PreparedDataGraph(plot.xAxis, plot.yAxis);
+                plot.addPlottable(graph);
+                applyStyle(graph, styles.at(k));
+                graph->setData(equation.timeVector(), equation.elongationVector());
+                graph->rescaleAxes();
+                preparePlot(plot, sizes.at(j).width(), sizes.at(j).height());
+
+                if (QString("getPreparedData").contains(filter))
+                {
+                    QVector<QCPData> lineData;
+                    QVector<QCPData> scatterData;
+                    results.append(measure("getPreparedData", parameters, minTimeMs, [&]() {
+                        graph->getPreparedData(&lineData, &scatterData);
+                    }));
+                }
+                if (QString("replot").contains(filter))
+                {
+                    results.append(measure("replot", parameters, minTimeMs, [&]() {
+                        plot.replot(QCustomPlot::rpQueued);
+                    }));
+                }
+            }
+        }
+    }
+
+    // Export to PNG, at the size used by the application
+    if (QString("savePng").contains(filter))
+    {
+        QTemporaryDir directory;
+        QString fileName = QDir(directory.path()).filePath("benchmark.png");
+        for (int i = 0; i < drawnSampleCounts.size(); ++i)
+        {
+            int samples = drawnSampleCounts.at(i);
+            SinusoidalEquation equation;
+            equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            QCustomPlot plot;
+            QCPGraph *graph = plot.addGraph();
+            applyStyle(graph, "scatter");
+            graph->setData(equation.timeVector(), equation.elongationVector());
+            graph->rescaleAxes();
+            results.append(measure("savePng", QString("samples=%1 size=800x600").arg(samples), minTimeMs, [&]() {
+                plot.savePng(fileName, 800, 600);
+            }));
+        }
+    }
+
+    // Batch rendering of the frames of a phase sweep, on all the cores
+    if (QString("renderSweep").contains(filter))
+    {
+        QTemporaryDir directory;
+        for (int i = 0; i < drawnSampleCounts.size(); ++i)
+        {
+            int samples = drawnSampleCounts.at(i);
+            BatchRenderer renderer;
+            renderer.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            renderer.setSweep(BatchRenderer::InitialDelay, 0.0, 360.0, 32);
+            renderer.setOutput(directory.path(), "frame", 800, 600);
+            results.append(measure("renderSweep", QString("samples=%1 frames=32 size=800x600").arg(samples), minTimeMs, [&]() {
+                renderer.render();
+            }));
+        }
+    }
+
+    // Export of the samples as CSV, to a file
+    if (QString("exportCsv").contains(filter))
+    {
+        QTemporaryDir directory;
+        QString fileName = QDir(directory.path()).filePath("benchmark.csv");
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            SinusoidalEquation equation;
+            equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            results.append(measure("exportCsv", QString("samples=%1").arg(samples), minTimeMs, [&]() {
+                SampleExporter::writeDelimited(fileName, equation.timeVector(), equation.elongationVector(), ',');
+            }));
+        }
+    }
+
+    // Generation and export of the samples as CSV in chunks, without solving the equation
+    if (QString("exportChunkedCsv").contains(filter))
+    {
+        QTemporaryDir directory;
+        QString fileName = QDir(directory.path()).filePath("benchmark.csv");
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            ChunkedExporter exporter;
+            exporter.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            results.append(measure("exportChunkedCsv", QString("samples=%1").arg(samples), minTimeMs, [&]() {
+                exporter.setOutput(fileName, ChunkedExporter::CsvFile);
+                exporter.exportSamples();
+            }));
+        }
+    }
+
+    // Parallel import of a CSV file written by the exporter
+    if (QString("importCsv").contains(filter))
+    {
+        QTemporaryDir directory;
+        QString fileName = QDir(directory.path()).filePath("benchmark.csv");
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            SinusoidalEquation equation;
+            equation.setParameters(1.0, 1.0, 0.0, 1, samples, 0.0);
+            SampleExporter::writeDelimited(fileName, equation.timeVector(), equation.elongationVector(), ',');
+            QVector<double> timeVector;
+            QVector<double> elongationVector;
+            results.append(measure("importCsv", QString("samples=%1 bytes=%2").arg(samples).arg(QFileInfo(fileName).size()), minTimeMs, [&]() {
+                CsvImporter::read(fileName, timeVector, elongationVector);
+            }));
+        }
+    }
+
+    // Summaries of a grid of 10x10x10x10 waves solved on all the cores
+    if (QString("solveSweep").contains(filter))
+    {
+        for (int i = 0; i < sampleCounts.size(); ++i)
+        {
+            int samples = sampleCounts.at(i);
+            SweepEngine::Grid grid;
+            grid.amplitudes = SweepEngine::range(0.1, 1.0, 10);
+            grid.oscillationFrequencies = SweepEngine::range(1.0, 10.0, 10);
+            grid.initialDelays = SweepEngine::range(0.0, 324.0, 10);
+            grid.attenuationFactors = SweepEngine::range(0.0, 0.9, 10);
+            grid.numberOfPeriods = 1;
+            grid.samplingFrequency = samples / 100;
+            SweepEngine engine;
+            engine.setGrid(grid);
+            results.append(measure("solveSweep", QString("runs=10000 samples<=%1").arg(samples / 100 + 1), minTimeMs, [&]() {
+                engine.solve();
+            }));
+        }
+    }
+
+    // Write the results
+    QFile output(parser.value(outputOption));
+    bool opened;
+    if (parser.value(outputOption) == "-")
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    else
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!opened)
+    {
+        QTextStream(stderr) << "Error trying to write results to " << parser.value(outputOption) << endl;
+        return 1;
+    }
+    if (format == "json")
+        writeJson(results, output);
+    else
+        writeCsv(results, output);
+
+    return 0;
+}
@@ -7,21 +7,67 @@
 QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
+# SVG export of the graph
+QT       += svg
 
 TARGET = SinusoidalWaveGenerator
 TEMPLATE = app
 
+# Hot-path timers and performance HUD, disabled by default (qmake CONFIG+=perf_counters)
+perf_counters: DEFINES += SWG_PERF_COUNTERS
+# Timeline recording for chrome://tracing, disabled by default (qmake CONFIG+=tracing)
+tracing: DEFINES += SWG_TRACING
+
 
 SOURCES += main.cpp\
         mainWindow.cpp \
     qcustomplot.cpp \
     sinusoidalEquation.cpp \
-    plotWindow.cpp
+    plotWindow.cpp \
+    streamingGraph.cpp \
+    streamGenerator.cpp \
+    triggerEngine.cpp \
+    startupTiming.cpp \
+    perfCounters.cpp \
+    traceRecorder.cpp \
+    doubleConversion.cpp \
+    sampleExporter.cpp \
+    chunkedExporter.cpp \
+    waveFile.cpp \
+    mappedWaveform.cpp \
+    mappedGraph.cpp \
+    csvImporter.cpp \
+    imageExporter.cpp \
+    batchRenderer.cpp \
+    vectorExporter.cpp \
+    sweepEngine.cpp \
+    sweepRunner.cpp \
+    waveStatistics.cpp
 
 HEADERS  += mainWindow.h \
     qcustomplot.h \
     sinusoidalEquation.h \
-    plotWindow.h
+    plotWindow.h \
+    streamingGraph.h \
+    sampleQueue.h \
+    streamGenerator.h \
+    triggerEngine.h \
+    startupTiming.h \
+    perfCounters.h \
+    traceRecorder.h \
+    doubleConversion.h \
+    sampleExporter.h \
+    chunkedExporter.h \
+    waveFile.h \
+    mappedWaveform.h \
+    mappedGraph.h \
+    csvImporter.h \
+    imageExporter.h \
+    batchRenderer.h \
+    vectorExporter.h \
+    sweepEngine.h \
+    sweepRunner.h \
+    waveStatistics.h
 
 FORMS    += mainWindow.ui \
     plotWindow.ui
@@ -0,0 +1,436 @@
+#include "batchRenderer.h"
+#include <qcustomplot.h>
+#include <QAtomicInt>
+#include <QDir>
+#include <QMutex>
+#include <QPicture>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include "imageExporter.h"
+#include "perfCounters.h"
+#include "sinusoidalEquation.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Frame solved by a solving thread, waiting to be drawn in the GUI thread.
+     */
+    struct SolvedFrame
+    {
+        /**
+         * @brief Index of the frame.
+         */
+        int index;
+        /**
+         * @brief Time samples, in seconds.
+         */
+        QVector<double> timeVector;
+        /**
+         * @brief Elongation samples.
+         */
+        QVector<double> elongationVector;
+        /**
+         * @brief Factor by which the sampling frequency was divided to fit in the memory limit.
+         */
+        int decimationFactor;
+    };
+
+    /**
+     * @brief Frame recorded in the GUI thread, waiting to be rendered.
+     */
+    struct Frame
+    {
+        /**
+         * @brief Recorded drawing of the plot.
+         */
+        QPicture picture;
+        /**
+         * @brief Full path of the file of the frame.
+         */
+        QString fileName;
+    };
+
+    /**
+     * @brief Bounded queue of frames between the stages of the rendering: from the solving threads to
+     * the GUI thread, and from the GUI thread to the rendering threads.
+     */
+    template <typename T>
+    class FrameQueue
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param capacity Maximum number of frames waiting.
+         */
+        explicit FrameQueue(int capacity)
+            : m_capacity(capacity),
+              m_finished(false),
+              m_failed(false)
+        {
+        }
+
+        /**
+         * @brief Adds a frame, waiting while the queue is full.
+         * @param frame Frame.
+         * @return true if added, or false if a frame has failed and there is no point in going on.
+         */
+        bool push(const T &frame)
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_frames.size() >= m_capacity && !m_failed)
+                m_notFull.wait(&m_mutex);
+            if (m_failed)
+                return false;
+            m_frames.enqueue(frame);
+            m_notEmpty.wakeOne();
+            return true;
+        }
+        /**
+         * @brief Takes the next frame, waiting while the queue is empty.
+         * @param frame Set to the frame.
+         * @return true if a frame is taken, or false if there are no more frames.
+         */
+        bool pop(T &frame)
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_frames.isEmpty() && !m_finished && !m_failed)
+                m_notEmpty.wait(&m_mutex);
+            if (m_frames.isEmpty() || m_failed)
+                return false;
+            frame = m_frames.dequeue();
+            m_notFull.wakeOne();
+            return true;
+        }
+        /**
+         * @brief Tells the consumers that no more frames will be added.
+         */
+        void finish()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_finished = true;
+            m_notEmpty.wakeAll();
+        }
+        /**
+         * @brief Records that a frame could not be processed, which stops everybody.
+         */
+        void fail()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_failed = true;
+            m_notEmpty.wakeAll();
+            m_notFull.wakeAll();
+        }
+        /**
+         * @brief Gets whether a frame could not be processed.
+         * @return true if a frame failed, or false otherwise.
+         */
+        bool hasFailed()
+        {
+            QMutexLocker locker(&m_mutex);
+            return m_failed;
+        }
+
+    private:
+        /**
+         * @brief Protects the queue and the flags.
+         */
+        QMutex m_mutex;
+        /**
+         * @brief Signalled when a frame is added or the queue finishes.
+         */
+        QWaitCondition m_notEmpty;
+        /**
+         * @brief Signalled when a frame is taken.
+         */
+        QWaitCondition m_notFull;
+        /**
+         * @brief Frames waiting.
+         */
+        QQueue<T> m_frames;
+        /**
+         * @brief Maximum number of frames waiting.
+         */
+        int m_capacity;
+        /**
+         * @brief Whether no more frames will be added.
+         */
+        bool m_finished;
+        /**
+         * @brief Whether a frame could not be processed.
+         */
+        bool m_failed;
+    };
+
+    /**
+     * @brief Thread that takes frames one at a time and solves their equation, until there are no more.
+     */
+    class FrameSolver : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param renderer Renderer that knows the parameters of each frame.
+         * @param next Index of the next frame to take, shared by the solvers.
+         * @param running Number of solvers still running. The last one to stop finishes the queue.
+         * @param queue Queue of solved frames.
+         */
+        FrameSolver(const BatchRenderer *renderer, QAtomicInt *next, QAtomicInt *running, FrameQueue<SolvedFrame> *queue)
+            : m_renderer(renderer),
+              m_next(next),
+              m_running(running),
+              m_queue(queue)
+        {
+            // Name of the thread in traces
+            setObjectName("Frame solver");
+        }
+
+    protected:
+        /**
+         * @brief Solves frames.
+         */
+        void run()
+        {
+            SinusoidalEquation equation;
+            for (int frame = m_next->fetchAndAddRelaxed(1); frame < m_renderer->frameCount(); frame = m_next->fetchAndAddRelaxed(1))
+            {
+                SWG_TRACE_SCOPE_ARG("BatchRenderer::solveFrame", frame);
+                m_renderer->solveFrame(frame, equation);
+                SolvedFrame solved;
+                solved.index = frame;
+                solved.timeVector = equation.timeVector();
+                solved.elongationVector = equation.elongationVector();
+                solved.decimationFactor = equation.decimationFactor();
+                if (!m_queue->push(solved))
+                    break;
+            }
+            if (!m_running->deref())
+                m_queue->finish();
+        }
+
+    private:
+        /**
+         * @brief Renderer that knows the parameters of each frame.
+         */
+        const BatchRenderer *m_renderer;
+        /**
+         * @brief Index of the next frame to take.
+         */
+        QAtomicInt *m_next;
+        /**
+         * @brief Number of solvers still running.
+         */
+        QAtomicInt *m_running;
+        /**
+         * @brief Queue of solved frames.
+         */
+        FrameQueue<SolvedFrame> *m_queue;
+    };
+
+    /**
+     * @brief Thread that renders and saves the frames of a queue until it finishes.
+     */
+    class FrameRenderer : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param queue Queue of frames.
+         * @param size Size of the frames, in pixels.
+         */
+        FrameRenderer(FrameQueue<Frame> *queue, const QSize &size)
+            : m_queue(queue),
+              m_size(size)
+        {
+            // Name of the thread in traces
+            setObjectName("Frame renderer");
+        }
+
+    protected:
+        /**
+         * @brief Renders and saves the frames.
+         */
+        void run()
+        {
+            ImageExporter exporter;
+            Frame frame;
+            while (m_queue->pop(frame))
+            {
+                exporter.setPicture(frame.picture, m_size);
+                exporter.setOutput(frame.fileName, "PNG");
+                if (!exporter.exportImage())
+                    m_queue->fail();
+            }
+        }
+
+    private:
+        /**
+         * @brief Queue of frames.
+         */
+        FrameQueue<Frame> *m_queue;
+        /**
+         * @brief Size of the frames, in pixels.
+         */
+        QSize m_size;
+    };
+}
+
+BatchRenderer::BatchRenderer()
+    : m_amplitude(1.0),
+      m_oscillationFrequency(1.0),
+      m_initialDelay(0.0),
+      m_numberOfPeriods(1),
+      m_samplingFrequency(1000.0),
+      m_attenuationFactor(0.0),
+      m_sweptParameter(InitialDelay),
+      m_from(0.0),
+      m_to(0.0),
+      m_frameCount(0),
+      m_directory("."),
+      m_prefix("frame"),
+      m_width(800),
+      m_height(600),
+      m_decimatedFrameCount(0),
+      m_maxDecimationFactor(1)
+{
+}
+
+void BatchRenderer::setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor)
+{
+    m_amplitude = amplitude;
+    m_oscillationFrequency = oscillationFrequency;
+    m_initialDelay = initialDelay;
+    m_numberOfPeriods = numberOfPeriods;
+    m_samplingFrequency = samplingFrequency;
+    m_attenuationFactor = attenuationFactor;
+}
+
+void BatchRenderer::setSweep(SweptParameter parameter, double from, double to, int frameCount)
+{
+    m_sweptParameter = parameter;
+    m_from = from;
+    m_to = to;
+    m_frameCount = qMax(frameCount, 0);
+}
+
+void BatchRenderer::setOutput(const QString &directory, const QString &prefix, int width, int height)
+{
+    m_directory = directory;
+    m_prefix = prefix;
+    m_width = width;
+    m_height = height;
+}
+
+double BatchRenderer::frameValue(int frame) const
+{
+    if (m_frameCount <= 1)
+        return m_from;
+    return m_from + (m_to - m_from) * frame / (m_frameCount - 1);
+}
+
+QString BatchRenderer::frameFileName(int frame) const
+{
+    // At least four digits, and as many as the last frame needs
+    int digits = qMax(4, QString::number(m_frameCount - 1).size());
+    return QDir(m_directory).filePath(QString("%1_%2.png").arg(m_prefix).arg(frame, digits, 10, QChar('0')));
+}
+
+void BatchRenderer::solveFrame(int frame, SinusoidalEquation &equation) const
+{
+    double value = frameValue(frame);
+    equation.setParameters(m_amplitude,
+                           (m_sweptParameter == OscillationFrequency) ? value : m_oscillationFrequency,
+                           (m_sweptParameter == InitialDelay) ? value : m_initialDelay,
+                           m_numberOfPeriods,
+                           m_samplingFrequency,
+                           (m_sweptParameter == AttenuationFactor) ? value : m_attenuationFactor);
+}
+
+bool BatchRenderer::render(int threadCount)
+{
+    SWG_PERF_SCOPE("BatchRenderer::render");
+    SWG_TRACE_SCOPE_ARG("BatchRenderer::render", m_frameCount);
+
+    m_decimatedFrameCount = 0;
+    m_maxDecimationFactor = 1;
+    if (m_width <= 0 || m_height <= 0 || !QDir().mkpath(m_directory))
+        return false;
+
+    // Solving threads feed this one, which feeds the rendering threads
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    threadCount = qMax(threadCount, 1);
+    FrameQueue<SolvedFrame> solvedQueue(threadCount * FramesPerThread);
+    FrameQueue<Frame> recordedQueue(threadCount * FramesPerThread);
+    QList<FrameRenderer *> renderers;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        renderers.append(new FrameRenderer(&recordedQueue, QSize(m_width, m_height)));
+        renderers.last()->start();
+    }
+    QAtomicInt next(0);
+    QAtomicInt running(threadCount);
+    QList<FrameSolver *> solvers;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        solvers.append(new FrameSolver(this, &next, &running, &solvedQueue));
+        solvers.last()->start();
+    }
+
+    // Only the plot, which is a widget, is left to the GUI thread: the frames arrive in any order
+    QCustomPlot plot;
+    plot.addGraph();
+    applyStyle(&plot);
+    SolvedFrame solved;
+    while (solvedQueue.pop(solved))
+    {
+        SWG_TRACE_SCOPE_ARG("BatchRenderer::recordFrame", solved.index);
+
+        if (solved.decimationFactor > 1)
+        {
+            ++m_decimatedFrameCount;
+            m_maxDecimationFactor = qMax(m_maxDecimationFactor, solved.decimationFactor);
+        }
+        plot.graph(0)->setData(solved.timeVector, solved.elongationVector);
+        plot.graph(0)->rescaleKeyAxis();
+        plot.yAxis->setRange(-qAbs(m_amplitude), qAbs(m_amplitude));
+        plot.graph(0)->rescaleValueAxis(true);
+
+        // Record its drawing, rendered by the threads
+        Frame recorded;
+        recorded.fileName = frameFileName(solved.index);
+        QCPPainter painter;
+        if (painter.begin(&recorded.picture))
+        {
+            plot.toPainter(&painter, m_width, m_height);
+            painter.end();
+        }
+        if (!recordedQueue.push(recorded))
+        {
+            // A frame could not be saved, so the solvers can stop too
+            solvedQueue.fail();
+            break;
+        }
+    }
+
+    recordedQueue.finish();
+    for (int i = 0; i < solvers.size(); ++i)
+        solvers.at(i)->wait();
+    for (int i = 0; i < renderers.size(); ++i)
+        renderers.at(i)->wait();
+    qDeleteAll(solvers);
+    qDeleteAll(renderers);
+    SWG_PERF_VALUE("BatchRenderer::render decimated frames", m_decimatedFrameCount);
+    return !recordedQueue.hasFailed();
+}
+
+void BatchRenderer::applyStyle(QCustomPlot *plot)
+{
+    plot->graph(0)->setPen(QPen(QColor(0, 0, 255)));
+    plot->graph(0)->setLineStyle(QCPGraph::lsNone);
+    plot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 3));
+    plot->xAxis->setLabel("time [seconds]");
+    plot->yAxis->setLabel("elongation [units]");
+}
@@ -0,0 +1,192 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QString>
+
+class QCustomPlot;
+class SinusoidalEquation;
+
+/**
+ * @brief Renders a sequence of PNG images of a sinusoidal wave while one of its parameters is swept,
+ * for phase and frequency sweeps, damping series and animations.
+ *
+ * The frames go through three stages. A pool of threads solves the equation of each frame. A
+ * QCustomPlot is a widget, so it can only exist in the GUI thread, where each solved frame is set to
+ * the graph and drawn into a QPicture, which only records the painter commands. A second pool of
+ * threads replays the pictures into images and encodes them with ImageExporter, which is where most
+ * of the time goes. At most a few frames per thread wait between the stages, so the memory used does
+ * not grow with the number of frames.
+ *
+ * Each frame is solved within the default memory limit of SinusoidalEquation. The frames that are
+ * decimated to fit in it are counted, see decimatedFrameCount().
+ *
+ * The frames are named after their index, padded with zeros so that they sort in order. The time
+ * axis fits each frame, and the elongation axis is kept at the amplitude so the frames line up,
+ * unless the wave grows beyond it.
+ */
+class BatchRenderer
+{
+public:
+    /**
+     * @brief Parameter of the wave that changes between frames.
+     */
+    enum SweptParameter
+    {
+        InitialDelay,           ///< Initial delay, in degrees
+        OscillationFrequency,   ///< Oscillation frequency, in hertz
+        AttenuationFactor       ///< Attenuation factor, in units per second
+    };
+
+    /**
+     * @brief Constructor.
+     */
+    BatchRenderer();
+
+    /**
+     * @brief Sets the parameters of the wave. The swept one is replaced in each frame.
+     * @param amplitude Amplitude of the wave.
+     * @param oscillationFrequency Oscillation frequency of the wave, in hertz.
+     * @param initialDelay Initial delay of the wave, in degrees.
+     * @param numberOfPeriods Number of periods of the wave.
+     * @param samplingFrequency Sampling frequency of the wave, in hertz.
+     * @param attenuationFactor Attenuation factor of the wave, in units per second.
+     */
+    void setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor);
+    /**
+     * @brief Sets the swept parameter and its values, evenly spaced from the first frame to the last one.
+     * @param parameter Swept parameter.
+     * @param from Value in the first frame.
+     * @param to Value in the last frame.
+     * @param frameCount Number of frames.
+     */
+    void setSweep(SweptParameter parameter, double from, double to, int frameCount);
+    /**
+     * @brief Sets where the frames are saved.
+     * @param directory Directory of the frames, created if needed.
+     * @param prefix Start of the name of each frame, followed by its index.
+     * @param width Width of the images, in pixels.
+     * @param height Height of the images, in pixels.
+     */
+    void setOutput(const QString &directory, const QString &prefix = "frame", int width = 800, int height = 600);
+
+    /**
+     * @brief Gets the number of frames.
+     * @return Number of frames.
+     */
+    int frameCount() const { return m_frameCount; }
+    /**
+     * @brief Gets the value of the swept parameter in a frame.
+     * @param frame Index of the frame.
+     * @return Value of the parameter.
+     */
+    double frameValue(int frame) const;
+    /**
+     * @brief Gets the file of a frame, such as frame_0042.png.
+     * @param frame Index of the frame.
+     * @return Full path of the file.
+     */
+    QString frameFileName(int frame) const;
+    /**
+     * @brief Solves the equation of a frame. Can be called from any thread.
+     * @param frame Index of the frame.
+     * @param equation Equation, set to the parameters of the frame.
+     */
+    void solveFrame(int frame, SinusoidalEquation &equation) const;
+
+    /**
+     * @brief Renders and saves all the frames, blocking until they are written or one fails.
+     * Must be called from the GUI thread.
+     * @param threadCount Number of threads that solve the frames, and of threads that encode them, or 0 for one per core.
+     * @return true if all the frames are correctly written, or false otherwise.
+     */
+    bool render(int threadCount = 0);
+    /**
+     * @brief Gets the number of frames of the last render decimated to fit in the memory limit.
+     * @return Number of decimated frames.
+     */
+    int decimatedFrameCount() const { return m_decimatedFrameCount; }
+    /**
+     * @brief Gets the largest decimation of the frames of the last render.
+     * @return 1 if no frame was decimated, or the largest factor by which a sampling frequency was divided.
+     */
+    int maxDecimationFactor() const { return m_maxDecimationFactor; }
+
+    /**
+     * @brief Styles a plot to draw an equation the same way as the PlotWindow.
+     * @param plot Plot, with a single graph.
+     */
+    static void applyStyle(QCustomPlot *plot);
+
+private:
+    /**
+     * @brief Maximum number of frames waiting per thread between two stages.
+     */
+    static const int FramesPerThread = 2;
+
+    /**
+     * @brief Amplitude of the wave.
+     */
+    double m_amplitude;
+    /**
+     * @brief Oscillation frequency of the wave, in hertz.
+     */
+    double m_oscillationFrequency;
+    /**
+     * @brief Initial delay of the wave, in degrees.
+     */
+    double m_initialDelay;
+    /**
+     * @brief Number of periods of the wave.
+     */
+    int m_numberOfPeriods;
+    /**
+     * @brief Sampling frequency of the wave, in hertz.
+     */
+    double m_samplingFrequency;
+    /**
+     * @brief Attenuation factor of the wave, in units per second.
+     */
+    double m_attenuationFactor;
+    /**
+     * @brief Swept parameter.
+     */
+    SweptParameter m_sweptParameter;
+    /**
+     * @brief Value of the swept parameter in the first frame.
+     */
+    double m_from;
+    /**
+     * @brief Value of the swept parameter in the last frame.
+     */
+    double m_to;
+    /**
+     * @brief Number of frames.
+     */
+    int m_frameCount;
+    /**
+     * @brief Directory of the frames.
+     */
+    QString m_directory;
+    /**
+     * @brief Start of the name of each frame.
+     */
+    QString m_prefix;
+    /**
+     * @brief Width of the images, in pixels.
+     */
+    int m_width;
+    /**
+     * @brief Height of the images, in pixels.
+     */
+    int m_height;
+    /**
+     * @brief Number of frames of the last render decimated to fit in the memory limit.
+     */
+    int m_decimatedFrameCount;
+    /**
+     * @brief Largest decimation of the frames of the last render.
+     */
+    int m_maxDecimationFactor;
+};
+
+#endif // BATCHRENDERER_H
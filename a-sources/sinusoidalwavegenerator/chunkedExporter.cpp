@@ -0,0 +1,324 @@
+#include "chunkedExporter.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSemaphore>
+#include <QVector>
+#include <QtMath>
+#include "perfCounters.h"
+#include "sinusoidalEquation.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Thread that writes the buffers filled by the exporter to a device, one while the other is filled.
+     *
+     * The exporter takes a free buffer with acquireBuffer(), fills it and hands it over with
+     * releaseBuffer(). The writer writes the buffers in the same order and gives them back. After a
+     * failed write the writer keeps taking the buffers without writing them, so that nobody waits forever.
+     */
+    class ChunkWriter : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param device Device open for writing.
+         * @param bufferSize Size of each buffer, in bytes.
+         */
+        ChunkWriter(QIODevice *device, int bufferSize)
+            : m_device(device),
+              m_freeBuffers(BufferCount),
+              m_filledBuffers(0),
+              m_nextFilled(0),
+              m_failed(0)
+        {
+            for (int i = 0; i < BufferCount; ++i)
+            {
+                m_buffers[i].resize(bufferSize);
+                m_sizes[i] = 0;
+            }
+
+            // Name of the thread in traces
+            setObjectName("Export writer");
+        }
+
+        /**
+         * @brief Takes the next buffer to fill, waiting until the writer has finished with it.
+         * @return Buffer, or NULL if a write has failed.
+         */
+        char *acquireBuffer()
+        {
+            m_freeBuffers.acquire();
+            if (m_failed.loadAcquire() != 0)
+            {
+                m_freeBuffers.release();
+                return NULL;
+            }
+            return m_buffers[m_nextFilled].data();
+        }
+        /**
+         * @brief Hands the buffer taken with acquireBuffer() over to the writer.
+         * @param size Bytes filled, or -1 to stop the writer.
+         */
+        void releaseBuffer(int size)
+        {
+            m_sizes[m_nextFilled] = size;
+            m_nextFilled = (m_nextFilled + 1) % BufferCount;
+            m_filledBuffers.release();
+        }
+        /**
+         * @brief Waits until all the filled buffers are written and stops the writer.
+         * @return true if all the buffers are written, or false otherwise.
+         */
+        bool finish()
+        {
+            m_freeBuffers.acquire();
+            releaseBuffer(-1);
+            wait();
+            return m_failed.loadAcquire() == 0;
+        }
+
+    protected:
+        /**
+         * @brief Writes the filled buffers until stopped.
+         */
+        void run()
+        {
+            for (int next = 0; ; next = (next + 1) % BufferCount)
+            {
+                m_filledBuffers.acquire();
+                int size = m_sizes[next];
+                if (size < 0)
+                    break;
+                if (m_failed.load() == 0)
+                {
+                    SWG_TRACE_SCOPE_ARG("ChunkWriter::write", size);
+                    if (m_device->write(m_buffers[next].constData(), size) != size)
+                        m_failed.storeRelease(1);
+                }
+                m_freeBuffers.release();
+            }
+        }
+
+    private:
+        /**
+         * @brief Number of buffers: one being filled and one being written.
+         */
+        static const int BufferCount = 2;
+
+        /**
+         * @brief Device where the buffers are written.
+         */
+        QIODevice *m_device;
+        /**
+         * @brief Buffers.
+         */
+        QByteArray m_buffers[BufferCount];
+        /**
+         * @brief Bytes filled in each buffer, or -1 to stop.
+         */
+        int m_sizes[BufferCount];
+        /**
+         * @brief Buffers that can be filled.
+         */
+        QSemaphore m_freeBuffers;
+        /**
+         * @brief Buffers that are waiting to be written.
+         */
+        QSemaphore m_filledBuffers;
+        /**
+         * @brief Buffer filled next. Only used by the exporter.
+         */
+        int m_nextFilled;
+        /**
+         * @brief Non-zero once a write has failed.
+         */
+        QAtomicInt m_failed;
+    };
+}
+
+ChunkedExporter::ChunkedExporter(QObject *parent)
+    : QThread(parent),
+      m_amplitude(1.0),
+      m_oscillationFrequency(100.0),
+      m_initialDelay(0.0),
+      m_numberOfPeriods(1),
+      m_samplingFrequency(10000.0),
+      m_attenuationFactor(0.0),
+      m_fileName(),
+      m_fileFormat(CsvFile),
+      m_sampleFormat(Float32),
+      m_dither(false),
+      m_cancelRequested(0)
+{
+    // Name of the thread in traces
+    setObjectName("Chunked exporter");
+}
+
+ChunkedExporter::~ChunkedExporter()
+{
+    cancel();
+    wait();
+}
+
+void ChunkedExporter::setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor)
+{
+    m_amplitude = amplitude;
+    m_oscillationFrequency = oscillationFrequency;
+    m_initialDelay = initialDelay;
+    m_numberOfPeriods = numberOfPeriods;
+    m_samplingFrequency = samplingFrequency;
+    m_attenuationFactor = attenuationFactor;
+}
+
+void ChunkedExporter::setOutput(const QString &fileName, FileFormat fileFormat, SampleFormat sampleFormat, bool dither)
+{
+    m_fileName = fileName;
+    m_fileFormat = fileFormat;
+    m_sampleFormat = sampleFormat;
+    m_dither = dither;
+    m_cancelRequested.storeRelease(0);
+}
+
+qint64 ChunkedExporter::sampleCount() const
+{
+    return SinusoidalEquation::sampleCount(m_oscillationFrequency, m_numberOfPeriods, m_samplingFrequency);
+}
+
+void ChunkedExporter::cancel()
+{
+    m_cancelRequested.storeRelease(1);
+}
+
+void ChunkedExporter::run()
+{
+    emit exportFinished(exportSamples());
+}
+
+bool ChunkedExporter::exportSamples()
+{
+    SWG_PERF_SCOPE("ChunkedExporter::exportSamples");
+    SWG_TRACE_SCOPE("ChunkedExporter::exportSamples");
+
+    QFile file(m_fileName);
+    if (!SampleExporter::openFile(file, m_fileName))
+        return false;
+
+    // The header goes first. The WAVE header needs the number of samples, which is known beforehand
+    qint64 totalSamples = sampleCount();
+    bool isText = (m_fileFormat == CsvFile || m_fileFormat == TsvFile);
+    char separator = (m_fileFormat == CsvFile) ? ',' : '\t';
+    QByteArray header;
+    if (isText)
+    {
+        header = SampleExporter::delimitedHeader(separator);
+    }
+    else if (m_fileFormat == WavFile)
+    {
+        header = SampleExporter::wavHeader(totalSamples, m_samplingFrequency, m_sampleFormat);
+    }
+    else if (m_fileFormat == NativeFile)
+    {
+        WaveFile::Parameters parameters;
+        parameters.amplitude = m_amplitude;
+        parameters.oscillationFrequency = m_oscillationFrequency;
+        parameters.initialDelay = m_initialDelay;
+        parameters.numberOfPeriods = m_numberOfPeriods;
+        parameters.samplingFrequency = m_samplingFrequency;
+        parameters.attenuationFactor = m_attenuationFactor;
+        header = WaveFile::header(parameters);
+    }
+    bool success = !(m_fileFormat == WavFile && header.isEmpty()) && file.write(header) == header.size();
+
+    // Generate and encode each chunk while the writer writes the previous one. The chunks of the
+    // exporter are the same size as the chunks of waveform files, which are summarized for the index
+    int bytesPerSample = isText ? SampleExporter::MaxDelimitedLineLength
+                       : (m_fileFormat == NativeFile) ? WaveFile::BytesPerSample
+                       : SampleConverter::bytesPerSample(m_sampleFormat);
+    QVector<WaveFile::ChunkSummary> chunks;
+    qint64 offset = header.size();
+    ChunkWriter writer(&file, ChunkSize * bytesPerSample);
+    writer.start();
+    SampleConverter converter(m_sampleFormat, qAbs(m_amplitude), m_dither);
+    QVector<double> times(ChunkSize);
+    QVector<double> elongations(ChunkSize);
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    for (qint64 first = 0; success && first < totalSamples; first += ChunkSize)
+    {
+        if (m_cancelRequested.loadAcquire() != 0)
+        {
+            success = false;
+            break;
+        }
+
+        int count = (int)qMin((qint64)ChunkSize, totalSamples - first);
+        generateChunk(first, count, times.data(), elongations.data());
+        char *buffer = writer.acquireBuffer();
+        if (buffer == NULL)
+        {
+            success = false;
+            break;
+        }
+        int bytes;
+        {
+            SWG_TRACE_SCOPE_ARG("ChunkedExporter::encodeChunk", count);
+            if (isText)
+            {
+                bytes = SampleExporter::formatDelimited(times.constData(), elongations.constData(), count, separator, buffer);
+            }
+            else if (m_fileFormat == NativeFile)
+            {
+                WaveFile::ChunkSummary summary;
+                summary.offset = offset;
+                bytes = WaveFile::encodeChunk(times.constData(), elongations.constData(), count, buffer, summary);
+                chunks.append(summary);
+                offset += bytes;
+            }
+            else
+            {
+                bytes = converter.convert(elongations.constData(), count, buffer);
+            }
+        }
+        writer.releaseBuffer(bytes);
+
+        if (progressTimer.elapsed() >= ProgressInterval)
+        {
+            emit progressChanged(first + count, totalSamples);
+            progressTimer.restart();
+        }
+    }
+    success = writer.finish() && success;
+
+    // Chunks of WAVE files have an even size, and waveform files end with their index
+    if (success && m_fileFormat == WavFile && ((totalSamples * bytesPerSample) & 1))
+        success = file.write("\0", 1) == 1;
+    if (success && m_fileFormat == NativeFile)
+    {
+        QByteArray index = WaveFile::index(chunks, offset);
+        success = file.write(index) == index.size();
+    }
+    success = file.flush() && success;
+    file.close();
+
+    if (success)
+        emit progressChanged(totalSamples, totalSamples);
+    else if (m_fileName != "-")
+        QFile::remove(m_fileName);
+    return success;
+}
+
+void ChunkedExporter::generateChunk(qint64 first, int count, double *times, double *elongations) const
+{
+    SWG_TRACE_SCOPE_ARG("ChunkedExporter::generateChunk", count);
+
+    double angularFrequency = 2 * M_PI * m_oscillationFrequency;
+    double initialPhase = qDegreesToRadians(m_initialDelay);
+    for (int i = 0; i < count; ++i)
+    {
+        double t = (first + i) / m_samplingFrequency;
+        times[i] = t;
+        elongations[i] = SinusoidalEquation::elongation(m_amplitude, angularFrequency, initialPhase, m_attenuationFactor, t);
+    }
+}
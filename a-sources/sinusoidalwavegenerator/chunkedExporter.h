@@ -0,0 +1,168 @@
+#ifndef CHUNKEDEXPORTER_H
+#define CHUNKEDEXPORTER_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QThread>
+#include "sampleExporter.h"
+#include "waveFile.h"
+
+/**
+ * @brief Thread that generates a sinusoidal wave in chunks and writes it to a file as it goes.
+ *
+ * The wave is never held in memory as a whole, so it can be as long as the disk allows and is not
+ * limited by the memory limit of SinusoidalEquation. Each chunk is generated and formatted (or
+ * converted) into one of two output buffers while a writer thread writes the other one to the file,
+ * so computing and writing overlap and the memory used stays the same whatever the length.
+ *
+ * The time of each sample is computed from its index instead of being accumulated, so it can differ
+ * from the solved equation in the last digits, and the number of samples is known before starting.
+ */
+class ChunkedExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Format of the exported file.
+     */
+    enum FileFormat
+    {
+        CsvFile,    ///< Comma separated time and elongation
+        TsvFile,    ///< Tab separated time and elongation
+        RawFile,    ///< Raw little-endian elongation, without header
+        WavFile,    ///< Mono RIFF WAVE elongation
+        NativeFile  ///< Waveform file with the parameters and an index of the chunks, see WaveFile
+    };
+
+    /**
+     * @brief Constructor.
+     * @param parent Parent object.
+     */
+    ChunkedExporter(QObject *parent = 0);
+    /**
+     * @brief Destructor. Cancels the export and waits for the thread.
+     */
+    ~ChunkedExporter();
+
+    /**
+     * @brief Sets the parameters of the wave to export. Same meaning as in SinusoidalEquation.
+     * @param amplitude Amplitude of the wave.
+     * @param oscillationFrequency Oscillation frequency of the wave, in hertz.
+     * @param initialDelay Initial delay of the wave, in degrees.
+     * @param numberOfPeriods Number of periods of the wave.
+     * @param samplingFrequency Sampling frequency of the wave, in hertz.
+     * @param attenuationFactor Attenuation factor of the wave, in units per second.
+     */
+    void setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor);
+    /**
+     * @brief Sets the file to export to.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @param fileFormat Format of the file.
+     * @param sampleFormat Sample format of raw and WAV files. Integers take the amplitude as full scale.
+     * @param dither Whether to add TPDF dither when quantizing to integer formats.
+     */
+    void setOutput(const QString &fileName, FileFormat fileFormat, SampleFormat sampleFormat = Float32, bool dither = false);
+    /**
+     * @brief Gets the number of samples of the wave.
+     * @return Number of samples.
+     */
+    qint64 sampleCount() const;
+    /**
+     * @brief Exports the wave in the calling thread, blocking until it is written, failed or cancelled.
+     * A file that is not completely written is removed.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    bool exportSamples();
+
+public slots:
+    /**
+     * @brief Stops the export before the next chunk. Can be called from any thread.
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Signal emitted periodically while exporting.
+     * @param writtenSamples Samples generated so far.
+     * @param totalSamples Samples of the wave.
+     */
+    void progressChanged(qint64 writtenSamples, qint64 totalSamples);
+    /**
+     * @brief Signal emitted when the export started with start() ends.
+     * @param success Whether the file is correctly written.
+     */
+    void exportFinished(bool success);
+
+protected:
+    /**
+     * @brief Exports the wave in the thread.
+     */
+    void run();
+
+private:
+    /**
+     * @brief Number of samples of each chunk, the same as in waveform files.
+     */
+    static const int ChunkSize = WaveFile::ChunkSize;
+    /**
+     * @brief Minimum interval between progress signals, in milliseconds.
+     */
+    static const int ProgressInterval = 100;
+
+    /**
+     * @brief Generates a chunk of samples.
+     * @param first Index of the first sample of the chunk.
+     * @param count Number of samples.
+     * @param times Output time of each sample, in seconds.
+     * @param elongations Output elongation of each sample.
+     */
+    void generateChunk(qint64 first, int count, double *times, double *elongations) const;
+
+    /**
+     * @brief Amplitude of the wave.
+     */
+    double m_amplitude;
+    /**
+     * @brief Oscillation frequency of the wave, in hertz.
+     */
+    double m_oscillationFrequency;
+    /**
+     * @brief Initial delay of the wave, in degrees.
+     */
+    double m_initialDelay;
+    /**
+     * @brief Number of periods of the wave.
+     */
+    int m_numberOfPeriods;
+    /**
+     * @brief Sampling frequency of the wave, in hertz.
+     */
+    double m_samplingFrequency;
+    /**
+     * @brief Attenuation factor of the wave, in units per second.
+     */
+    double m_attenuationFactor;
+    /**
+     * @brief Full path of the file, or '-' for the standard output.
+     */
+    QString m_fileName;
+    /**
+     * @brief Format of the file.
+     */
+    FileFormat m_fileFormat;
+    /**
+     * @brief Sample format of raw and WAV files.
+     */
+    SampleFormat m_sampleFormat;
+    /**
+     * @brief Whether TPDF dither is added when quantizing.
+     */
+    bool m_dither;
+    /**
+     * @brief Non-zero when the export has to stop.
+     */
+    QAtomicInt m_cancelRequested;
+};
+
+#endif // CHUNKEDEXPORTER_H
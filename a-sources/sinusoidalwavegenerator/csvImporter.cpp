@@ -0,0 +1,308 @@
+#include "csvImporter.h"
+#include <QFile>
+#include <QThread>
+#include <cstring>
+#include <limits>
+#include "doubleConversion.h"
+#include "perfCounters.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Thread that counts or parses the lines of one range of a file.
+     *
+     * Without output columns it counts the lines of its range; with them, it parses the samples.
+     */
+    class RangeParser : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param begin Start of the first line of the range.
+         * @param end End of the last line of the range.
+         * @param separator Separator of the fields of the file.
+         */
+        RangeParser(const char *begin, const char *end, char separator)
+            : m_begin(begin),
+              m_end(end),
+              m_separator(separator),
+              m_times(NULL),
+              m_elongations(NULL),
+              m_result(0)
+        {
+            // Name of the thread in traces
+            setObjectName("CSV parser");
+        }
+
+        /**
+         * @brief Sets where the samples of the range are parsed to.
+         * @param times Output times.
+         * @param elongations Output elongations.
+         */
+        void setOutput(double *times, double *elongations)
+        {
+            m_times = times;
+            m_elongations = elongations;
+        }
+        /**
+         * @brief Gets the number of lines counted or samples parsed by the last run.
+         * @return Number of lines or samples.
+         */
+        qint64 result() const { return m_result; }
+
+        /**
+         * @brief Counts or parses the range in the calling thread.
+         */
+        void process()
+        {
+            if (m_times == NULL)
+            {
+                m_result = CsvImporter::countLines(m_begin, m_end);
+            }
+            else
+            {
+                SWG_TRACE_SCOPE_ARG("CsvImporter::parseLines", (int)qMin((qint64)(m_end - m_begin), (qint64)std::numeric_limits<int>::max()));
+                m_result = CsvImporter::parseLines(m_begin, m_end, m_separator, m_times, m_elongations);
+            }
+        }
+
+    protected:
+        /**
+         * @brief Counts or parses the range.
+         */
+        void run()
+        {
+            process();
+        }
+
+    private:
+        /**
+         * @brief Start of the range.
+         */
+        const char *m_begin;
+        /**
+         * @brief End of the range.
+         */
+        const char *m_end;
+        /**
+         * @brief Separator of the fields of the file.
+         */
+        char m_separator;
+        /**
+         * @brief Output times, or NULL to count the lines.
+         */
+        double *m_times;
+        /**
+         * @brief Output elongations.
+         */
+        double *m_elongations;
+        /**
+         * @brief Number of lines counted or samples parsed.
+         */
+        qint64 m_result;
+    };
+
+    /**
+     * @brief Runs all the parsers and waits for them. The first one runs in the calling thread.
+     * @param parsers Parsers.
+     */
+    void processAll(const QVector<RangeParser *> &parsers)
+    {
+        for (int i = 1; i < parsers.size(); ++i)
+            parsers.at(i)->start();
+        parsers.at(0)->process();
+        for (int i = 1; i < parsers.size(); ++i)
+            parsers.at(i)->wait();
+    }
+
+    /**
+     * @brief Skips spaces, tabs and carriage returns.
+     * @param p Start of the text.
+     * @param end End of the text.
+     * @return First position that is not blank.
+     */
+    inline const char *skipBlanks(const char *p, const char *end)
+    {
+        while (p != end && (*p == ' ' || *p == '\t' || *p == '\r'))
+            ++p;
+        return p;
+    }
+
+    /**
+     * @brief Checks whether a number is followed by the end of its field.
+     * @param p Position after the number.
+     * @param end End of the line.
+     * @param separator Separator of the fields, or a space if they are only separated by blanks.
+     * @return true if the field ends there, or false if other characters follow the number.
+     */
+    inline bool isFieldEnd(const char *p, const char *end, char separator)
+    {
+        return p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == separator;
+    }
+
+    /**
+     * @brief Parses the time and elongation of a line.
+     * @param p Start of the line.
+     * @param end End of the line, without line feed.
+     * @param separator Separator of the fields, or a space if they are only separated by blanks.
+     * @param time Set to the time.
+     * @param elongation Set to the elongation.
+     * @return true if the line starts with two numbers, or false otherwise.
+     */
+    bool parseLine(const char *p, const char *end, char separator, double &time, double &elongation)
+    {
+        p = DoubleConversion::parse(skipBlanks(p, end), end, time);
+        if (p == NULL || !isFieldEnd(p, end, separator))
+            return false;
+
+        // The separator of the file, with optional blanks around it, or just blanks
+        p = skipBlanks(p, end);
+        if (separator != ' ')
+        {
+            if (p == end || *p != separator)
+                return false;
+            p = skipBlanks(p + 1, end);
+        }
+        p = DoubleConversion::parse(p, end, elongation);
+        return p != NULL && isFieldEnd(p, end, separator);
+    }
+}
+
+bool CsvImporter::read(const QString &fileName, QVector<double> &timeVector, QVector<double> &elongationVector, int threadCount)
+{
+    SWG_PERF_SCOPE("CsvImporter::read");
+    SWG_TRACE_SCOPE("CsvImporter::read");
+
+    timeVector.clear();
+    elongationVector.clear();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+        return false;
+    qint64 size = file.size();
+    uchar *mapping = file.map(0, size);
+    if (mapping == NULL)
+        return false;
+    const char *data = reinterpret_cast<const char *>(mapping);
+    const char *end = data + size;
+    char separator = detectSeparator(data, end);
+
+    // One range of whole lines per thread, unless the file is small
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    threadCount = (int)qMax((qint64)1, qMin((qint64)threadCount, size / MinBytesPerThread));
+    QVector<RangeParser *> parsers;
+    const char *begin = data;
+    for (int i = 1; i <= threadCount; ++i)
+    {
+        const char *rangeEnd = end;
+        if (i < threadCount)
+        {
+            rangeEnd = qMax(data + size / threadCount * i, begin);
+            const char *lineFeed = static_cast<const char *>(memchr(rangeEnd, '\n', end - rangeEnd));
+            rangeEnd = (lineFeed != NULL) ? lineFeed + 1 : end;
+        }
+        parsers.append(new RangeParser(begin, rangeEnd, separator));
+        begin = rangeEnd;
+    }
+
+    // Counting the lines first tells each range where its samples go
+    processAll(parsers);
+    QVector<qint64> lineCounts(parsers.size());
+    qint64 lines = 0;
+    for (int i = 0; i < parsers.size(); ++i)
+    {
+        lineCounts[i] = parsers.at(i)->result();
+        lines += lineCounts.at(i);
+    }
+
+    qint64 count = 0;
+    if (lines > 0 && lines <= std::numeric_limits<int>::max())
+    {
+        timeVector.resize((int)lines);
+        elongationVector.resize((int)lines);
+        double *times = timeVector.data();
+        double *elongations = elongationVector.data();
+        qint64 position = 0;
+        for (int i = 0; i < parsers.size(); ++i)
+        {
+            parsers.at(i)->setOutput(times + position, elongations + position);
+            position += lineCounts.at(i);
+        }
+        processAll(parsers);
+
+        // Close the gaps left by the skipped lines of each range
+        position = 0;
+        for (int i = 0; i < parsers.size(); ++i)
+        {
+            qint64 parsed = parsers.at(i)->result();
+            if (count != position)
+            {
+                memmove(times + count, times + position, parsed * sizeof(double));
+                memmove(elongations + count, elongations + position, parsed * sizeof(double));
+            }
+            count += parsed;
+            position += lineCounts.at(i);
+        }
+        timeVector.resize((int)count);
+        elongationVector.resize((int)count);
+    }
+
+    qDeleteAll(parsers);
+    file.unmap(mapping);
+    SWG_PERF_VALUE("CsvImporter::read samples", count);
+    return count > 0;
+}
+
+qint64 CsvImporter::countLines(const char *begin, const char *end)
+{
+    qint64 count = 0;
+    for (const char *p = begin; p != end; ++count)
+    {
+        const char *lineFeed = static_cast<const char *>(memchr(p, '\n', end - p));
+        p = (lineFeed != NULL) ? lineFeed + 1 : end;
+    }
+    return count;
+}
+
+char CsvImporter::detectSeparator(const char *begin, const char *end)
+{
+    // First line with content, either the header or the first samples
+    const char *p = begin;
+    const char *lineEnd = end;
+    while (p != end)
+    {
+        const char *lineFeed = static_cast<const char *>(memchr(p, '\n', end - p));
+        lineEnd = (lineFeed != NULL) ? lineFeed : end;
+        const char *content = skipBlanks(p, lineEnd);
+        if (content != lineEnd && *content != '#')
+            break;
+        p = (lineFeed != NULL) ? lineFeed + 1 : end;
+    }
+    if (p == end)
+        return ' ';
+
+    // Tabs separate the fields of TSV files, and semicolons those of files with decimal commas
+    if (memchr(p, '\t', lineEnd - p) != NULL)
+        return ' ';
+    if (memchr(p, ';', lineEnd - p) != NULL)
+        return ';';
+    if (memchr(p, ',', lineEnd - p) != NULL)
+        return ',';
+    return ' ';
+}
+
+qint64 CsvImporter::parseLines(const char *begin, const char *end, char separator, double *times, double *elongations)
+{
+    qint64 count = 0;
+    for (const char *p = begin; p != end; )
+    {
+        const char *lineFeed = static_cast<const char *>(memchr(p, '\n', end - p));
+        const char *lineEnd = (lineFeed != NULL) ? lineFeed : end;
+        if (parseLine(p, lineEnd, separator, times[count], elongations[count]))
+            ++count;
+        p = (lineFeed != NULL) ? lineFeed + 1 : end;
+    }
+    return count;
+}
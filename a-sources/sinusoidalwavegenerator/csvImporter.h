@@ -0,0 +1,67 @@
+#ifndef CSVIMPORTER_H
+#define CSVIMPORTER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Reads the samples of delimited text files (CSV, TSV) in parallel.
+ *
+ * The file is memory-mapped and split at line boundaries into one range per thread. The lines of
+ * each range are counted first, so that every thread knows where its samples go, and then parsed
+ * with DoubleConversion::parse straight into the columns of the result, without intermediate
+ * strings or vectors.
+ */
+class CsvImporter
+{
+public:
+    /**
+     * @brief Reads the time and elongation columns of a delimited text file.
+     *
+     * Each line holds the time and the elongation, separated by a comma, a semicolon or blanks;
+     * further columns are ignored. The separator is detected once for the whole file, see
+     * detectSeparator, so that a decimal comma is never taken for a separator. Lines that do not
+     * start with two numbers separated by it, such as headers, comments or blank lines, are skipped.
+     * @param fileName Full path of the file.
+     * @param timeVector Set to the times.
+     * @param elongationVector Set to the elongations.
+     * @param threadCount Number of threads, or 0 to use one per core for large files.
+     * @return true if the file is read and has samples, or false otherwise.
+     */
+    static bool read(const QString &fileName, QVector<double> &timeVector, QVector<double> &elongationVector, int threadCount = 0);
+
+    /**
+     * @brief Counts the lines of a range of text, including a last one without line feed.
+     * @param begin Start of the text.
+     * @param end End of the text.
+     * @return Number of lines.
+     */
+    static qint64 countLines(const char *begin, const char *end);
+    /**
+     * @brief Detects the separator of the fields of a file from its first line that is not blank nor
+     * a comment (the header or the first samples): blanks if it has a tab, or else a semicolon, or
+     * else a comma, or else blanks.
+     * @param begin Start of the text.
+     * @param end End of the text.
+     * @return Separator, or a space if the fields are only separated by blanks.
+     */
+    static char detectSeparator(const char *begin, const char *end);
+    /**
+     * @brief Parses the samples of a range of whole lines.
+     * @param begin Start of the first line.
+     * @param end End of the last line.
+     * @param separator Separator of the fields, or a space if they are only separated by blanks.
+     * @param times Output times, room for countLines(begin, end) values.
+     * @param elongations Output elongations, room for countLines(begin, end) values.
+     * @return Number of samples parsed, less than the number of lines if some are skipped.
+     */
+    static qint64 parseLines(const char *begin, const char *end, char separator, double *times, double *elongations);
+
+private:
+    /**
+     * @brief Minimum size of the range parsed by each thread, in bytes.
+     */
+    static const int MinBytesPerThread = 1 << 20;
+};
+
+#endif // CSVIMPORTER_H
@@ -0,0 +1,563 @@
+#include "doubleConversion.h"
+#include <QByteArray>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+
+namespace
+{
+    /**
+     * @brief Floating point number with a 64-bit significand, f * 2^e, as used by Grisu.
+     */
+    struct DiyFp
+    {
+        DiyFp() : f(0), e(0) {}
+        DiyFp(quint64 f, int e) : f(f), e(e) {}
+
+        /**
+         * @brief Significand.
+         */
+        quint64 f;
+        /**
+         * @brief Binary exponent.
+         */
+        int e;
+    };
+
+    /**
+     * @brief Normalized power of ten, 10^k = f * 2^e.
+     */
+    struct CachedPower
+    {
+        /**
+         * @brief Significand, with its highest bit set.
+         */
+        quint64 f;
+        /**
+         * @brief Binary exponent.
+         */
+        int e;
+    };
+
+    /**
+     * @brief Bits of the significand of a double, without the hidden bit.
+     */
+    const int SignificandSize = 52;
+    /**
+     * @brief Bias of the exponent of a double, including the size of the significand.
+     */
+    const int ExponentBias = 0x3FF + SignificandSize;
+    /**
+     * @brief Hidden bit of a normal double.
+     */
+    const quint64 HiddenBit = Q_UINT64_C(1) << SignificandSize;
+    /**
+     * @brief Mask of the significand of a double.
+     */
+    const quint64 SignificandMask = HiddenBit - 1;
+
+    /**
+     * @brief Powers of ten that fit in 32 bits.
+     */
+    const quint32 Pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+    /**
+     * @brief Powers of ten from 10^-348 to 10^340 in steps of 8, rounded to 64-bit significands.
+     */
+    const CachedPower CachedPowers[] =
+    {
+        { Q_UINT64_C(0xfa8fd5a0081c0288), -1220 }, { Q_UINT64_C(0xbaaee17fa23ebf76), -1193 }, { Q_UINT64_C(0x8b16fb203055ac76), -1166 },
+        { Q_UINT64_C(0xcf42894a5dce35ea), -1140 }, { Q_UINT64_C(0x9a6bb0aa55653b2d), -1113 }, { Q_UINT64_C(0xe61acf033d1a45df), -1087 },
+        { Q_UINT64_C(0xab70fe17c79ac6ca), -1060 }, { Q_UINT64_C(0xff77b1fcbebcdc4f), -1034 }, { Q_UINT64_C(0xbe5691ef416bd60c), -1007 },
+        { Q_UINT64_C(0x8dd01fad907ffc3c), -980 }, { Q_UINT64_C(0xd3515c2831559a83), -954 }, { Q_UINT64_C(0x9d71ac8fada6c9b5), -927 },
+        { Q_UINT64_C(0xea9c227723ee8bcb), -901 }, { Q_UINT64_C(0xaecc49914078536d), -874 }, { Q_UINT64_C(0x823c12795db6ce57), -847 },
+        { Q_UINT64_C(0xc21094364dfb5637), -821 }, { Q_UINT64_C(0x9096ea6f3848984f), -794 }, { Q_UINT64_C(0xd77485cb25823ac7), -768 },
+        { Q_UINT64_C(0xa086cfcd97bf97f4), -741 }, { Q_UINT64_C(0xef340a98172aace5), -715 }, { Q_UINT64_C(0xb23867fb2a35b28e), -688 },
+        { Q_UINT64_C(0x84c8d4dfd2c63f3b), -661 }, { Q_UINT64_C(0xc5dd44271ad3cdba), -635 }, { Q_UINT64_C(0x936b9fcebb25c996), -608 },
+        { Q_UINT64_C(0xdbac6c247d62a584), -582 }, { Q_UINT64_C(0xa3ab66580d5fdaf6), -555 }, { Q_UINT64_C(0xf3e2f893dec3f126), -529 },
+        { Q_UINT64_C(0xb5b5ada8aaff80b8), -502 }, { Q_UINT64_C(0x87625f056c7c4a8b), -475 }, { Q_UINT64_C(0xc9bcff6034c13053), -449 },
+        { Q_UINT64_C(0x964e858c91ba2655), -422 }, { Q_UINT64_C(0xdff9772470297ebd), -396 }, { Q_UINT64_C(0xa6dfbd9fb8e5b88f), -369 },
+        { Q_UINT64_C(0xf8a95fcf88747d94), -343 }, { Q_UINT64_C(0xb94470938fa89bcf), -316 }, { Q_UINT64_C(0x8a08f0f8bf0f156b), -289 },
+        { Q_UINT64_C(0xcdb02555653131b6), -263 }, { Q_UINT64_C(0x993fe2c6d07b7fac), -236 }, { Q_UINT64_C(0xe45c10c42a2b3b06), -210 },
+        { Q_UINT64_C(0xaa242499697392d3), -183 }, { Q_UINT64_C(0xfd87b5f28300ca0e), -157 }, { Q_UINT64_C(0xbce5086492111aeb), -130 },
+        { Q_UINT64_C(0x8cbccc096f5088cc), -103 }, { Q_UINT64_C(0xd1b71758e219652c), -77 }, { Q_UINT64_C(0x9c40000000000000), -50 },
+        { Q_UINT64_C(0xe8d4a51000000000), -24 }, { Q_UINT64_C(0xad78ebc5ac620000), 3 }, { Q_UINT64_C(0x813f3978f8940984), 30 },
+        { Q_UINT64_C(0xc097ce7bc90715b3), 56 }, { Q_UINT64_C(0x8f7e32ce7bea5c70), 83 }, { Q_UINT64_C(0xd5d238a4abe98068), 109 },
+        { Q_UINT64_C(0x9f4f2726179a2245), 136 }, { Q_UINT64_C(0xed63a231d4c4fb27), 162 }, { Q_UINT64_C(0xb0de65388cc8ada8), 189 },
+        { Q_UINT64_C(0x83c7088e1aab65db), 216 }, { Q_UINT64_C(0xc45d1df942711d9a), 242 }, { Q_UINT64_C(0x924d692ca61be758), 269 },
+        { Q_UINT64_C(0xda01ee641a708dea), 295 }, { Q_UINT64_C(0xa26da3999aef774a), 322 }, { Q_UINT64_C(0xf209787bb47d6b85), 348 },
+        { Q_UINT64_C(0xb454e4a179dd1877), 375 }, { Q_UINT64_C(0x865b86925b9bc5c2), 402 }, { Q_UINT64_C(0xc83553c5c8965d3d), 428 },
+        { Q_UINT64_C(0x952ab45cfa97a0b3), 455 }, { Q_UINT64_C(0xde469fbd99a05fe3), 481 }, { Q_UINT64_C(0xa59bc234db398c25), 508 },
+        { Q_UINT64_C(0xf6c69a72a3989f5c), 534 }, { Q_UINT64_C(0xb7dcbf5354e9bece), 561 }, { Q_UINT64_C(0x88fcf317f22241e2), 588 },
+        { Q_UINT64_C(0xcc20ce9bd35c78a5), 614 }, { Q_UINT64_C(0x98165af37b2153df), 641 }, { Q_UINT64_C(0xe2a0b5dc971f303a), 667 },
+        { Q_UINT64_C(0xa8d9d1535ce3b396), 694 }, { Q_UINT64_C(0xfb9b7cd9a4a7443c), 720 }, { Q_UINT64_C(0xbb764c4ca7a44410), 747 },
+        { Q_UINT64_C(0x8bab8eefb6409c1a), 774 }, { Q_UINT64_C(0xd01fef10a657842c), 800 }, { Q_UINT64_C(0x9b10a4e5e9913129), 827 },
+        { Q_UINT64_C(0xe7109bfba19c0c9d), 853 }, { Q_UINT64_C(0xac2820d9623bf429), 880 }, { Q_UINT64_C(0x80444b5e7aa7cf85), 907 },
+        { Q_UINT64_C(0xbf21e44003acdd2d), 933 }, { Q_UINT64_C(0x8e679c2f5e44ff8f), 960 }, { Q_UINT64_C(0xd433179d9c8cb841), 986 },
+        { Q_UINT64_C(0x9e19db92b4e31ba9), 1013 }, { Q_UINT64_C(0xeb96bf6ebadf77d9), 1039 }, { Q_UINT64_C(0xaf87023b9bf0ee6b), 1066 }
+    };
+
+    /**
+     * @brief Multiplies two numbers, keeping the upper 64 bits of the product rounded.
+     */
+    DiyFp multiply(const DiyFp &a, const DiyFp &b)
+    {
+        const quint64 mask32 = Q_UINT64_C(0xFFFFFFFF);
+        quint64 aHigh = a.f >> 32;
+        quint64 aLow = a.f & mask32;
+        quint64 bHigh = b.f >> 32;
+        quint64 bLow = b.f & mask32;
+        quint64 highHigh = aHigh * bHigh;
+        quint64 highLow = aHigh * bLow;
+        quint64 lowHigh = aLow * bHigh;
+        quint64 lowLow = aLow * bLow;
+        quint64 middle = (lowLow >> 32) + (highLow & mask32) + (lowHigh & mask32) + (Q_UINT64_C(1) << 31);
+        return DiyFp(highHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32), a.e + b.e + 64);
+    }
+
+    /**
+     * @brief Shifts a number until the highest bit of its significand is set.
+     */
+    DiyFp normalize(DiyFp v)
+    {
+        while (!(v.f & (Q_UINT64_C(1) << 63)))
+        {
+            v.f <<= 1;
+            --v.e;
+        }
+        return v;
+    }
+
+    /**
+     * @brief Splits a positive double and calculates the boundaries of the values that round to it.
+     * @param value Finite positive value.
+     * @param v Value.
+     * @param minus Lower boundary, with the same exponent as the upper one.
+     * @param plus Upper boundary, normalized.
+     */
+    void boundaries(double value, DiyFp &v, DiyFp &minus, DiyFp &plus)
+    {
+        quint64 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        int biasedExponent = (int)(bits >> SignificandSize);
+        quint64 significand = bits & SignificandMask;
+        if (biasedExponent != 0)
+            v = DiyFp(significand + HiddenBit, biasedExponent - ExponentBias);
+        else
+            v = DiyFp(significand, 1 - ExponentBias);
+
+        plus = DiyFp((v.f << 1) + 1, v.e - 1);
+        while (!(plus.f & (HiddenBit << 1)))
+        {
+            plus.f <<= 1;
+            --plus.e;
+        }
+        plus.f <<= 64 - SignificandSize - 2;
+        plus.e -= 64 - SignificandSize - 2;
+
+        // The lower boundary is closer at powers of two, where the exponent changes
+        if (v.f == HiddenBit)
+            minus = DiyFp((v.f << 2) - 1, v.e - 2);
+        else
+            minus = DiyFp((v.f << 1) - 1, v.e - 1);
+        minus.f <<= minus.e - plus.e;
+        minus.e = plus.e;
+    }
+
+    /**
+     * @brief Gets a cached power of ten that brings a binary exponent into the range used to generate digits.
+     * @param e Binary exponent of the upper boundary.
+     * @param k Decimal exponent that must be added to the digits generated.
+     * @return Power of ten, 10^-k.
+     */
+    DiyFp cachedPower(int e, int &k)
+    {
+        double estimate = (-61 - e) * 0.30102999566398114 + 347;
+        int exponent = (int)estimate;
+        if (estimate - exponent > 0.0)
+            ++exponent;
+        int index = (exponent >> 3) + 1;
+        k = -(-348 + (index << 3));
+        return DiyFp(CachedPowers[index].f, CachedPowers[index].e);
+    }
+
+    /**
+     * @brief Moves the last digit towards the exact value while it stays inside the rounding interval.
+     */
+    void round(char *digits, int length, quint64 delta, quint64 rest, quint64 tenKappa, quint64 distance)
+    {
+        while (rest < distance && delta - rest >= tenKappa &&
+               (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+        {
+            --digits[length - 1];
+            rest += tenKappa;
+        }
+    }
+
+    /**
+     * @brief Gets the number of decimal digits of an integer.
+     */
+    int digitCount(quint32 n)
+    {
+        int count = 1;
+        while (count < 10 && n >= Pow10[count])
+            ++count;
+        return count;
+    }
+
+    /**
+     * @brief Generates the shortest digits of the scaled upper boundary that stay inside the rounding interval.
+     * @param w Scaled value.
+     * @param plus Scaled upper boundary.
+     * @param delta Width of the scaled rounding interval.
+     * @param digits Output digits.
+     * @param length Number of digits generated.
+     * @param k Decimal exponent, updated with the digits not generated.
+     */
+    void generateDigits(const DiyFp &w, const DiyFp &plus, quint64 delta, char *digits, int &length, int &k)
+    {
+        const DiyFp one(Q_UINT64_C(1) << -plus.e, plus.e);
+        quint64 distance = plus.f - w.f;
+        quint32 integral = (quint32)(plus.f >> -one.e);
+        quint64 fractional = plus.f & (one.f - 1);
+        int kappa = digitCount(integral);
+        length = 0;
+
+        // Digits of the integral part
+        while (kappa > 0)
+        {
+            // Constant divisors, which compile to multiplications
+            quint32 digit;
+            switch (kappa)
+            {
+            case 10: digit = integral / 1000000000; integral %= 1000000000; break;
+            case 9: digit = integral / 100000000; integral %= 100000000; break;
+            case 8: digit = integral / 10000000; integral %= 10000000; break;
+            case 7: digit = integral / 1000000; integral %= 1000000; break;
+            case 6: digit = integral / 100000; integral %= 100000; break;
+            case 5: digit = integral / 10000; integral %= 10000; break;
+            case 4: digit = integral / 1000; integral %= 1000; break;
+            case 3: digit = integral / 100; integral %= 100; break;
+            case 2: digit = integral / 10; integral %= 10; break;
+            default: digit = integral; integral = 0; break;
+            }
+            if (digit != 0 || length != 0)
+                digits[length++] = (char)('0' + digit);
+            --kappa;
+            quint64 rest = ((quint64)integral << -one.e) + fractional;
+            if (rest <= delta)
+            {
+                k += kappa;
+                round(digits, length, delta, rest, (quint64)Pow10[kappa] << -one.e, distance);
+                return;
+            }
+        }
+
+        // Digits of the fractional part
+        for (;;)
+        {
+            fractional *= 10;
+            delta *= 10;
+            char digit = (char)(fractional >> -one.e);
+            if (digit != 0 || length != 0)
+                digits[length++] = (char)('0' + digit);
+            fractional &= one.f - 1;
+            --kappa;
+            if (fractional < delta)
+            {
+                k += kappa;
+                int index = -kappa;
+                round(digits, length, delta, fractional, one.f, distance * (index < 10 ? Pow10[index] : 0));
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Writes a decimal exponent.
+     * @return Number of characters written.
+     */
+    int writeExponent(int exponent, char *buffer)
+    {
+        char *p = buffer;
+        if (exponent < 0)
+        {
+            *p++ = '-';
+            exponent = -exponent;
+        }
+        if (exponent >= 100)
+        {
+            *p++ = (char)('0' + exponent / 100);
+            exponent %= 100;
+            *p++ = (char)('0' + exponent / 10);
+        }
+        else if (exponent >= 10)
+        {
+            *p++ = (char)('0' + exponent / 10);
+        }
+        *p++ = (char)('0' + exponent % 10);
+        return (int)(p - buffer);
+    }
+
+    /**
+     * @brief Places the decimal point in the digits, or adds an exponent if it is far from them.
+     * @param buffer Digits, with room for the whole text.
+     * @param length Number of digits.
+     * @param k Decimal exponent of the last digit.
+     * @return Number of characters of the text.
+     */
+    int format(char *buffer, int length, int k)
+    {
+        int pointPosition = length + k;
+        if (k >= 0 && pointPosition <= 21)
+        {
+            // Integer: 1234e2 -> 123400
+            memset(buffer + length, '0', k);
+            return pointPosition;
+        }
+        if (pointPosition > 0 && pointPosition <= 21)
+        {
+            // Point inside the digits: 1234e-2 -> 12.34
+            memmove(buffer + pointPosition + 1, buffer + pointPosition, length - pointPosition);
+            buffer[pointPosition] = '.';
+            return length + 1;
+        }
+        if (pointPosition > -6 && pointPosition <= 0)
+        {
+            // Point before the digits: 1234e-6 -> 0.001234
+            int offset = 2 - pointPosition;
+            memmove(buffer + offset, buffer, length);
+            buffer[0] = '0';
+            buffer[1] = '.';
+            memset(buffer + 2, '0', offset - 2);
+            return length + offset;
+        }
+        if (length == 1)
+        {
+            // One digit with exponent: 1e30
+            buffer[1] = 'e';
+            return 2 + writeExponent(pointPosition - 1, buffer + 2);
+        }
+        // Several digits with exponent: 1234e30 -> 1.234e33
+        memmove(buffer + 2, buffer + 1, length - 1);
+        buffer[1] = '.';
+        buffer[length + 1] = 'e';
+        return length + 2 + writeExponent(pointPosition - 1, buffer + length + 2);
+    }
+
+    /**
+     * @brief Maximum number of decimal digits accumulated exactly in a 64-bit significand.
+     */
+    const int MaxSignificandDigits = 19;
+
+    /**
+     * @brief Powers of ten that are exact doubles.
+     */
+    const double ExactPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+#if LDBL_MANT_DIG >= 64
+    /**
+     * @brief Powers of ten that are exact long doubles with a 64-bit significand.
+     */
+    const long double ExactLongPow10[] = { 1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+                                           1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L,
+                                           1e26L, 1e27L };
+#endif
+
+    /**
+     * @brief Checks whether a character is a decimal digit.
+     * @param c Character.
+     * @return true if it is a digit, or false otherwise.
+     */
+    inline bool isDigit(char c)
+    {
+        return (unsigned)(c - '0') < 10u;
+    }
+
+    /**
+     * @brief Calculates significand * 10^exponent correctly rounded, when it can be done quickly.
+     *
+     * If both factors are exact doubles a single multiplication or division rounds correctly
+     * (Clinger's fast path). With 64-bit long doubles, 19 digits and larger exponents are exact
+     * too, and the extended result only rounds wrongly to double when it is exactly halfway
+     * between two doubles, which is detected.
+     * @param significand Decimal significand.
+     * @param exponent Decimal exponent.
+     * @param value Set to the value, if calculated.
+     * @return true if calculated, or false if a slower exact conversion is needed.
+     */
+    bool fastPath(quint64 significand, int exponent, double &value)
+    {
+        if (significand == 0)
+        {
+            value = 0.0;
+            return true;
+        }
+        if (significand <= (Q_UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double d = (double)significand;
+            value = (exponent < 0) ? d / ExactPow10[-exponent] : d * ExactPow10[exponent];
+            return true;
+        }
+#if LDBL_MANT_DIG >= 64
+        if (exponent >= -27 && exponent <= 27)
+        {
+            long double extended = (long double)significand;
+            extended = (exponent < 0) ? extended / ExactLongPow10[-exponent] : extended * ExactLongPow10[exponent];
+            int binaryExponent;
+            quint64 bits = (quint64)std::ldexp(std::frexp(extended, &binaryExponent), 64);
+            if ((bits & 0x7FF) == 0x400)
+                return false;
+            value = (double)extended;
+            return true;
+        }
+#endif
+        return false;
+    }
+}
+
+int DoubleConversion::toShortest(double value, char *buffer)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char *p = buffer;
+    if ((bits & ~(Q_UINT64_C(1) << 63)) > (Q_UINT64_C(0x7FF) << SignificandSize))
+    {
+        memcpy(p, "nan", 3);
+        return 3;
+    }
+    if (bits >> 63)
+    {
+        *p++ = '-';
+        bits &= ~(Q_UINT64_C(1) << 63);
+        memcpy(&value, &bits, sizeof(bits));
+    }
+    if (value == 0.0)
+    {
+        *p++ = '0';
+        return (int)(p - buffer);
+    }
+    if (bits == (Q_UINT64_C(0x7FF) << SignificandSize))
+    {
+        memcpy(p, "inf", 3);
+        return (int)(p - buffer) + 3;
+    }
+
+    // Grisu2: scale the value and its boundaries by a cached power of ten so that the digits can
+    // be generated with 64-bit integers, and keep the shortest ones inside the rounding interval
+    DiyFp v;
+    DiyFp minus;
+    DiyFp plus;
+    boundaries(value, v, minus, plus);
+    int k = 0;
+    DiyFp power = cachedPower(plus.e, k);
+    DiyFp w = multiply(normalize(v), power);
+    DiyFp scaledPlus = multiply(plus, power);
+    DiyFp scaledMinus = multiply(minus, power);
+    ++scaledMinus.f;
+    --scaledPlus.f;
+    int length = 0;
+    generateDigits(w, scaledPlus, scaledPlus.f - scaledMinus.f, p, length, k);
+
+    return (int)(p - buffer) + format(p, length, k);
+}
+
+const char *DoubleConversion::parse(const char *begin, const char *end, double &value)
+{
+    const char *p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    // Special values, as written by toShortest
+    if (end - p >= 3 && (memcmp(p, "nan", 3) == 0 || memcmp(p, "inf", 3) == 0))
+    {
+        value = (*p == 'n') ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+        if (negative)
+            value = -value;
+        return p + 3;
+    }
+
+    // Significand: leading zeros are skipped, the first significant digits are accumulated and the
+    // rest only move the decimal point
+    quint64 significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool anyDigit = false;
+    for (; p != end && isDigit(*p); ++p)
+    {
+        anyDigit = true;
+        if (digits < MaxSignificandDigits)
+        {
+            significand = significand * 10 + (*p - '0');
+            digits += (significand != 0) ? 1 : 0;
+        }
+        else
+        {
+            truncated |= (*p != '0');
+            ++exponent;
+        }
+    }
+    if (p != end && *p == '.')
+    {
+        for (++p; p != end && isDigit(*p); ++p)
+        {
+            anyDigit = true;
+            if (digits < MaxSignificandDigits)
+            {
+                significand = significand * 10 + (*p - '0');
+                digits += (significand != 0) ? 1 : 0;
+                --exponent;
+            }
+            else
+            {
+                truncated |= (*p != '0');
+            }
+        }
+    }
+    if (!anyDigit)
+        return NULL;
+
+    // Exponent, only if digits follow the mark
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool negativeExponent = false;
+        if (q != end && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = (*q == '-');
+            ++q;
+        }
+        if (q != end && isDigit(*q))
+        {
+            int e = 0;
+            for (; q != end && isDigit(*q); ++q)
+            {
+                if (e < 100000)
+                    e = e * 10 + (*q - '0');
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    double result;
+    if (!truncated && fastPath(significand, exponent, result))
+    {
+        value = negative ? -result : result;
+        return p;
+    }
+
+    // Rare cases (more than 19 digits, extreme exponents, halfway results) use Qt's exact conversion,
+    // which is also independent of the locale
+    bool ok = false;
+    value = QByteArray::fromRawData(begin, (int)(p - begin)).toDouble(&ok);
+    return ok ? p : NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef DOUBLECONVERSION_H
+#define DOUBLECONVERSION_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Conversions between doubles and text that are independent of the locale and do not allocate.
+ */
+class DoubleConversion
+{
+public:
+    /**
+     * @brief Size of the buffer needed by toShortest, including room for any double.
+     */
+    static const int MaxLength = 32;
+
+    /**
+     * @brief Writes the shortest decimal representation that reads back as exactly the same double.
+     *
+     * Uses the Grisu2 algorithm, which always round-trips and gives the shortest digits for nearly
+     * all values (for the rest, one digit more). Numbers are written in fixed notation when the
+     * decimal point is close to the digits, and in exponent notation otherwise (1.5e-7). The
+     * decimal separator is always a dot. The text is not null-terminated.
+     * @param value Value to write.
+     * @param buffer Buffer of at least MaxLength characters.
+     * @return Number of characters written.
+     */
+    static int toShortest(double value, char *buffer);
+    /**
+     * @brief Reads a decimal number at the start of a text, correctly rounded to the nearest double.
+     *
+     * Accepts an optional sign, digits with an optional dot and an optional exponent, as well as
+     * "nan" and "inf" as written by toShortest. Numbers of up to 19 significant digits with moderate
+     * exponents, which include everything written by toShortest, are converted with integer and
+     * floating point arithmetic only; the rest fall back to an exact but slower conversion.
+     * @param begin Start of the text.
+     * @param end End of the text. The text does not need to be null-terminated.
+     * @param value Set to the value read.
+     * @return Position after the number, or NULL if the text does not start with a number.
+     */
+    static const char *parse(const char *begin, const char *end, double &value);
+};
+
+#endif // DOUBLECONVERSION_H
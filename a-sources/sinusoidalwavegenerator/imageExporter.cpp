@@ -0,0 +1,68 @@
+#include "imageExporter.h"
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+#include "perfCounters.h"
+#include "traceRecorder.h"
+
+
+ImageExporter::ImageExporter(QObject *parent)
+    : QThread(parent),
+      m_picture(),
+      m_size(),
+      m_scale(1.0),
+      m_fileName(),
+      m_format(),
+      m_quality(-1)
+{
+    // Name of the thread in traces
+    setObjectName("Image exporter");
+}
+
+ImageExporter::~ImageExporter()
+{
+    wait();
+}
+
+void ImageExporter::setPicture(const QPicture &picture, const QSize &size, double scale)
+{
+    m_picture = picture;
+    m_size = size;
+    m_scale = scale;
+}
+
+void ImageExporter::setOutput(const QString &fileName, const QByteArray &format, int quality)
+{
+    m_fileName = fileName;
+    m_format = format;
+    m_quality = quality;
+}
+
+void ImageExporter::run()
+{
+    emit exportFinished(exportImage());
+}
+
+bool ImageExporter::exportImage()
+{
+    SWG_PERF_SCOPE("ImageExporter::exportImage");
+    SWG_TRACE_SCOPE("ImageExporter::exportImage");
+
+    // Rasterize, the background is part of the drawing
+    QImage image(qRound(m_scale * m_size.width()), qRound(m_scale * m_size.height()), QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+        return false;
+    {
+        SWG_TRACE_SCOPE("ImageExporter::render");
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.scale(m_scale, m_scale);
+        painter.drawPicture(0, 0, m_picture);
+    }
+    emit renderingFinished();
+
+    SWG_TRACE_SCOPE("ImageExporter::encode");
+    QImageWriter writer(m_fileName, m_format);
+    writer.setQuality(m_quality);
+    return writer.write(image);
+}
@@ -0,0 +1,102 @@
+#ifndef IMAGEEXPORTER_H
+#define IMAGEEXPORTER_H
+
+#include <QByteArray>
+#include <QPicture>
+#include <QSize>
+#include <QString>
+#include <QThread>
+
+/**
+ * @brief Thread that renders a recorded drawing of a plot to an image and saves it to a file.
+ *
+ * A QCustomPlot is a widget and can only be drawn in the GUI thread, but drawing it into a QPicture
+ * only records the painter commands, which is much cheaper than rasterizing them. The recording is
+ * the snapshot of the plot: the thread replays it into a QImage, where the antialiased lines and
+ * scatters are rasterized, and encodes the image (zlib for PNG), so the GUI keeps responding.
+ */
+class ImageExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor.
+     * @param parent Parent object.
+     */
+    ImageExporter(QObject *parent = 0);
+    /**
+     * @brief Destructor. Waits for the thread.
+     */
+    ~ImageExporter();
+
+    /**
+     * @brief Sets the drawing to render.
+     * @param picture Recorded drawing, in logical pixels.
+     * @param size Size of the drawing, in logical pixels.
+     * @param scale Factor from logical pixels to pixels of the image.
+     */
+    void setPicture(const QPicture &picture, const QSize &size, double scale = 1.0);
+    /**
+     * @brief Sets the file to save to.
+     * @param fileName Full path of the file.
+     * @param format Image format, or empty to choose it from the suffix of the file.
+     * @param quality Quality of the image, from 0 to 100, or -1 for the default of the format.
+     */
+    void setOutput(const QString &fileName, const QByteArray &format = QByteArray(), int quality = -1);
+    /**
+     * @brief Gets the file the image is saved to.
+     * @return Full path of the file.
+     */
+    QString fileName() const { return m_fileName; }
+    /**
+     * @brief Renders and saves the image in the calling thread, blocking until it is written or failed.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    bool exportImage();
+
+signals:
+    /**
+     * @brief Signal emitted when the image is rendered, before encoding it.
+     */
+    void renderingFinished();
+    /**
+     * @brief Signal emitted when the export started with start() ends.
+     * @param success Whether the file is correctly written.
+     */
+    void exportFinished(bool success);
+
+protected:
+    /**
+     * @brief Renders and saves the image in the thread.
+     */
+    void run();
+
+private:
+    /**
+     * @brief Recorded drawing.
+     */
+    QPicture m_picture;
+    /**
+     * @brief Size of the drawing, in logical pixels.
+     */
+    QSize m_size;
+    /**
+     * @brief Factor from logical pixels to pixels of the image.
+     */
+    double m_scale;
+    /**
+     * @brief Full path of the file.
+     */
+    QString m_fileName;
+    /**
+     * @brief Image format, or empty to choose it from the suffix.
+     */
+    QByteArray m_format;
+    /**
+     * @brief Quality of the image, or -1 for the default.
+     */
+    int m_quality;
+};
+
+#endif // IMAGEEXPORTER_H
@@ -1,7 +1,486 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QSaveFile>
+#include <QTextStream>
+#include <cstring>
+#include "batchRenderer.h"
+#include "chunkedExporter.h"
 #include "mainWindow.h"
+#include "sampleExporter.h"
+#include "startupTiming.h"
+#include "sweepEngine.h"
+#include "sweepRunner.h"
+#include "vectorExporter.h"
+#include "waveFile.h"
 
 
+/**
+ * @brief Checks whether an argument is present in the command line, before it is parsed.
+ * @param argc Number of input arguments.
+ * @param argv Array of input arguments.
+ * @param name Name of the argument, including the dashes.
+ * @return true if the argument is present, alone or followed by '=value', or false otherwise.
+ */
+static bool hasArgument(int argc, char *argv[], const char *name)
+{
+    size_t length = strlen(name);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], name, length) == 0 && (argv[i][length] == '\0' || argv[i][length] == '='))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Draws an equation the same way as the PlotWindow and saves it to a PNG file, without showing it.
+ * @param equation Solved equation.
+ * @param fileName Full path of the file.
+ * @param width Width of the image, in pixels.
+ * @param height Height of the image, in pixels.
+ * @return true if the file is correctly saved, or false otherwise.
+ */
+static bool writePng(SinusoidalEquation &equation, const QString &fileName, int width, int height)
+{
+    QCustomPlot plot;
+    plot.addGraph();
+    BatchRenderer::applyStyle(&plot);
+    plot.graph(0)->setData(equation.timeVector(), equation.elongationVector());
+    plot.graph(0)->rescaleAxes();
+
+    return plot.savePng(fileName, width, height);
+}
+
+/**
+ * @brief Draws an equation the same way as the PlotWindow and saves it to a vector document, without showing it.
+ * @param equation Solved equation.
+ * @param fileName Full path of the file.
+ * @param format Format of the document.
+ * @param width Width of the document, in points.
+ * @param height Height of the document, in points.
+ * @param resolution Resolution the samples are decimated to, in dots per inch.
+ * @return true if the file is correctly saved, or false otherwise.
+ */
+static bool writeVector(SinusoidalEquation &equation, const QString &fileName, VectorExporter::Format format, int width, int height, int resolution)
+{
+    QCustomPlot plot;
+    plot.addGraph();
+    BatchRenderer::applyStyle(&plot);
+    plot.graph(0)->setData(equation.timeVector(), equation.elongationVector());
+    plot.graph(0)->rescaleAxes();
+
+    return VectorExporter::save(&plot, fileName, format, width, height, resolution);
+}
+
+/**
+ * @brief Exports the wave in chunks to each of the requested files, without solving it as a whole.
+ * @param exporter Exporter, with the wave parameters already set.
+ * @param targets File names with the format to write them in.
+ * @param sampleFormat Sample format of raw and WAV files.
+ * @param dither Whether to add TPDF dither when writing integer samples.
+ * @return true if all the files are correctly written, or false otherwise.
+ */
+static bool writeChunked(ChunkedExporter &exporter, const QList<QPair<QString, ChunkedExporter::FileFormat> > &targets, SampleFormat sampleFormat, bool dither)
+{
+    QTextStream err(stderr);
+    bool success = true;
+    for (int i = 0; i < targets.size(); ++i)
+    {
+        exporter.setOutput(targets.at(i).first, targets.at(i).second, sampleFormat, dither);
+        if (!exporter.exportSamples())
+        {
+            err << "Error trying to write samples to " << targets.at(i).first << endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+/**
+ * @brief Reads the values of a parameter of a sweep grid.
+ * @param text Comma separated list of values, or 'from:to:count' for evenly spaced values.
+ * @param values Set to the values.
+ * @return true if there is at least one value and all are valid, or false otherwise.
+ */
+static bool parseGridValues(const QString &text, QVector<double> &values)
+{
+    bool ok = true;
+    values.clear();
+    QStringList range = text.split(':');
+    if (range.size() == 3)
+    {
+        double from = range.at(0).toDouble(&ok);
+        bool valid = ok;
+        double to = range.at(1).toDouble(&ok);
+        valid = valid && ok;
+        int count = range.at(2).toInt(&ok);
+        valid = valid && ok && count > 0;
+        if (valid)
+            values = SweepEngine::range(from, to, count);
+        return valid;
+    }
+
+    QStringList list = text.split(',');
+    for (int i = 0; i < list.size() && ok; ++i)
+        values.append(list.at(i).toDouble(&ok));
+    return ok && !values.isEmpty();
+}
+
+/**
+ * @brief Runs the application without user interface: solves the equation given in the command line and exports it.
+ * @param app Application, already created.
+ * @return Exit code.
+ */
+static int runHeadless(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a sinusoidal wave and exports it without user interface.");
+    parser.addHelpOption();
+    QCommandLineOption headlessOption("headless", "Run without user interface.");
+    QCommandLineOption amplitudeOption("amplitude", "Amplitude of the wave.", "value", "1");
+    QCommandLineOption frequencyOption("frequency", "Oscillation frequency of the wave, in hertz.", "value", "100");
+    QCommandLineOption delayOption("delay", "Initial delay of the wave, in degrees.", "value", "0");
+    QCommandLineOption periodsOption("periods", "Number of periods of the wave.", "value", "1");
+    QCommandLineOption samplingFrequencyOption("sampling-frequency", "Sampling frequency of the wave, in hertz.", "value", "10000");
+    QCommandLineOption attenuationOption("attenuation", "Attenuation factor of the wave, in units per second.", "value", "0");
+    QCommandLineOption csvOption("csv", "Write the samples as CSV to the file, or to the standard output with '-'.", "file");
+    QCommandLineOption tsvOption("tsv", "Write the samples as TSV to the file, or to the standard output with '-'.", "file");
+    QCommandLineOption wavOption("wav", "Write the elongation as WAV audio to the file.", "file");
+    QCommandLineOption rawOption("raw", "Write the elongation as raw little-endian samples to the file, or to the standard output with '-'.", "file");
+    QCommandLineOption swgOption("swg", "Write the samples as a waveform file, with the parameters and an index of the chunks.", "file");
+    QCommandLineOption sampleFormatOption("sample-format", "Sample format of WAV and raw files: f32, f64, i16 or i24.", "format", "f32");
+    QCommandLineOption ditherOption("dither", "Add TPDF dither when writing integer samples.");
+    QCommandLineOption chunkedOption("chunked", "Generate the CSV, TSV, WAV, raw and waveform samples in chunks while writing them, "
+                                                "with constant memory and without memory limit.");
+    QCommandLineOption pngOption("png", "Save the graph as PNG to the file.", "file");
+    QCommandLineOption pdfOption("pdf", "Save the graph as PDF to the file.", "file");
+    QCommandLineOption svgOption("svg", "Save the graph as SVG to the file.", "file");
+    QCommandLineOption dpiOption("dpi", "Resolution the samples of PDF and SVG documents are decimated to, in dots per inch.", "dpi",
+                                 QString::number(VectorExporter::DefaultResolution));
+    QCommandLineOption widthOption("width", "Width of the PNG image, in pixels, or of the PDF and SVG documents, in points.", "pixels", "800");
+    QCommandLineOption heightOption("height", "Height of the PNG image, in pixels, or of the PDF and SVG documents, in points.", "pixels", "600");
+    QCommandLineOption sweepOption("sweep", "Render a sequence of PNG frames sweeping 'delay', 'frequency' or 'attenuation'.", "parameter");
+    QCommandLineOption sweepFromOption("sweep-from", "Value of the swept parameter in the first frame.", "value", "0");
+    QCommandLineOption sweepToOption("sweep-to", "Value of the swept parameter in the last frame.", "value", "360");
+    QCommandLineOption framesOption("frames", "Number of frames of the sweep.", "count", "100");
+    QCommandLineOption framesDirOption("frames-dir", "Directory of the frames of the sweep, named frame_0000.png onwards.", "directory", ".");
+    QCommandLineOption memoryLimitOption("memory-limit", "Maximum memory of the samples and of their graph, in megabytes, or 0 for no limit.", "megabytes",
+                                         QString::number(SinusoidalEquation::DefaultMemoryLimit / (1024 * 1024)));
+    QCommandLineOption memoryPolicyOption("memory-policy", "What to do over the memory limit: 'decimate' the samples or 'refuse' to solve.", "policy", "decimate");
+    QCommandLineOption summariesOption("summaries", "Solve every combination of the grid values and write a summary of each run as CSV "
+                                       "to the file, or to the standard output with '-'.", "file");
+    QCommandLineOption gridAmplitudeOption("grid-amplitude", "Amplitudes of the grid: comma separated values or from:to:count. "
+                                           "Defaults to the amplitude.", "values");
+    QCommandLineOption gridFrequencyOption("grid-frequency", "Oscillation frequencies of the grid, in hertz: comma separated values or "
+                                           "from:to:count. Defaults to the frequency.", "values");
+    QCommandLineOption gridDelayOption("grid-delay", "Initial delays of the grid, in degrees: comma separated values or from:to:count. "
+                                       "Defaults to the delay.", "values");
+    QCommandLineOption gridAttenuationOption("grid-attenuation", "Attenuation factors of the grid, in units per second: comma separated "
+                                             "values or from:to:count. Defaults to the attenuation.", "values");
+    QCommandLineOption gridFileOption("grid-file", "File of the grid, as written by the coordinator for the worker processes. Replaces "
+                                      "the grid values, the periods and the sampling frequency.", "file");
+    QCommandLineOption workersOption("workers", "Number of worker processes the grid is sharded across, or 0 to solve it in this process.",
+                                     "count", "0");
+    QCommandLineOption shardsOption("shards", "Number of shards of the grid, or 0 for four per worker process.", "count", "0");
+    QCommandLineOption shardDirOption("shard-dir", "Directory of the shard files, kept to resume the sweep or to share it with other nodes. "
+                                      "A temporary directory by default.", "directory");
+    QCommandLineOption shardOption("shard", "Solve only the shard i of n of the grid, as the worker processes do.", "i/n");
+    QCommandLineOption threadsOption("threads", "Number of threads solving the grid, or 0 for one per core.", "count", "0");
+    parser.addOption(headlessOption);
+    parser.addOption(amplitudeOption);
+    parser.addOption(frequencyOption);
+    parser.addOption(delayOption);
+    parser.addOption(periodsOption);
+    parser.addOption(samplingFrequencyOption);
+    parser.addOption(attenuationOption);
+    parser.addOption(csvOption);
+    parser.addOption(tsvOption);
+    parser.addOption(wavOption);
+    parser.addOption(rawOption);
+    parser.addOption(swgOption);
+    parser.addOption(sampleFormatOption);
+    parser.addOption(ditherOption);
+    parser.addOption(chunkedOption);
+    parser.addOption(pngOption);
+    parser.addOption(pdfOption);
+    parser.addOption(svgOption);
+    parser.addOption(dpiOption);
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.addOption(sweepOption);
+    parser.addOption(sweepFromOption);
+    parser.addOption(sweepToOption);
+    parser.addOption(framesOption);
+    parser.addOption(framesDirOption);
+    parser.addOption(memoryLimitOption);
+    parser.addOption(memoryPolicyOption);
+    parser.addOption(summariesOption);
+    parser.addOption(gridAmplitudeOption);
+    parser.addOption(gridFrequencyOption);
+    parser.addOption(gridDelayOption);
+    parser.addOption(gridAttenuationOption);
+    parser.addOption(gridFileOption);
+    parser.addOption(workersOption);
+    parser.addOption(shardsOption);
+    parser.addOption(shardDirOption);
+    parser.addOption(shardOption);
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    // Read and validate the wave parameters
+    bool ok = true;
+    bool valid = true;
+    double amplitude = parser.value(amplitudeOption).toDouble(&ok);
+    valid = valid && ok;
+    double frequency = parser.value(frequencyOption).toDouble(&ok);
+    valid = valid && ok && frequency > 0.0;
+    double delay = parser.value(delayOption).toDouble(&ok);
+    valid = valid && ok;
+    int periods = parser.value(periodsOption).toInt(&ok);
+    valid = valid && ok && periods >= 0;
+    double samplingFrequency = parser.value(samplingFrequencyOption).toDouble(&ok);
+    valid = valid && ok && samplingFrequency > 0.0;
+    double attenuation = parser.value(attenuationOption).toDouble(&ok);
+    valid = valid && ok;
+    int width = parser.value(widthOption).toInt(&ok);
+    valid = valid && ok && width > 0;
+    int height = parser.value(heightOption).toInt(&ok);
+    valid = valid && ok && height > 0;
+    int dpi = parser.value(dpiOption).toInt(&ok);
+    valid = valid && ok && dpi > 0;
+    qint64 memoryLimit = parser.value(memoryLimitOption).toLongLong(&ok);
+    valid = valid && ok && memoryLimit >= 0;
+    QString memoryPolicy = parser.value(memoryPolicyOption);
+    valid = valid && (memoryPolicy == "decimate" || memoryPolicy == "refuse");
+    QStringList sampleFormats = QStringList() << "f32" << "f64" << "i16" << "i24";
+    int sampleFormatIndex = sampleFormats.indexOf(parser.value(sampleFormatOption));
+    valid = valid && sampleFormatIndex >= 0;
+    QStringList sweptParameters = QStringList() << "delay" << "frequency" << "attenuation";
+    int sweptParameterIndex = sweptParameters.indexOf(parser.value(sweepOption));
+    valid = valid && (!parser.isSet(sweepOption) || sweptParameterIndex >= 0);
+    double sweepFrom = parser.value(sweepFromOption).toDouble(&ok);
+    valid = valid && ok;
+    double sweepTo = parser.value(sweepToOption).toDouble(&ok);
+    valid = valid && ok;
+    int frames = parser.value(framesOption).toInt(&ok);
+    valid = valid && ok && frames > 0;
+    if (!valid)
+    {
+        err << "Invalid wave parameters, image size, resolution, memory limit, sample format or sweep" << endl;
+        return 1;
+    }
+
+    // Summarize the runs of the grid, sharded across worker processes or in this process
+    if (parser.isSet(summariesOption))
+    {
+        SweepEngine::Grid grid;
+        grid.numberOfPeriods = periods;
+        grid.samplingFrequency = samplingFrequency;
+        if (parser.isSet(gridFileOption))
+        {
+            valid = SweepRunner::readGridFile(parser.value(gridFileOption), grid);
+        }
+        else
+        {
+            valid = parseGridValues(parser.value(parser.isSet(gridAmplitudeOption) ? gridAmplitudeOption : amplitudeOption), grid.amplitudes);
+            valid = valid && parseGridValues(parser.value(parser.isSet(gridFrequencyOption) ? gridFrequencyOption : frequencyOption), grid.oscillationFrequencies);
+            valid = valid && parseGridValues(parser.value(parser.isSet(gridDelayOption) ? gridDelayOption : delayOption), grid.initialDelays);
+            valid = valid && parseGridValues(parser.value(parser.isSet(gridAttenuationOption) ? gridAttenuationOption : attenuationOption), grid.attenuationFactors);
+        }
+        for (int i = 0; i < grid.oscillationFrequencies.size(); ++i)
+            valid = valid && grid.oscillationFrequencies.at(i) > 0.0;
+        int workers = parser.value(workersOption).toInt(&ok);
+        valid = valid && ok && workers >= 0;
+        int shards = parser.value(shardsOption).toInt(&ok);
+        valid = valid && ok && shards >= 0;
+        int threads = parser.value(threadsOption).toInt(&ok);
+        valid = valid && ok && threads >= 0;
+        int shard = 0;
+        int shardCount = 1;
+        if (parser.isSet(shardOption))
+        {
+            QStringList shardText = parser.value(shardOption).split('/');
+            valid = valid && shardText.size() == 2;
+            shard = shardText.value(0).toInt(&ok);
+            valid = valid && ok;
+            shardCount = shardText.value(1).toInt(&ok);
+            valid = valid && ok && shard >= 0 && shard < shardCount;
+        }
+        if (!valid)
+        {
+            err << "Invalid grid, workers, shards or threads" << endl;
+            return 1;
+        }
+
+        QString summariesFileName = parser.value(summariesOption);
+        if (!parser.isSet(shardOption) && workers > 0)
+        {
+            SweepRunner runner;
+            runner.setGrid(grid);
+            runner.setWorkers(workers, shards);
+            runner.setShardDirectory(parser.value(shardDirOption));
+            if (!runner.run(summariesFileName))
+            {
+                err << "Error trying to solve the shards of the grid or to save the summaries to " << summariesFileName << endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        SweepEngine engine;
+        engine.setGrid(grid);
+        qint64 first = 0;
+        qint64 count = 0;
+        SweepRunner::shardRange(engine.runCount(), shard, shardCount, first, count);
+        QVector<SweepEngine::Summary> summaries = engine.solve(first, count, threads);
+
+        // A shard has no header, and is saved to a temporary file of its own that replaces the shard
+        // atomically only when complete, so that the coordinator never takes a partial file for a
+        // solved shard, even with other nodes solving the same shard in a shared directory
+        bool saved = parser.isSet(shardOption) && summariesFileName != "-";
+        QSaveFile shardFile(summariesFileName);
+        QFile file(summariesFileName);
+        QIODevice *output = &shardFile;
+        bool opened = false;
+        if (saved)
+        {
+            opened = shardFile.open(QIODevice::WriteOnly);
+        }
+        else
+        {
+            opened = SampleExporter::openFile(file, summariesFileName);
+            output = &file;
+        }
+        QByteArray header = parser.isSet(shardOption) ? QByteArray() : SweepEngine::summaryHeader();
+        bool written = summaries.size() == count && opened && output->write(header) == header.size()
+                && engine.writeSummaries(output, summaries);
+        written = saved ? written && shardFile.commit() : written && file.flush();
+        if (!written)
+        {
+            err << "Error trying to save the summaries to " << summariesFileName << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Render the frames of the sweep, alone or along with the other targets
+    int exitCode = 0;
+    if (parser.isSet(sweepOption))
+    {
+        BatchRenderer renderer;
+        renderer.setParameters(amplitude, frequency, delay, periods, samplingFrequency, attenuation);
+        renderer.setSweep(sweptParameterIndex == 0 ? BatchRenderer::InitialDelay
+                          : sweptParameterIndex == 1 ? BatchRenderer::OscillationFrequency
+                          : BatchRenderer::AttenuationFactor, sweepFrom, sweepTo, frames);
+        renderer.setOutput(parser.value(framesDirOption), "frame", width, height);
+        if (!renderer.render())
+        {
+            err << "Error trying to save the frames of the sweep to " << parser.value(framesDirOption) << endl;
+            exitCode = 1;
+        }
+        if (renderer.decimatedFrameCount() > 0)
+            err << renderer.decimatedFrameCount() << " frames are decimated up to 1:" << renderer.maxDecimationFactor() << " to fit in the memory limit" << endl;
+        if (!parser.isSet(csvOption) && !parser.isSet(tsvOption) && !parser.isSet(wavOption) && !parser.isSet(rawOption) && !parser.isSet(swgOption)
+                && !parser.isSet(pngOption) && !parser.isSet(pdfOption) && !parser.isSet(svgOption))
+            return exitCode;
+    }
+
+    // Export the samples in chunks if requested, or as CSV to the standard output if there is no target
+    QString csvFileName = parser.isSet(csvOption) ? parser.value(csvOption) : QString();
+    bool drawGraph = parser.isSet(pngOption) || parser.isSet(pdfOption) || parser.isSet(svgOption);
+    if (csvFileName.isEmpty() && !parser.isSet(tsvOption) && !parser.isSet(wavOption) && !parser.isSet(rawOption) && !parser.isSet(swgOption) && !drawGraph)
+        csvFileName = "-";
+    SampleFormat sampleFormat = (SampleFormat)sampleFormatIndex;
+    bool chunked = parser.isSet(chunkedOption);
+    if (chunked)
+    {
+        QList<QPair<QString, ChunkedExporter::FileFormat> > targets;
+        if (!csvFileName.isEmpty())
+            targets << qMakePair(csvFileName, ChunkedExporter::CsvFile);
+        if (parser.isSet(tsvOption))
+            targets << qMakePair(parser.value(tsvOption), ChunkedExporter::TsvFile);
+        if (parser.isSet(wavOption))
+            targets << qMakePair(parser.value(wavOption), ChunkedExporter::WavFile);
+        if (parser.isSet(rawOption))
+            targets << qMakePair(parser.value(rawOption), ChunkedExporter::RawFile);
+        if (parser.isSet(swgOption))
+            targets << qMakePair(parser.value(swgOption), ChunkedExporter::NativeFile);
+
+        ChunkedExporter exporter;
+        exporter.setParameters(amplitude, frequency, delay, periods, samplingFrequency, attenuation);
+        if (!writeChunked(exporter, targets, sampleFormat, parser.isSet(ditherOption)))
+            exitCode = 1;
+        if (!drawGraph)
+            return exitCode;
+    }
+
+    // Solve the equation once with all the parameters, within the memory limit
+    SinusoidalEquation equation;
+    equation.setMemoryLimitPolicy(memoryPolicy == "refuse" ? SinusoidalEquation::RefuseSolve : SinusoidalEquation::DecimateSolve);
+    equation.setMemoryLimit(memoryLimit * 1024 * 1024);
+    equation.setParameters(amplitude, frequency, delay, periods, samplingFrequency, attenuation);
+    qint64 requiredMemory = equation.requiredMemory();
+    if (memoryLimit > 0 && requiredMemory > memoryLimit * 1024 * 1024)
+    {
+        if (memoryPolicy == "refuse")
+        {
+            err << "The samples need " << requiredMemory / (1024 * 1024) << " MB, over the memory limit" << endl;
+            return 1;
+        }
+        err << "The samples are decimated 1:" << equation.decimationFactor() << " to fit in the memory limit" << endl;
+    }
+
+    // Export it to the requested targets, unless already exported in chunks
+    if (chunked)
+        csvFileName.clear();
+    if (!csvFileName.isEmpty() && !SampleExporter::writeDelimited(csvFileName, equation.timeVector(), equation.elongationVector(), ','))
+    {
+        err << "Error trying to write samples to " << csvFileName << endl;
+        exitCode = 1;
+    }
+    if (!chunked && parser.isSet(tsvOption) && !SampleExporter::writeDelimited(parser.value(tsvOption), equation.timeVector(), equation.elongationVector(), '\t'))
+    {
+        err << "Error trying to write samples to " << parser.value(tsvOption) << endl;
+        exitCode = 1;
+    }
+    double fullScale = qAbs(amplitude);
+    if (!chunked && parser.isSet(wavOption) && !SampleExporter::writeWav(parser.value(wavOption), equation.elongationVector(), equation.samplingFrequency() / equation.decimationFactor(),
+                                                             sampleFormat, fullScale, parser.isSet(ditherOption)))
+    {
+        err << "Error trying to write samples to " << parser.value(wavOption) << endl;
+        exitCode = 1;
+    }
+    if (!chunked && parser.isSet(rawOption) && !SampleExporter::writeRaw(parser.value(rawOption), equation.elongationVector(), sampleFormat, fullScale, parser.isSet(ditherOption)))
+    {
+        err << "Error trying to write samples to " << parser.value(rawOption) << endl;
+        exitCode = 1;
+    }
+    if (!chunked && parser.isSet(swgOption) && !WaveFile::write(parser.value(swgOption), WaveFile::parameters(&equation), equation.timeVector(), equation.elongationVector()))
+    {
+        err << "Error trying to write samples to " << parser.value(swgOption) << endl;
+        exitCode = 1;
+    }
+    if (parser.isSet(pngOption) && !writePng(equation, parser.value(pngOption), width, height))
+    {
+        err << "Error trying to save graph to " << parser.value(pngOption) << endl;
+        exitCode = 1;
+    }
+    if (parser.isSet(pdfOption) && !writeVector(equation, parser.value(pdfOption), VectorExporter::PdfFile, width, height, dpi))
+    {
+        err << "Error trying to save graph to " << parser.value(pdfOption) << endl;
+        exitCode = 1;
+    }
+    if (parser.isSet(svgOption) && !writeVector(equation, parser.value(svgOption), VectorExporter::SvgFile, width, height, dpi))
+    {
+        err << "Error trying to save graph to " << parser.value(svgOption) << endl;
+        exitCode = 1;
+    }
+
+    return exitCode;
+}
+
 /**
  * @brief Application entry point.
  * @param argc Number of input arguments.
@@ -10,20 +489,51 @@
  */
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // Headless mode: no splash screen nor windows. Widgets are only needed to draw graphs,
+    // and then they are rendered with the offscreen platform so no display is required
+    if (hasArgument(argc, argv, "--headless"))
+    {
+        if (hasArgument(argc, argv, "--png") || hasArgument(argc, argv, "--pdf") || hasArgument(argc, argv, "--svg") || hasArgument(argc, argv, "--sweep"))
+        {
+            if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            QApplication app(argc, argv);
+            return runHeadless(app);
+        }
 
-    // Open welcome screen
-    QPixmap pixmap(":/logos/resources/Innerspec_full.png");
-    QSplashScreen splash(pixmap);
-    splash.show();
+        QCoreApplication app(argc, argv);
+        return runHeadless(app);
+    }
 
-    // Wait 3 seconds and hide the splash screen
-    QThread::sleep(3);
-    splash.hide();
+    StartupTiming::start();
+    QApplication app(argc, argv);
+    StartupTiming::setEnabled(hasArgument(argc, argv, "--startup-timing") || !qgetenv("SWG_STARTUP_TIMING").isEmpty());
+    StartupTiming::mark("application created");
+
+    // Open welcome screen, unless disabled. It is only shown while the main window is being
+    // created, and closed as soon as the main window is visible
+    QSplashScreen *splash = NULL;
+    if (!hasArgument(argc, argv, "--no-splash"))
+    {
+        QPixmap pixmap(":/logos/resources/Innerspec_full.png");
+        splash = new QSplashScreen(pixmap);
+        splash->show();
+        app.processEvents();
+        StartupTiming::mark("splash screen shown");
+    }
 
     // Open wain window
     MainWindow w;
+    StartupTiming::mark("main window created");
+    StartupTiming::watchFirstFrame(&w);
     w.show();
+    StartupTiming::mark("main window shown");
+
+    if (splash != NULL)
+    {
+        splash->finish(&w);
+        delete splash;
+    }
 
     return app.exec();
 }
@@ -1,33 +1,82 @@
 #include <cfloat>
 #include <qcustomplot.h>
+#include <QFileInfo>
+#include <QInputDialog>
 #include <QtMath>
 #include "mainWindow.h"
+#include "mappedWaveform.h"
+#include "sampleExporter.h"
+#include "startupTiming.h"
+#include "traceRecorder.h"
+#include "vectorExporter.h"
+#include "waveFile.h"
 #include "ui_mainWindow.h"
 
 
+/**
+ * @brief Formats a number of bytes for the status bar.
+ * @param bytes Number of bytes.
+ * @return Size in kilobytes, megabytes or gigabytes.
+ */
+static QString formatBytes(qint64 bytes)
+{
+    if (bytes < 1024 * 1024)
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    if (bytes < 1024 * 1024 * 1024)
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    return QString("%1 GB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+}
+
 MainWindow::MainWindow() :
     m_ui(new Ui::MainWindow),
     m_equation(NULL),
-    m_plotWindow(NULL)
+    m_plotWindow(NULL),
+    m_streamStatisticsLabel(NULL),
+    m_waveStatisticsLabel(NULL),
+    m_memoryUsageLabel(NULL),
+    m_memoryTimer(NULL),
+    m_chunkedExporter(NULL),
+    m_exportProgress(NULL),
+    m_imageExporter(NULL)
 {
     m_ui->setupUi(this);
+    StartupTiming::mark("main window user interface set up");
 
     // Set the initial position
     this->move(0,0);
 
     // Create the equation with default values
     m_equation = new SinusoidalEquation();
+    StartupTiming::mark("default equation solved");
 
     // Create the PlotWindow to draw the initial equation
     m_plotWindow = new PlotWindow(this);
     m_plotWindow->move(this->width(), 0);
+    StartupTiming::mark("plot window created");
+
+    // Create the label that shows the performance counters of the stream
+    m_streamStatisticsLabel = new QLabel(this);
+    m_streamStatisticsLabel->hide();
+    m_ui->statusBar->addPermanentWidget(m_streamStatisticsLabel);
+
+    // Create the label that shows the statistics of the solved wave
+    m_waveStatisticsLabel = new QLabel(this);
+    m_ui->statusBar->addPermanentWidget(m_waveStatisticsLabel);
+
+    // Create the label that shows the memory usage, refreshed periodically
+    m_memoryUsageLabel = new QLabel(this);
+    m_ui->statusBar->addPermanentWidget(m_memoryUsageLabel);
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(MemoryRefreshInterval);
 
     // Configure the form's controls
     configureFormControls();
 
     // Load the equation in the widget and draw it
     m_plotWindow->loadEquation(m_equation);
+    refreshWaveStatistics();
     m_plotWindow->show();
+    StartupTiming::mark("equation loaded in plot window");
 
     // Refresh form controls with the current values
     refreshFormValues();
@@ -51,14 +100,34 @@ MainWindow::MainWindow() :
     connect(m_ui->spinBox_dataWindowHeight, SIGNAL(valueChanged(int)), this, SLOT(onDataWindowSizeChanged()));
     connect(m_ui->comboBox_lineStyle, SIGNAL(currentIndexChanged(int)), this, SLOT(onSelectedLineStyleChanged(int)));
     connect(m_ui->pushButton_color, SIGNAL(clicked(bool)), this, SLOT(onSelectColorClicked()));
+    //  - Trigger controls
+    connect(m_ui->groupBox_trigger, SIGNAL(toggled(bool)), m_ui->widget_trigger, SLOT(setVisible(bool)));
+    connect(m_ui->groupBox_trigger, SIGNAL(toggled(bool)), this, SLOT(onTriggerSettingsChanged()));
+    connect(m_ui->comboBox_triggerSlope, SIGNAL(currentIndexChanged(int)), this, SLOT(onTriggerSettingsChanged()));
+    connect(m_ui->doubleSpinBox_triggerLevel, SIGNAL(valueChanged(double)), this, SLOT(onTriggerSettingsChanged()));
+    connect(m_ui->doubleSpinBox_triggerHoldoff, SIGNAL(valueChanged(double)), this, SLOT(onTriggerSettingsChanged()));
+    connect(m_ui->spinBox_preTrigger, SIGNAL(valueChanged(int)), this, SLOT(onTriggerSettingsChanged()));
     //  - Menu bar controls
+    connect(m_ui->action_openWaveFile, SIGNAL(triggered(bool)), this, SLOT(onOpenWaveFileTriggered()));
+    connect(m_ui->action_importRecording, SIGNAL(triggered(bool)), this, SLOT(onImportRecordingTriggered()));
+    connect(m_ui->action_closeRecording, SIGNAL(triggered(bool)), this, SLOT(onCloseRecordingTriggered()));
     connect(m_ui->action_saveToFile, SIGNAL(triggered(bool)), this, SLOT(onSaveToFileTriggered()));
+    connect(m_ui->action_exportFullWave, SIGNAL(triggered(bool)), this, SLOT(onExportFullWaveTriggered()));
+    connect(m_ui->action_recordTrace, SIGNAL(toggled(bool)), this, SLOT(onRecordTraceToggled(bool)));
     connect(m_ui->action_advancedFeatures, SIGNAL(toggled(bool)), m_ui->groupBox_advancedFeatures, SLOT(setChecked(bool)));
     connect(m_ui->action_visualizationFeatures, SIGNAL(toggled(bool)), m_ui->groupBox_visualizationFeatures, SLOT(setChecked(bool)));
+    connect(m_ui->action_streamingMode, SIGNAL(toggled(bool)), this, SLOT(onStreamingModeToggled(bool)));
+    connect(m_ui->action_performanceHud, SIGNAL(toggled(bool)), m_plotWindow, SLOT(setPerformanceHudVisible(bool)));
     // 2) SinusoidalEquation signals
     connect(m_equation, SIGNAL(equationChanged()), this, SLOT(onEquationChanged()));
+    connect(m_equation, SIGNAL(solveRefused(qint64)), this, SLOT(onSolveRefused(qint64)));
     // 3) PlotWindow signals
     connect(m_plotWindow, SIGNAL(widgetResized(QSize)), this, SLOT(onPlotWindowResized(QSize)));
+    connect(m_plotWindow, SIGNAL(streamStatisticsChanged(double,int,qint64,int)), this, SLOT(onStreamStatisticsChanged(double,int,qint64,int)));
+    // 4) Timers
+    connect(m_memoryTimer, SIGNAL(timeout()), this, SLOT(refreshMemoryUsage()));
+    refreshMemoryUsage();
+    m_memoryTimer->start();
 }
 
 MainWindow::~MainWindow()
@@ -95,22 +164,308 @@ void MainWindow::onSelectColorClicked()
         m_plotWindow->changeColor(color);
 }
 
+void MainWindow::onOpenWaveFileTriggered()
+{
+    // Open a file dialog to let the user choose the file to show
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open waveform file"), QCoreApplication::applicationDirPath(), tr("Waveform files (*.swg)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (m_plotWindow->loadWaveFile(fileName))
+        m_ui->statusBar->showMessage("Showing " + fileName, 5000);
+    else
+        m_ui->statusBar->showMessage("Error trying to open " + fileName, 5000);
+}
+
+void MainWindow::onImportRecordingTriggered()
+{
+    // Open a file dialog to let the user choose the recording
+    QString selectedFilter;
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Import recording"), QCoreApplication::applicationDirPath(),
+                                                    tr("Waveform files (*.swg);;WAV audio (*.wav);;CSV files (*.csv *.tsv *.txt);;Raw samples (*.raw)"), &selectedFilter);
+    if (fileName.isEmpty())
+        return;
+
+    // Integer samples take the amplitude as full scale, as when they are exported
+    double fullScale = qAbs(m_equation->amplitude());
+    MappedWaveform *waveform = new MappedWaveform();
+    bool opened;
+    if (selectedFilter.contains("*.swg"))
+    {
+        opened = waveform->openWaveFile(fileName);
+    }
+    else if (selectedFilter.contains("*.wav"))
+    {
+        opened = waveform->openWav(fileName, fullScale);
+    }
+    else if (selectedFilter.contains("*.csv"))
+    {
+        opened = waveform->openCsv(fileName);
+    }
+    else
+    {
+        // Raw files do not say how they were sampled
+        SampleFormat format;
+        bool dither;
+        bool accepted = false;
+        if (!askSampleFormat(format, dither, false))
+        {
+            delete waveform;
+            return;
+        }
+        double samplingFrequency = QInputDialog::getDouble(this, tr("Import recording"), tr("Sampling frequency [Hz]:"),
+                                                           m_equation->samplingFrequency(), 0.001, DBL_MAX, 3, &accepted);
+        if (!accepted)
+        {
+            delete waveform;
+            return;
+        }
+        opened = waveform->openRaw(fileName, format, samplingFrequency, fullScale);
+    }
+
+    if (!opened)
+    {
+        delete waveform;
+        m_ui->statusBar->showMessage("Error trying to import " + fileName, 5000);
+        return;
+    }
+    m_plotWindow->showRecording(waveform, QFileInfo(fileName).fileName());
+    m_ui->action_closeRecording->setEnabled(true);
+    m_ui->statusBar->showMessage("Recording imported from " + fileName, 5000);
+}
+
+void MainWindow::onCloseRecordingTriggered()
+{
+    m_plotWindow->closeRecording();
+    m_ui->action_closeRecording->setEnabled(false);
+}
+
 void MainWindow::onSaveToFileTriggered()
 {
     // Open a file dialog to let the user choose where to save the file
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save to file"), QCoreApplication::applicationDirPath(), tr("Images (*.png)"));
-    if (!fileName.isEmpty())
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save to file"), QCoreApplication::applicationDirPath(),
+                                                    tr("Images (*.png);;PDF documents (*.pdf);;SVG images (*.svg);;"
+                                                       "Comma separated values (*.csv);;Tab separated values (*.tsv);;"
+                                                       "WAV audio (*.wav);;Raw samples (*.raw);;Waveform files (*.swg)"), &selectedFilter);
+    if (fileName.isEmpty())
+        return;
+
+    // Waveform files keep the parameters of the equation along with the samples
+    if (selectedFilter.contains("*.swg"))
+    {
+        if (WaveFile::write(fileName, WaveFile::parameters(m_equation), m_equation->timeVector(), m_equation->elongationVector()))
+            m_ui->statusBar->showMessage("Samples saved to " + fileName, 5000);
+        else
+            m_ui->statusBar->showMessage("Error trying to save samples to " + fileName, 5000);
+        return;
+    }
+
+    // Binary exports: ask for the sample format. Integers take the amplitude as full scale, and
+    // WAV files the sampling frequency of the samples, which is lower if they were decimated
+    if (selectedFilter.contains("*.wav") || selectedFilter.contains("*.raw"))
+    {
+        SampleFormat format;
+        bool dither;
+        if (!askSampleFormat(format, dither))
+            return;
+        double fullScale = qAbs(m_equation->amplitude());
+        bool saved;
+        if (selectedFilter.contains("*.wav"))
+            saved = SampleExporter::writeWav(fileName, m_equation->elongationVector(), m_equation->samplingFrequency() / m_equation->decimationFactor(), format, fullScale, dither);
+        else
+            saved = SampleExporter::writeRaw(fileName, m_equation->elongationVector(), format, fullScale, dither);
+        if (saved)
+            m_ui->statusBar->showMessage("Samples saved to " + fileName, 5000);
+        else
+            m_ui->statusBar->showMessage("Error trying to save samples to " + fileName, 5000);
+        return;
+    }
+
+    // The samples are exported straight from the equation, the image is drawn by the plot
+    if (selectedFilter.contains("*.csv") || selectedFilter.contains("*.tsv"))
+    {
+        char separator = selectedFilter.contains("*.csv") ? ',' : '\t';
+        if (SampleExporter::writeDelimited(fileName, m_equation->timeVector(), m_equation->elongationVector(), separator))
+            m_ui->statusBar->showMessage("Samples saved to " + fileName, 5000);
+        else
+            m_ui->statusBar->showMessage("Error trying to save samples to " + fileName, 5000);
+    }
+    else if (selectedFilter.contains("*.pdf") || selectedFilter.contains("*.svg"))
     {
-        if (m_plotWindow->saveToFile(fileName))
+        // Dense graphs are decimated to the resolution the document is meant for
+        bool accepted = false;
+        int resolution = QInputDialog::getInt(this, tr("Save to file"), tr("Resolution [dpi]:"), VectorExporter::DefaultResolution, 72, 4800, 1, &accepted);
+        if (!accepted)
+            return;
+        VectorExporter::Format format = selectedFilter.contains("*.pdf") ? VectorExporter::PdfFile : VectorExporter::SvgFile;
+        if (m_plotWindow->saveToVectorFile(fileName, format, resolution))
             m_ui->statusBar->showMessage("Graph saved to " + fileName, 5000);
         else
             m_ui->statusBar->showMessage("Error trying to save graph to " + fileName, 5000);
     }
+    else
+    {
+        // The image is rendered and encoded in a thread, the status bar tells when it is done
+        if (m_imageExporter != NULL)
+        {
+            m_ui->statusBar->showMessage("The graph is still being saved to " + m_imageExporter->fileName(), 5000);
+            return;
+        }
+        m_imageExporter = new ImageExporter(this);
+        connect(m_imageExporter, SIGNAL(renderingFinished()), this, SLOT(onImageRenderingFinished()));
+        connect(m_imageExporter, SIGNAL(exportFinished(bool)), this, SLOT(onImageExportFinished(bool)));
+        m_ui->statusBar->showMessage("Rendering graph to " + fileName + "...");
+        m_plotWindow->saveToFileInBackground(fileName, m_imageExporter);
+    }
+}
+
+void MainWindow::onExportFullWaveTriggered()
+{
+    // Only one export at a time
+    if (m_chunkedExporter != NULL)
+        return;
+
+    // Open a file dialog to let the user choose where to export the wave
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export full wave"), QCoreApplication::applicationDirPath(),
+                                                    tr("Comma separated values (*.csv);;Tab separated values (*.tsv);;"
+                                                       "WAV audio (*.wav);;Raw samples (*.raw);;Waveform files (*.swg)"), &selectedFilter);
+    if (fileName.isEmpty())
+        return;
+
+    ChunkedExporter::FileFormat fileFormat = selectedFilter.contains("*.csv") ? ChunkedExporter::CsvFile
+                                           : selectedFilter.contains("*.tsv") ? ChunkedExporter::TsvFile
+                                           : selectedFilter.contains("*.wav") ? ChunkedExporter::WavFile
+                                           : selectedFilter.contains("*.swg") ? ChunkedExporter::NativeFile
+                                           : ChunkedExporter::RawFile;
+    SampleFormat sampleFormat = Float32;
+    bool dither = false;
+    if ((fileFormat == ChunkedExporter::WavFile || fileFormat == ChunkedExporter::RawFile) && !askSampleFormat(sampleFormat, dither))
+        return;
+
+    // The wave is generated at the full sampling frequency in a thread, whatever the memory limit
+    m_chunkedExporter = new ChunkedExporter(this);
+    m_chunkedExporter->setParameters(m_equation->amplitude(), m_equation->oscillationFrequency(), m_equation->initialDelay(),
+                                     m_equation->numberOfPeriods(), m_equation->samplingFrequency(), m_equation->attenuationFactor());
+    m_chunkedExporter->setOutput(fileName, fileFormat, sampleFormat, dither);
+    m_exportProgress = new QProgressDialog(tr("Exporting %1 samples...").arg(m_chunkedExporter->sampleCount()), tr("Cancel"), 0, 1000, this);
+    m_exportProgress->setWindowTitle(tr("Export full wave"));
+    m_exportProgress->setAutoClose(false);
+    m_exportProgress->setAutoReset(false);
+    m_exportProgress->show();
+    connect(m_exportProgress, SIGNAL(canceled()), m_chunkedExporter, SLOT(cancel()));
+    connect(m_chunkedExporter, SIGNAL(progressChanged(qint64,qint64)), this, SLOT(onExportProgressChanged(qint64,qint64)));
+    connect(m_chunkedExporter, SIGNAL(exportFinished(bool)), this, SLOT(onExportFinished(bool)));
+    m_chunkedExporter->start();
+}
+
+void MainWindow::onExportProgressChanged(qint64 writtenSamples, qint64 totalSamples)
+{
+    if (m_exportProgress != NULL && totalSamples > 0)
+        m_exportProgress->setValue((int)(writtenSamples * 1000.0 / totalSamples));
+}
+
+void MainWindow::onExportFinished(bool success)
+{
+    if (m_chunkedExporter == NULL)
+        return;
+
+    if (success)
+        m_ui->statusBar->showMessage("Full wave exported", 5000);
+    else if (m_exportProgress->wasCanceled())
+        m_ui->statusBar->showMessage("Export of the full wave cancelled", 5000);
+    else
+        m_ui->statusBar->showMessage("Error trying to export the full wave", 5000);
+
+    // The thread has already finished its work, so it can be deleted when it returns
+    m_exportProgress->deleteLater();
+    m_exportProgress = NULL;
+    m_chunkedExporter->deleteLater();
+    m_chunkedExporter = NULL;
+}
+
+void MainWindow::onImageRenderingFinished()
+{
+    if (m_imageExporter != NULL)
+        m_ui->statusBar->showMessage("Encoding graph to " + m_imageExporter->fileName() + "...");
+}
+
+void MainWindow::onImageExportFinished(bool success)
+{
+    if (m_imageExporter == NULL)
+        return;
+
+    if (success)
+        m_ui->statusBar->showMessage("Graph saved to " + m_imageExporter->fileName(), 5000);
+    else
+        m_ui->statusBar->showMessage("Error trying to save graph to " + m_imageExporter->fileName(), 5000);
+
+    // The thread has already finished its work, so it can be deleted when it returns
+    m_imageExporter->deleteLater();
+    m_imageExporter = NULL;
+}
+
+void MainWindow::onRecordTraceToggled(bool checked)
+{
+    if (checked)
+    {
+        TraceRecorder::start();
+        m_ui->statusBar->showMessage("Recording trace...");
+        return;
+    }
+
+    // Open a file dialog to let the user choose where to save the trace
+    TraceRecorder::stop();
+    m_ui->statusBar->clearMessage();
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save trace"), QCoreApplication::applicationDirPath(), tr("Chrome traces (*.json)"));
+    if (!fileName.isEmpty())
+    {
+        if (TraceRecorder::writeChromeTrace(fileName))
+            m_ui->statusBar->showMessage("Trace saved to " + fileName, 5000);
+        else
+            m_ui->statusBar->showMessage("Error trying to save trace to " + fileName, 5000);
+    }
 }
 
 void MainWindow::onEquationChanged()
 {
+    SWG_TRACE_SCOPE("MainWindow::onEquationChanged");
     m_plotWindow->loadEquation(m_equation);
+    refreshWaveStatistics();
+    refreshMemoryUsage();
+}
+
+void MainWindow::onSolveRefused(qint64 requiredMemory)
+{
+    m_ui->statusBar->showMessage(QString("Equation not solved: it needs %1, over the limit of %2")
+                                 .arg(formatBytes(requiredMemory))
+                                 .arg(formatBytes(m_equation->memoryLimit())), 5000);
+}
+
+void MainWindow::refreshWaveStatistics()
+{
+    m_waveStatisticsLabel->setText(QString("Peak %1 | RMS %2 | mean %3 | energy %4 | crest %5 | zero crossings %6")
+                                   .arg(m_equation->peak(), 0, 'g', 4)
+                                   .arg(m_equation->rms(), 0, 'g', 4)
+                                   .arg(m_equation->mean(), 0, 'g', 4)
+                                   .arg(m_equation->energy(), 0, 'g', 4)
+                                   .arg(m_equation->crestFactor(), 0, 'f', 2)
+                                   .arg(m_equation->zeroCrossings()));
+}
+
+void MainWindow::refreshMemoryUsage()
+{
+    PlotWindow::MemoryUsage usage = m_plotWindow->memoryUsage();
+    QString text = QString("Memory: equation %1 | graphs %2 | stream %3 | buffers %4 | labels %5")
+            .arg(formatBytes(m_equation->memoryUsage()))
+            .arg(formatBytes(usage.graphData))
+            .arg(formatBytes(usage.streamBuffers))
+            .arg(formatBytes(usage.paintBuffers))
+            .arg(formatBytes(usage.labelCaches));
+    if (m_equation->decimationFactor() > 1)
+        text += QString(" | decimated 1:%1").arg(m_equation->decimationFactor());
+    m_memoryUsageLabel->setText(text);
 }
 
 void MainWindow::onPlotWindowResized(const QSize &size)
@@ -120,9 +475,52 @@ void MainWindow::onPlotWindowResized(const QSize &size)
     m_ui->spinBox_dataWindowHeight->setValue(size.height());
 }
 
+void MainWindow::onStreamingModeToggled(bool checked)
+{
+    if (checked)
+    {
+        m_plotWindow->startStreaming(m_equation);
+        m_streamStatisticsLabel->setText("Streaming...");
+        m_streamStatisticsLabel->show();
+    }
+    else
+    {
+        m_plotWindow->stopStreaming(m_equation);
+        m_streamStatisticsLabel->hide();
+    }
+}
+
+void MainWindow::onTriggerSettingsChanged()
+{
+    // Read new values from the user interface
+    bool enabled = m_ui->groupBox_trigger->isChecked();
+    TriggerEngine::Slope slope = (TriggerEngine::Slope)m_ui->comboBox_triggerSlope->itemData(m_ui->comboBox_triggerSlope->currentIndex()).toInt();
+    double level = m_ui->doubleSpinBox_triggerLevel->value();
+    double holdoff = m_ui->doubleSpinBox_triggerHoldoff->value() / 1000.0;
+    double preTriggerRatio = m_ui->spinBox_preTrigger->value() / 100.0;
+    m_plotWindow->configureTrigger(enabled, slope, level, holdoff, preTriggerRatio);
+}
+
+void MainWindow::onStreamStatisticsChanged(double samplesPerSecond, int queueDepth, qint64 droppedSamples, int droppedFrames)
+{
+    m_streamStatisticsLabel->setText(QString("%1 S/s | queue: %2 | dropped samples: %3 | dropped frames: %4")
+                                     .arg(samplesPerSecond, 0, 'f', 0)
+                                     .arg(queueDepth)
+                                     .arg(droppedSamples)
+                                     .arg(droppedFrames));
+}
+
 void MainWindow::closeEvent(QCloseEvent *)
 {
     // Clean tasks
+    m_memoryTimer->stop();
+    if (m_chunkedExporter != NULL)
+    {
+        m_chunkedExporter->cancel();
+        m_chunkedExporter->wait();
+    }
+    if (m_imageExporter != NULL)
+        m_imageExporter->wait();
     if (m_plotWindow != NULL)
     {
         m_plotWindow->close();
@@ -167,6 +565,40 @@ void MainWindow::configureFormControls()
     // Fill comboBox_lineStyle with available line styles (enumeration)
     m_ui->comboBox_lineStyle->addItem("None", QCPGraph::lsNone);
     m_ui->comboBox_lineStyle->addItem("Line", QCPGraph::lsLine);
+
+    // Menu bar controls: the performance overlay needs the hot-path timers, which are only built on demand
+#ifndef SWG_PERF_COUNTERS
+    m_ui->action_performanceHud->setVisible(false);
+#endif
+    // and so does the timeline recording
+#ifndef SWG_TRACING
+    m_ui->action_recordTrace->setVisible(false);
+#endif
+
+    // Trigger controls
+    m_ui->widget_trigger->hide();
+    m_ui->comboBox_triggerSlope->addItem("Rising edge", TriggerEngine::RisingEdge);
+    m_ui->comboBox_triggerSlope->addItem("Falling edge", TriggerEngine::FallingEdge);
+    m_ui->doubleSpinBox_triggerLevel->setMinimum(-DBL_MAX);
+    m_ui->doubleSpinBox_triggerLevel->setMaximum(DBL_MAX);
+    m_ui->doubleSpinBox_triggerHoldoff->setMaximum(DBL_MAX);
+    m_ui->spinBox_preTrigger->setMaximum(100);
+    m_ui->spinBox_preTrigger->setValue(50);
+}
+
+bool MainWindow::askSampleFormat(SampleFormat &format, bool &dither, bool offerDither)
+{
+    QStringList formats;
+    formats << "Float 32 bits" << "Float 64 bits" << "Integer 16 bits" << "Integer 16 bits, dithered" << "Integer 24 bits" << "Integer 24 bits, dithered";
+    if (!offerDither)
+        formats = formats.filter(QRegExp("bits$"));
+    bool accepted = false;
+    QString item = QInputDialog::getItem(this, tr("Sample format"), tr("Sample format:"), formats, 0, false, &accepted);
+    if (!accepted)
+        return false;
+    format = item.startsWith("Float 32") ? Float32 : item.startsWith("Float 64") ? Float64 : item.startsWith("Integer 16") ? Int16 : Int24;
+    dither = item.endsWith("dithered");
+    return true;
 }
 
 void MainWindow::refreshFormValues()
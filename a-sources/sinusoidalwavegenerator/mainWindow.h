@@ -1,7 +1,11 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QLabel>
 #include <QMainWindow>
+#include <QProgressDialog>
+#include <QTimer>
+#include "chunkedExporter.h"
 #include "plotWindow.h"
 #include "sinusoidalEquation.h"
 
@@ -41,10 +45,51 @@ private slots:
      * @brief Handles the event fired when the users clicks the button to select a color.
      */
     void onSelectColorClicked();
+    /**
+     * @brief Handles the event fired when the user selects the 'Open waveform file' menu option.
+     */
+    void onOpenWaveFileTriggered();
+    /**
+     * @brief Handles the event fired when the user selects the 'Import recording' menu option.
+     */
+    void onImportRecordingTriggered();
+    /**
+     * @brief Handles the event fired when the user selects the 'Close recording' menu option.
+     */
+    void onCloseRecordingTriggered();
     /**
      * @brief Handles the event fired when the user selects the 'Save to file' menu option.
      */
     void onSaveToFileTriggered();
+    /**
+     * @brief Handles the event fired when the user selects the 'Export full wave' menu option.
+     */
+    void onExportFullWaveTriggered();
+    /**
+     * @brief Handles the event fired periodically while the full wave is being exported.
+     * @param writtenSamples Samples written so far.
+     * @param totalSamples Samples of the wave.
+     */
+    void onExportProgressChanged(qint64 writtenSamples, qint64 totalSamples);
+    /**
+     * @brief Handles the event fired when the export of the full wave ends.
+     * @param success Whether the file is correctly written.
+     */
+    void onExportFinished(bool success);
+    /**
+     * @brief Handles the event fired when the graph image is rendered, before it is encoded.
+     */
+    void onImageRenderingFinished();
+    /**
+     * @brief Handles the event fired when the graph image is saved, or failed to.
+     * @param success Whether the file is correctly written.
+     */
+    void onImageExportFinished(bool success);
+    /**
+     * @brief Handles the event fired when the user toggles the 'Record trace' menu option.
+     * @param checked Whether to start recording, or to stop and save the trace.
+     */
+    void onRecordTraceToggled(bool checked);
     /**
      * @brief Handles the event fired when the equation has changed and needs to be redrawn.
      */
@@ -54,6 +99,36 @@ private slots:
      * @param size New size of the window.
      */
     void onPlotWindowResized(const QSize &size);
+    /**
+     * @brief Handles the event fired when the user toggles the 'Streaming mode' menu option.
+     * @param checked Whether the streaming mode is enabled.
+     */
+    void onStreamingModeToggled(bool checked);
+    /**
+     * @brief Handles the event fired when the user changes any of the trigger controls.
+     */
+    void onTriggerSettingsChanged();
+    /**
+     * @brief Handles the event fired when the PlotWindow publishes the performance counters of the stream.
+     * @param samplesPerSecond Samples drawn per second during the last interval.
+     * @param queueDepth Samples waiting to be drawn.
+     * @param droppedSamples Samples discarded since the stream started.
+     * @param droppedFrames Display frames missed since the stream started.
+     */
+    void onStreamStatisticsChanged(double samplesPerSecond, int queueDepth, qint64 droppedSamples, int droppedFrames);
+    /**
+     * @brief Handles the event fired when the equation is not solved because it would exceed its memory limit.
+     * @param requiredMemory Bytes the samples would have taken.
+     */
+    void onSolveRefused(qint64 requiredMemory);
+    /**
+     * @brief Refreshes the statistics of the solved wave shown in the status bar.
+     */
+    void refreshWaveStatistics();
+    /**
+     * @brief Refreshes the memory usage shown in the status bar.
+     */
+    void refreshMemoryUsage();
 
 protected:
     /**
@@ -68,6 +143,11 @@ protected:
     void keyPressEvent(QKeyEvent *event);
 
 private:
+    /**
+     * @brief Interval between refreshes of the memory usage, in milliseconds.
+     */
+    static const int MemoryRefreshInterval = 1000;
+
     /**
      * @brief Configures the behaviour of the form controls.
      */
@@ -76,6 +156,14 @@ private:
      * @brief Refreshes the values shown in the form controls.
      */
     void refreshFormValues();
+    /**
+     * @brief Asks the user for the sample format of a binary file.
+     * @param format Output sample format.
+     * @param dither Output whether to add dither.
+     * @param offerDither Whether dithered formats are offered, which only makes sense when writing.
+     * @return true if the user chose a format, or false if cancelled.
+     */
+    bool askSampleFormat(SampleFormat &format, bool &dither, bool offerDither = true);
 
     /**
      * @brief Widget's user interface definition.
@@ -89,6 +177,34 @@ private:
      * @brief Widget used to draw the equation.
      */
     PlotWindow *m_plotWindow;
+    /**
+     * @brief Label in the status bar that shows the performance counters of the stream.
+     */
+    QLabel *m_streamStatisticsLabel;
+    /**
+     * @brief Label in the status bar that shows the peak, RMS, mean, energy, crest factor and zero crossings of the wave.
+     */
+    QLabel *m_waveStatisticsLabel;
+    /**
+     * @brief Label in the status bar that shows the memory held by the equation and the plot.
+     */
+    QLabel *m_memoryUsageLabel;
+    /**
+     * @brief Timer that refreshes the memory usage, since caches change while zooming and panning.
+     */
+    QTimer *m_memoryTimer;
+    /**
+     * @brief Exporter of the full wave, or NULL if no export is running.
+     */
+    ChunkedExporter *m_chunkedExporter;
+    /**
+     * @brief Dialog that shows the progress of the export of the full wave, and allows to cancel it.
+     */
+    QProgressDialog *m_exportProgress;
+    /**
+     * @brief Exporter of the graph image, or NULL if no image is being saved.
+     */
+    ImageExporter *m_imageExporter;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,256 @@
+#include "mappedGraph.h"
+#include <QtMath>
+#include <QtNumeric>
+#include "perfCounters.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Thread that builds the envelope pyramid of a mapped waveform.
+     */
+    class EnvelopeBuilder : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param waveform Waveform.
+         * @param cancelRequested Stops the build when set to 1.
+         * @param parent Parent object.
+         */
+        EnvelopeBuilder(MappedWaveform *waveform, const QAtomicInt *cancelRequested, QObject *parent)
+            : QThread(parent),
+              m_waveform(waveform),
+              m_cancelRequested(cancelRequested)
+        {
+            // Name of the thread in traces
+            setObjectName("Envelope builder");
+        }
+
+    protected:
+        /**
+         * @brief Builds the pyramid.
+         */
+        void run()
+        {
+            m_waveform->buildEnvelope(*m_cancelRequested);
+        }
+
+    private:
+        /**
+         * @brief Waveform.
+         */
+        MappedWaveform *m_waveform;
+        /**
+         * @brief Stops the build when set to 1.
+         */
+        const QAtomicInt *m_cancelRequested;
+    };
+}
+
+MappedGraph::MappedGraph(QCPAxis *keyAxis, QCPAxis *valueAxis, MappedWaveform *waveform)
+    : QCPAbstractPlottable(keyAxis, valueAxis),
+      m_waveform(waveform),
+      m_envelopeBuilder(NULL),
+      m_cancelRequested(0)
+{
+    // The file is read once in the background, instead of when it is first drawn zoomed out
+    m_envelopeBuilder = new EnvelopeBuilder(m_waveform, &m_cancelRequested, this);
+    connect(m_envelopeBuilder, SIGNAL(finished()), this, SIGNAL(envelopeBuilt()));
+    m_envelopeBuilder->start(QThread::LowPriority);
+}
+
+MappedGraph::~MappedGraph()
+{
+    // The samples are unmapped only once the thread no longer reads them
+    m_cancelRequested.storeRelease(1);
+    m_envelopeBuilder->wait();
+    delete m_waveform;
+}
+
+void MappedGraph::clearData()
+{
+}
+
+double MappedGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if ((onlySelectable && !mSelectable) || m_waveform->size() == 0)
+        return -1;
+    if (!mKeyAxis || !mValueAxis)
+    {
+        qDebug() << Q_FUNC_INFO << "invalid key or value axis";
+        return -1;
+    }
+    if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    // Samples in the pixel column under the position, or the nearest one if the column is empty
+    QCPAxis *keyAxis = mKeyAxis.data();
+    double pixel = (keyAxis->orientation() == Qt::Horizontal) ? pos.x() : pos.y();
+    double key = keyAxis->pixelToCoord(pixel);
+    double lowerKey = keyAxis->pixelToCoord(pixel - 1.0);
+    double upperKey = keyAxis->pixelToCoord(pixel + 1.0);
+    if (lowerKey > upperKey)
+        qSwap(lowerKey, upperKey);
+    qint64 from = m_waveform->lowerBound(lowerKey);
+    qint64 to = m_waveform->lowerBound(upperKey) - 1;
+    if (to < from)
+    {
+        from = qBound((qint64)0, from, m_waveform->size() - 1);
+        if (from > 0 && qAbs(m_waveform->key(from - 1) - key) < qAbs(m_waveform->key(from) - key))
+            --from;
+        to = from;
+        key = m_waveform->key(from);
+    }
+
+    // Distance to the vertical segment that is drawn for the column
+    double min = 0.0;
+    double max = 0.0;
+    if (!m_waveform->envelope(from, to, min, max))
+        return -1;
+    return qSqrt(distSqrToLine(coordsToPixels(key, min), coordsToPixels(key, max), pos));
+}
+
+void MappedGraph::draw(QCPPainter *painter)
+{
+    SWG_PERF_SCOPE("MappedGraph::draw");
+    SWG_TRACE_SCOPE("MappedGraph::draw");
+    if (!mKeyAxis || !mValueAxis)
+    {
+        qDebug() << Q_FUNC_INFO << "invalid key or value axis";
+        return;
+    }
+    qint64 size = m_waveform->size();
+    if (size == 0 || mainPen().style() == Qt::NoPen)
+        return;
+
+    // Visible samples, plus one on each side so that the line reaches the borders
+    QCPAxis *keyAxis = mKeyAxis.data();
+    QCPRange range = keyAxis->range();
+    qint64 from = qMax(m_waveform->lowerBound(range.lower) - 1, (qint64)0);
+    qint64 to = qMin(m_waveform->lowerBound(range.upper), size - 1);
+    if (to < from)
+        return;
+
+    double lowerPixel = keyAxis->coordToPixel(range.lower);
+    double upperPixel = keyAxis->coordToPixel(range.upper);
+    int columnCount = qCeil(qAbs(upperPixel - lowerPixel));
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mainPen());
+    painter->setBrush(Qt::NoBrush);
+    int pointCount = 0;
+    QVector<QPointF> points;
+    if (to - from + 1 <= 2 * columnCount)
+    {
+        // Few samples, draw all of them
+        points.reserve((int)(to - from + 1));
+        for (qint64 i = from; i <= to; ++i)
+            points.append(coordsToPixels(m_waveform->key(i), m_waveform->value(i)));
+    }
+    else
+    {
+        // Many samples, draw the envelope of each pixel column as a vertical segment
+        points.reserve(2 * columnCount + 2);
+        double direction = (upperPixel > lowerPixel) ? 1.0 : -1.0;
+        qint64 first = from;
+        qint64 last = to;
+        if (m_waveform->key(first) < range.lower)
+        {
+            points.append(coordsToPixels(m_waveform->key(first), m_waveform->value(first)));
+            ++first;
+        }
+        if (m_waveform->key(last) > range.upper)
+            --last;
+
+        qint64 i = first;
+        for (int column = 0; column < columnCount && i <= last; ++column)
+        {
+            double columnKey = keyAxis->pixelToCoord(lowerPixel + direction * (column + 0.5));
+            qint64 columnEnd = (column == columnCount - 1) ? last : qMin(m_waveform->lowerBound(keyAxis->pixelToCoord(lowerPixel + direction * (column + 1))) - 1, last);
+            if (columnEnd < i)
+                continue;
+            double min = 0.0;
+            double max = 0.0;
+            if (m_waveform->envelope(i, columnEnd, min, max))
+            {
+                points.append(coordsToPixels(columnKey, min));
+                points.append(coordsToPixels(columnKey, max));
+            }
+            else
+            {
+                // Not available until the envelope pyramid is built: a gap rather than a guess
+                pointCount += points.size();
+                painter->drawPolyline(points.constData(), points.size());
+                points.clear();
+            }
+            i = columnEnd + 1;
+        }
+
+        if (last < to)
+            points.append(coordsToPixels(m_waveform->key(to), m_waveform->value(to)));
+    }
+
+    pointCount += points.size();
+    SWG_PERF_VALUE("MappedGraph::draw points", pointCount);
+    painter->drawPolyline(points.constData(), points.size());
+}
+
+void MappedGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    // Draw line vertically centered
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(), rect.top() + rect.height() / 2.0, rect.right() + 5, rect.top() + rect.height() / 2.0));
+}
+
+QCPRange MappedGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    // Keys are sorted, so the limits are the first and last samples of the sign domain, as in QCPGraph
+    QCPRange range;
+    qint64 first = 0;
+    qint64 last = m_waveform->size() - 1;
+    if (inSignDomain == sdNegative)
+    {
+        last = m_waveform->lowerBound(0.0) - 1;
+    }
+    else if (inSignDomain == sdPositive)
+    {
+        first = m_waveform->lowerBound(0.0);
+        while (first <= last && !(m_waveform->key(first) > 0.0))
+            ++first;
+    }
+    foundRange = first <= last;
+    if (foundRange)
+    {
+        range.lower = m_waveform->key(first);
+        range.upper = m_waveform->key(last);
+    }
+    return range;
+}
+
+QCPRange MappedGraph::getValueRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    QCPRange range;
+    double minPositive = 0.0;
+    double maxNegative = 0.0;
+    if (m_waveform->extremes(range.lower, range.upper, minPositive, maxNegative))
+    {
+        // Only the values of the sign domain, as in QCPGraph
+        if (inSignDomain == sdNegative)
+            range.upper = maxNegative;
+        else if (inSignDomain == sdPositive)
+            range.lower = minPositive;
+        foundRange = !qIsInf(range.lower) && !qIsInf(range.upper);
+        return range;
+    }
+
+    // Before the pyramid is built, the bounds of the samples, which only fit a sign domain they do not cross
+    foundRange = m_waveform->valueBounds(range.lower, range.upper);
+    if (inSignDomain == sdNegative)
+        foundRange = foundRange && range.upper < 0.0;
+    else if (inSignDomain == sdPositive)
+        foundRange = foundRange && range.lower > 0.0;
+    return range;
+}
@@ -0,0 +1,106 @@
+#ifndef MAPPEDGRAPH_H
+#define MAPPEDGRAPH_H
+
+#include <qcustomplot.h>
+#include <QAtomicInt>
+#include <QThread>
+#include "mappedWaveform.h"
+
+/**
+ * @brief Plottable that draws the samples of a memory-mapped waveform in place.
+ *
+ * Unlike QCPGraph, the samples are never copied into a QMap: they are read from the mapping while
+ * drawing, and only the visible ones. When there are more samples than pixels in the visible range,
+ * each pixel column is drawn as the envelope of its samples, as in StreamingGraph.
+ *
+ * The envelope pyramid of the samples is built by a thread of the graph, started when it is created.
+ * Until it is built, columns whose envelope would take too long to read are left out, and the value
+ * range comes from MappedWaveform::valueBounds(). envelopeBuilt() is emitted when it is done.
+ */
+class MappedGraph : public QCPAbstractPlottable
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor.
+     * @param keyAxis Axis used for the keys (time).
+     * @param valueAxis Axis used for the values (elongation).
+     * @param waveform Samples to draw. The graph takes its ownership.
+     */
+    MappedGraph(QCPAxis *keyAxis, QCPAxis *valueAxis, MappedWaveform *waveform);
+    /**
+     * @brief Destructor. Unmaps the samples.
+     */
+    ~MappedGraph();
+
+    /**
+     * @brief Gets the samples drawn by the graph.
+     * @return Mapped waveform.
+     */
+    const MappedWaveform *waveform() const { return m_waveform; }
+
+    /**
+     * @brief Does nothing: the samples belong to the mapped file.
+     */
+    virtual void clearData();
+    /**
+     * @brief Calculates the distance in pixels between the given position and the graph.
+     * @param pos Position in pixels.
+     * @param onlySelectable Whether to return -1 if the graph is not selectable.
+     * @param details Not used.
+     * @return Distance in pixels, or -1 if not applicable.
+     */
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const;
+
+signals:
+    /**
+     * @brief Emitted when the envelope pyramid of the samples is built, so that all of them can be drawn
+     * and their value range is exact.
+     */
+    void envelopeBuilt();
+
+protected:
+    /**
+     * @brief Draws the visible samples, or their envelope per pixel column if they are dense.
+     * @param painter Painter to draw with.
+     */
+    virtual void draw(QCPPainter *painter);
+    /**
+     * @brief Draws the legend icon of the graph.
+     * @param painter Painter to draw with.
+     * @param rect Rect of the icon.
+     */
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
+    /**
+     * @brief Gets the range of keys of the samples.
+     * @param foundRange Set to whether a range could be determined.
+     * @param inSignDomain Sign domain the range is restricted to, for logarithmic axes.
+     * @return Key range.
+     */
+    virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+    /**
+     * @brief Gets the range of values of the samples, from the envelope pyramid once built, or else from
+     * their bounds, which are only known for the whole range.
+     * @param foundRange Set to whether a range could be determined.
+     * @param inSignDomain Sign domain the range is restricted to, for logarithmic axes.
+     * @return Value range.
+     */
+    virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+
+private:
+    /**
+     * @brief Samples drawn by the graph.
+     */
+    MappedWaveform *m_waveform;
+    /**
+     * @brief Thread that builds the envelope pyramid.
+     */
+    QThread *m_envelopeBuilder;
+    /**
+     * @brief Stops the thread that builds the envelope pyramid when set to 1.
+     */
+    QAtomicInt m_cancelRequested;
+};
+
+#endif // MAPPEDGRAPH_H
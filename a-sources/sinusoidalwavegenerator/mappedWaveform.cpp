@@ -0,0 +1,541 @@
+#include "mappedWaveform.h"
+#include <QtEndian>
+#include <QtNumeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "csvImporter.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Loads a little-endian double.
+     * @param source Source, 8 bytes.
+     * @return Value.
+     */
+    inline double loadDouble(const uchar *source)
+    {
+        quint64 bits = qFromLittleEndian<quint64>(source);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Loads a little-endian float.
+     * @param source Source, 4 bytes.
+     * @return Value.
+     */
+    inline float loadFloat(const uchar *source)
+    {
+        quint32 bits = qFromLittleEndian<quint32>(source);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Compares chunks of a waveform file with a time, to find the first chunk that ends at or after it.
+     * @param chunk Chunk.
+     * @param time Time, in seconds.
+     * @return true if the chunk ends before the time, or false otherwise.
+     */
+    bool chunkEndsBefore(const WaveFile::ChunkSummary &chunk, double time)
+    {
+        return chunk.lastTime < time;
+    }
+}
+
+MappedWaveform::MappedWaveform()
+    : m_file(),
+      m_waveFile(),
+      m_keys(),
+      m_values(),
+      m_data(NULL),
+      m_size(0),
+      m_format(Float64),
+      m_samplingFrequency(1.0),
+      m_scale(1.0),
+      m_envelopeLevels(),
+      m_envelopeBuilt(false),
+      m_envelopeMutex()
+{
+}
+
+MappedWaveform::~MappedWaveform()
+{
+    close();
+}
+
+bool MappedWaveform::openWaveFile(const QString &fileName)
+{
+    SWG_TRACE_SCOPE("MappedWaveform::openWaveFile");
+
+    // The reader checks the file and reads its index, the samples are mapped from the start of the file,
+    // which is where the offsets of the chunks count from
+    close();
+    if (!m_waveFile.open(fileName) || m_waveFile.chunks().isEmpty())
+    {
+        close();
+        return false;
+    }
+
+    // Samples are found by index arithmetic, so all the chunks but the last one have to be full
+    const QVector<WaveFile::ChunkSummary> &chunks = m_waveFile.chunks();
+    for (int i = 0; i < chunks.size() - 1; ++i)
+    {
+        if (chunks.at(i).count != WaveFile::ChunkSize)
+        {
+            close();
+            return false;
+        }
+    }
+
+    const WaveFile::ChunkSummary &lastChunk = chunks.last();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly) || !map(0, lastChunk.offset + (qint64)lastChunk.count * WaveFile::BytesPerSample))
+    {
+        close();
+        return false;
+    }
+    m_size = m_waveFile.sampleCount();
+    resetEnvelope();
+    return true;
+}
+
+bool MappedWaveform::openWav(const QString &fileName, double fullScale)
+{
+    SWG_TRACE_SCOPE("MappedWaveform::openWav");
+
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    // RIFF header, then the chunks until the data one, remembering the format
+    QByteArray riff = m_file.read(12);
+    if (riff.size() != 12 || !riff.startsWith("RIFF") || riff.mid(8, 4) != "WAVE")
+    {
+        close();
+        return false;
+    }
+    int formatTag = 0;
+    int channels = 0;
+    quint32 sampleRate = 0;
+    int bitsPerSample = 0;
+    qint64 fileSize = m_file.size();
+    qint64 position = 12;
+    while (position + 8 <= fileSize)
+    {
+        QByteArray chunkHeader;
+        if (m_file.seek(position))
+            chunkHeader = m_file.read(8);
+        if (chunkHeader.size() != 8)
+            break;
+        qint64 chunkSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(chunkHeader.constData()) + 4);
+        position += 8;
+
+        if (chunkHeader.startsWith("fmt "))
+        {
+            QByteArray format = m_file.read(qMin(chunkSize, (qint64)40));
+            if (format.size() < 16)
+                break;
+            const uchar *p = reinterpret_cast<const uchar *>(format.constData());
+            formatTag = qFromLittleEndian<quint16>(p);
+            channels = qFromLittleEndian<quint16>(p + 2);
+            sampleRate = qFromLittleEndian<quint32>(p + 4);
+            bitsPerSample = qFromLittleEndian<quint16>(p + 14);
+            // WAVE_FORMAT_EXTENSIBLE: the actual format is at the start of the sub-format GUID
+            if (formatTag == 0xFFFE && format.size() >= 26)
+                formatTag = qFromLittleEndian<quint16>(p + 24);
+        }
+        else if (chunkHeader.startsWith("data"))
+        {
+            SampleFormat sampleFormat;
+            if (formatTag == 1 && bitsPerSample == 16)
+                sampleFormat = Int16;
+            else if (formatTag == 1 && bitsPerSample == 24)
+                sampleFormat = Int24;
+            else if (formatTag == 3 && bitsPerSample == 32)
+                sampleFormat = Float32;
+            else if (formatTag == 3 && bitsPerSample == 64)
+                sampleFormat = Float64;
+            else
+                break;
+            if (channels != 1 || sampleRate == 0)
+                break;
+
+            // Files written while recording may not have the final size of the data
+            qint64 bytes = qMin(chunkSize, fileSize - position);
+            int bytesPerSample = SampleConverter::bytesPerSample(sampleFormat);
+            m_format = sampleFormat;
+            m_samplingFrequency = sampleRate;
+            m_scale = (fullScale > 0.0 ? fullScale : 1.0) / ((sampleFormat == Int24) ? 8388607.0 : 32767.0);
+            if (!map(position, bytes - bytes % bytesPerSample))
+                break;
+            m_size = bytes / bytesPerSample;
+            resetEnvelope();
+            return true;
+        }
+
+        // Chunks have an even size
+        position += chunkSize + (chunkSize & 1);
+    }
+
+    close();
+    return false;
+}
+
+bool MappedWaveform::openRaw(const QString &fileName, SampleFormat format, double samplingFrequency, double fullScale)
+{
+    SWG_TRACE_SCOPE("MappedWaveform::openRaw");
+
+    close();
+    if (!(samplingFrequency > 0.0))
+        return false;
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    int bytesPerSample = SampleConverter::bytesPerSample(format);
+    qint64 bytes = m_file.size() - m_file.size() % bytesPerSample;
+    m_format = format;
+    m_samplingFrequency = samplingFrequency;
+    m_scale = (fullScale > 0.0 ? fullScale : 1.0) / ((format == Int24) ? 8388607.0 : 32767.0);
+    if (!map(0, bytes))
+    {
+        close();
+        return false;
+    }
+    m_size = bytes / bytesPerSample;
+    resetEnvelope();
+    return true;
+}
+
+bool MappedWaveform::openCsv(const QString &fileName)
+{
+    SWG_TRACE_SCOPE("MappedWaveform::openCsv");
+
+    // Samples are searched by time, so the times have to be sorted
+    close();
+    bool sorted = CsvImporter::read(fileName, m_keys, m_values);
+    for (int i = 1; i < m_keys.size() && sorted; ++i)
+        sorted = !(m_keys.at(i) < m_keys.at(i - 1));
+    if (!sorted)
+    {
+        close();
+        return false;
+    }
+    m_size = m_keys.size();
+    resetEnvelope();
+    return true;
+}
+
+void MappedWaveform::close()
+{
+    if (m_data != NULL)
+        m_file.unmap(const_cast<uchar *>(m_data));
+    m_file.close();
+    m_waveFile.close();
+    m_keys = QVector<double>();
+    m_values = QVector<double>();
+    m_data = NULL;
+    m_size = 0;
+    m_envelopeLevels.clear();
+    m_envelopeBuilt = false;
+}
+
+bool MappedWaveform::map(qint64 offset, qint64 bytes)
+{
+    if (bytes <= 0)
+        return false;
+    m_data = m_file.map(offset, bytes);
+    return m_data != NULL;
+}
+
+double MappedWaveform::key(qint64 index) const
+{
+    if (m_waveFile.isOpen())
+    {
+        const WaveFile::ChunkSummary &chunk = m_waveFile.chunks().at((int)(index / WaveFile::ChunkSize));
+        return loadDouble(m_data + chunk.offset + (index % WaveFile::ChunkSize) * sizeof(double));
+    }
+    if (!m_keys.isEmpty())
+        return m_keys.constData()[index];
+    return index / m_samplingFrequency;
+}
+
+double MappedWaveform::value(qint64 index) const
+{
+    if (m_waveFile.isOpen())
+    {
+        const WaveFile::ChunkSummary &chunk = m_waveFile.chunks().at((int)(index / WaveFile::ChunkSize));
+        return loadDouble(m_data + chunk.offset + (chunk.count + index % WaveFile::ChunkSize) * sizeof(double));
+    }
+    if (!m_values.isEmpty())
+        return m_values.constData()[index];
+
+    switch (m_format)
+    {
+    case Float32:
+        return loadFloat(m_data + index * 4);
+    case Float64:
+        return loadDouble(m_data + index * 8);
+    case Int16:
+        return qFromLittleEndian<qint16>(m_data + index * 2) * m_scale;
+    case Int24:
+    {
+        // Sign-extended from the third byte
+        const uchar *p = m_data + index * 3;
+        qint32 sample = (qint32)((quint32)p[0] | ((quint32)p[1] << 8) | ((quint32)(qint8)p[2] << 16));
+        return sample * m_scale;
+    }
+    }
+    return 0.0;
+}
+
+qint64 MappedWaveform::lowerBound(double key) const
+{
+    if (m_size == 0)
+        return 0;
+
+    qint64 low;
+    qint64 high;
+    if (m_waveFile.isOpen())
+    {
+        // Chunk from the index, then a binary search inside it
+        const QVector<WaveFile::ChunkSummary> &chunks = m_waveFile.chunks();
+        int chunk = (int)(std::lower_bound(chunks.constBegin(), chunks.constEnd(), key, chunkEndsBefore) - chunks.constBegin());
+        if (chunk >= chunks.size())
+            return m_size;
+        low = (qint64)chunk * WaveFile::ChunkSize;
+        high = low + chunks.at(chunk).count;
+    }
+    else if (!m_keys.isEmpty())
+    {
+        return std::lower_bound(m_keys.constBegin(), m_keys.constEnd(), key) - m_keys.constBegin();
+    }
+    else
+    {
+        // Uniformly sampled: compute the index, and correct the rounding with the neighbours
+        double position = std::ceil(key * m_samplingFrequency);
+        if (position <= 0.0)
+            return 0;
+        if (position >= (double)m_size)
+            return m_size;
+        low = qMax((qint64)position - 1, (qint64)0);
+        high = qMin((qint64)position + 2, m_size);
+    }
+
+    while (low < high)
+    {
+        qint64 middle = low + (high - low) / 2;
+        if (this->key(middle) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+bool MappedWaveform::envelope(qint64 from, qint64 to, double &min, double &max) const
+{
+    min = value(from);
+    max = min;
+
+    qint64 scanned = 0;
+    qint64 i = from;
+    while (i <= to)
+    {
+        double spanMin;
+        double spanMax;
+        qint64 spanEnd;
+        if (m_waveFile.isOpen())
+        {
+            // Whole chunks of waveform files from the index, the samples of the partial ones otherwise
+            const WaveFile::ChunkSummary &chunk = m_waveFile.chunks().at((int)(i / WaveFile::ChunkSize));
+            qint64 chunkEnd = (i / WaveFile::ChunkSize) * WaveFile::ChunkSize + chunk.count - 1;
+            if (i % WaveFile::ChunkSize == 0 && chunkEnd <= to)
+            {
+                spanMin = chunk.minimum;
+                spanMax = chunk.maximum;
+                spanEnd = chunkEnd;
+            }
+            else
+            {
+                spanEnd = qMin(chunkEnd, to);
+                scanEnvelope(i, spanEnd, spanMin, spanMax);
+            }
+        }
+        else if (!computedBlock(i, to, spanEnd, spanMin, spanMax))
+        {
+            // The samples up to the next block, as long as the pyramid is not needed to cover the span
+            spanEnd = qMin((i / EnvelopeBlockSize + 1) * EnvelopeBlockSize - 1, to);
+            scanned += spanEnd - i + 1;
+            if (scanned > MaxEnvelopeScan)
+                return false;
+            scanEnvelope(i, spanEnd, spanMin, spanMax);
+        }
+
+        min = qMin(min, spanMin);
+        max = qMax(max, spanMax);
+        i = spanEnd + 1;
+    }
+    return true;
+}
+
+bool MappedWaveform::valueBounds(double &min, double &max) const
+{
+    if (m_size == 0)
+        return false;
+    if (m_waveFile.isOpen())
+    {
+        const QVector<WaveFile::ChunkSummary> &chunks = m_waveFile.chunks();
+        min = chunks.first().minimum;
+        max = chunks.first().maximum;
+        for (int i = 1; i < chunks.size(); ++i)
+        {
+            min = qMin(min, chunks.at(i).minimum);
+            max = qMax(max, chunks.at(i).maximum);
+        }
+        return true;
+    }
+    if (!m_values.isEmpty() || m_format == Float32 || m_format == Float64)
+        return false;
+
+    // The most negative integer is one more than the largest one
+    double largest = (m_format == Int24) ? 8388607.0 : 32767.0;
+    min = -(largest + 1.0) * m_scale;
+    max = largest * m_scale;
+    return true;
+}
+
+bool MappedWaveform::extremes(double &min, double &max, double &minPositive, double &maxNegative) const
+{
+    QMutexLocker locker(&m_envelopeMutex);
+    if (!m_envelopeBuilt || m_envelopeLevels.isEmpty() || m_envelopeLevels.last().blocks.isEmpty())
+        return false;
+    const Extremes &all = m_envelopeLevels.last().blocks.first();
+    min = all.minimum;
+    max = all.maximum;
+    minPositive = all.minimumPositive;
+    maxNegative = all.maximumNegative;
+    return true;
+}
+
+void MappedWaveform::buildEnvelope(const QAtomicInt &cancelRequested)
+{
+    SWG_TRACE_SCOPE("MappedWaveform::buildEnvelope");
+
+    // Only this thread writes the blocks, so it reads them without locking. The lowest level reads
+    // its samples, the others combine the blocks below them
+    for (int level = 0; level < m_envelopeLevels.size(); ++level)
+    {
+        qint64 blockSize = m_envelopeLevels.at(level).blockSize;
+        int blockCount = m_envelopeLevels.at(level).blocks.size();
+        for (int block = 0; block < blockCount; ++block)
+        {
+            if (cancelRequested.loadAcquire() != 0)
+                return;
+
+            Extremes extremes;
+            if (level == 0)
+            {
+                extremes = scanExtremes(block * blockSize, qMin((block + 1) * blockSize, m_size) - 1);
+            }
+            else
+            {
+                const QVector<Extremes> &children = m_envelopeLevels.at(level - 1).blocks;
+                int child = block * EnvelopeFanout;
+                int lastChild = qMin(child + EnvelopeFanout, children.size()) - 1;
+                extremes = children.at(child);
+                for (++child; child <= lastChild; ++child)
+                {
+                    const Extremes &next = children.at(child);
+                    extremes.minimum = qMin(extremes.minimum, next.minimum);
+                    extremes.maximum = qMax(extremes.maximum, next.maximum);
+                    extremes.minimumPositive = qMin(extremes.minimumPositive, next.minimumPositive);
+                    extremes.maximumNegative = qMax(extremes.maximumNegative, next.maximumNegative);
+                }
+            }
+
+            QMutexLocker locker(&m_envelopeMutex);
+            m_envelopeLevels[level].blocks[block] = extremes;
+            m_envelopeLevels[level].computed.setBit(block);
+        }
+    }
+
+    QMutexLocker locker(&m_envelopeMutex);
+    m_envelopeBuilt = true;
+}
+
+void MappedWaveform::resetEnvelope()
+{
+    m_envelopeLevels.clear();
+    m_envelopeBuilt = false;
+    qint64 blockSize = EnvelopeBlockSize;
+    do
+    {
+        // 32 bytes for every block of 4096 samples, and a few more for the levels above
+        int blockCount = (int)((m_size + blockSize - 1) / blockSize);
+        EnvelopeLevel level;
+        level.blockSize = blockSize;
+        level.blocks.resize(blockCount);
+        level.computed.resize(blockCount);
+        m_envelopeLevels.append(level);
+        blockSize *= EnvelopeFanout;
+    }
+    while (m_envelopeLevels.last().blocks.size() > 1);
+}
+
+bool MappedWaveform::computedBlock(qint64 from, qint64 to, qint64 &blockEnd, double &min, double &max) const
+{
+    QMutexLocker locker(&m_envelopeMutex);
+    for (int level = m_envelopeLevels.size() - 1; level >= 0; --level)
+    {
+        const EnvelopeLevel &blocks = m_envelopeLevels.at(level);
+        blockEnd = qMin(from + blocks.blockSize, m_size) - 1;
+        int block = (int)(from / blocks.blockSize);
+        if (from % blocks.blockSize == 0 && blockEnd <= to && blocks.computed.testBit(block))
+        {
+            min = blocks.blocks.at(block).minimum;
+            max = blocks.blocks.at(block).maximum;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MappedWaveform::scanEnvelope(qint64 from, qint64 to, double &min, double &max) const
+{
+    min = value(from);
+    max = min;
+    for (qint64 i = from + 1; i <= to; ++i)
+    {
+        double sample = value(i);
+        min = qMin(min, sample);
+        max = qMax(max, sample);
+    }
+}
+
+MappedWaveform::Extremes MappedWaveform::scanExtremes(qint64 from, qint64 to) const
+{
+    Extremes extremes;
+    extremes.minimum = value(from);
+    extremes.maximum = extremes.minimum;
+    extremes.minimumPositive = qInf();
+    extremes.maximumNegative = -qInf();
+    for (qint64 i = from; i <= to; ++i)
+    {
+        double sample = value(i);
+        extremes.minimum = qMin(extremes.minimum, sample);
+        extremes.maximum = qMax(extremes.maximum, sample);
+        if (sample > 0.0)
+            extremes.minimumPositive = qMin(extremes.minimumPositive, sample);
+        else if (sample < 0.0)
+            extremes.maximumNegative = qMax(extremes.maximumNegative, sample);
+    }
+    return extremes;
+}
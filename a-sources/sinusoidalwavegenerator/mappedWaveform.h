@@ -0,0 +1,279 @@
+#ifndef MAPPEDWAVEFORM_H
+#define MAPPEDWAVEFORM_H
+
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "sampleExporter.h"
+#include "waveFile.h"
+
+/**
+ * @brief Read-only view of the samples of a recorded waveform file, memory-mapped instead of loaded.
+ *
+ * Opening only maps the file and reads its headers, so it takes the same time whatever the size of the
+ * file; the samples are decoded from the mapping when accessed, and the operating system pages them in
+ * and out as needed. Waveform files (.swg), WAV files and raw little-endian files are supported. Integer
+ * samples are scaled so that the largest integer maps to the given full scale, as when exporting them.
+ * Delimited text files cannot be addressed by index, so they are parsed into columns in memory instead.
+ *
+ * The envelope of waveform files comes from the minimum and maximum of each chunk in their index. For
+ * the other files, it comes from a pyramid of the extremes of blocks of samples, which buildEnvelope()
+ * fills by reading the whole file once, from a worker thread. Until then, only the envelopes of short
+ * spans are available, read from the samples, so that opening and drawing a large file never waits for
+ * all of it. The envelope is always exact: a span that is not available yet is reported as such.
+ */
+class MappedWaveform
+{
+public:
+    /**
+     * @brief Constructor.
+     */
+    MappedWaveform();
+    /**
+     * @brief Destructor. Unmaps the file.
+     */
+    ~MappedWaveform();
+
+    /**
+     * @brief Maps a waveform file (.swg).
+     * @param fileName Full path of the file.
+     * @return true if the file is mapped, or false otherwise.
+     */
+    bool openWaveFile(const QString &fileName);
+    /**
+     * @brief Maps a mono WAV file, PCM 16 or 24 bits or IEEE float 32 or 64 bits.
+     * @param fileName Full path of the file.
+     * @param fullScale Value of the largest integer, for integer samples.
+     * @return true if the file is mapped, or false otherwise.
+     */
+    bool openWav(const QString &fileName, double fullScale);
+    /**
+     * @brief Maps a raw file of little-endian samples without header.
+     * @param fileName Full path of the file.
+     * @param format Sample format of the file.
+     * @param samplingFrequency Sampling frequency of the samples, in hertz.
+     * @param fullScale Value of the largest integer, for integer samples.
+     * @return true if the file is mapped, or false otherwise.
+     */
+    bool openRaw(const QString &fileName, SampleFormat format, double samplingFrequency, double fullScale);
+    /**
+     * @brief Reads a delimited text file (CSV, TSV) of times and elongations, with CsvImporter.
+     * @param fileName Full path of the file.
+     * @return true if the file is read and its times are sorted, or false otherwise.
+     */
+    bool openCsv(const QString &fileName);
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    /**
+     * @brief Gets the number of samples.
+     * @return Number of samples, or 0 if no file is mapped.
+     */
+    qint64 size() const { return m_size; }
+    /**
+     * @brief Gets the time of a sample.
+     * @param index Index of the sample.
+     * @return Time, in seconds.
+     */
+    double key(qint64 index) const;
+    /**
+     * @brief Gets the elongation of a sample.
+     * @param index Index of the sample.
+     * @return Elongation.
+     */
+    double value(qint64 index) const;
+    /**
+     * @brief Finds the first sample whose time is not smaller than the given one.
+     * @param key Time, in seconds.
+     * @return Index of the sample, or size() if all the times are smaller.
+     */
+    qint64 lowerBound(double key) const;
+    /**
+     * @brief Calculates the minimum and maximum elongation of a range of samples.
+     *
+     * Whole chunks of waveform files are taken from their index, and whole blocks of other files from
+     * the envelope pyramid, as far as it is built. The other samples are read, up to MaxEnvelopeScan.
+     * @param from Index of the first sample.
+     * @param to Index of the last sample.
+     * @param min Set to the minimum elongation.
+     * @param max Set to the maximum elongation.
+     * @return true if calculated, or false if more than MaxEnvelopeScan samples would have to be read
+     * before the pyramid is built.
+     */
+    bool envelope(qint64 from, qint64 to, double &min, double &max) const;
+    /**
+     * @brief Gets a range of elongations that holds all the samples, without reading them: the
+     * extremes of the index of waveform files, or the full scale of integer samples.
+     * @param min Set to the lower bound.
+     * @param max Set to the upper bound.
+     * @return true if known, or false for float and delimited text samples.
+     */
+    bool valueBounds(double &min, double &max) const;
+    /**
+     * @brief Gets the extremes of all the samples, once the envelope pyramid is built.
+     * @param min Set to the minimum elongation.
+     * @param max Set to the maximum elongation.
+     * @param minPositive Set to the smallest positive elongation, or infinity if there is none.
+     * @param maxNegative Set to the largest negative elongation, or minus infinity if there is none.
+     * @return true if the pyramid is built and there are samples, or false otherwise.
+     */
+    bool extremes(double &min, double &max, double &minPositive, double &maxNegative) const;
+    /**
+     * @brief Reads all the samples to fill the envelope pyramid. Meant to run in a worker thread while
+     * the other methods are used, but not while opening or closing a file.
+     * @param cancelRequested Stops the build when set to 1.
+     */
+    void buildEnvelope(const QAtomicInt &cancelRequested);
+
+    /**
+     * @brief Maximum number of samples read by envelope() when the pyramid does not cover a span yet.
+     */
+    static const int MaxEnvelopeScan = 65536;
+
+private:
+    /**
+     * @brief Number of samples of the blocks of the lowest level of the envelope pyramid.
+     */
+    static const int EnvelopeBlockSize = 4096;
+    /**
+     * @brief Number of blocks of a level of the envelope pyramid in each block of the next level.
+     */
+    static const int EnvelopeFanout = 64;
+
+    /**
+     * @brief Extremes of a block of samples, overall and for each sign, as axes with a logarithmic
+     * scale need them.
+     */
+    struct Extremes
+    {
+        /**
+         * @brief Minimum elongation.
+         */
+        double minimum;
+        /**
+         * @brief Maximum elongation.
+         */
+        double maximum;
+        /**
+         * @brief Smallest positive elongation, or infinity if there is none.
+         */
+        double minimumPositive;
+        /**
+         * @brief Largest negative elongation, or minus infinity if there is none.
+         */
+        double maximumNegative;
+    };
+
+    /**
+     * @brief Level of the envelope pyramid.
+     */
+    struct EnvelopeLevel
+    {
+        /**
+         * @brief Number of samples of each block.
+         */
+        qint64 blockSize;
+        /**
+         * @brief Extremes of each block, once computed.
+         */
+        QVector<Extremes> blocks;
+        /**
+         * @brief Whether each block is computed.
+         */
+        QBitArray computed;
+    };
+
+    /**
+     * @brief Maps a range of the file, opened by the caller.
+     * @param offset Offset of the first sample, in bytes.
+     * @param bytes Bytes to map.
+     * @return true if mapped, or false otherwise.
+     */
+    bool map(qint64 offset, qint64 bytes);
+    /**
+     * @brief Prepares the levels of the envelope pyramid for the samples, without computing any block.
+     */
+    void resetEnvelope();
+    /**
+     * @brief Finds the largest computed block of the envelope pyramid that starts at a sample and ends
+     * in a span.
+     * @param from Index of the first sample of the block.
+     * @param to Index of the last sample of the span.
+     * @param blockEnd Set to the index of the last sample of the block.
+     * @param min Set to the minimum elongation of the block.
+     * @param max Set to the maximum elongation of the block.
+     * @return true if there is such a block, or false otherwise.
+     */
+    bool computedBlock(qint64 from, qint64 to, qint64 &blockEnd, double &min, double &max) const;
+    /**
+     * @brief Reads all the samples of a range to calculate their minimum and maximum elongation.
+     * @param from Index of the first sample.
+     * @param to Index of the last sample.
+     * @param min Set to the minimum elongation.
+     * @param max Set to the maximum elongation.
+     */
+    void scanEnvelope(qint64 from, qint64 to, double &min, double &max) const;
+    /**
+     * @brief Reads all the samples of a range to calculate their extremes.
+     * @param from Index of the first sample.
+     * @param to Index of the last sample.
+     * @return Extremes.
+     */
+    Extremes scanExtremes(qint64 from, qint64 to) const;
+
+    /**
+     * @brief Mapped file.
+     */
+    QFile m_file;
+    /**
+     * @brief Index of the waveform file, empty for WAV and raw files.
+     */
+    WaveFileReader m_waveFile;
+    /**
+     * @brief Times read from a delimited text file, empty for mapped files.
+     */
+    QVector<double> m_keys;
+    /**
+     * @brief Elongations read from a delimited text file, empty for mapped files.
+     */
+    QVector<double> m_values;
+    /**
+     * @brief Start of the samples in the mapping.
+     */
+    const uchar *m_data;
+    /**
+     * @brief Number of samples.
+     */
+    qint64 m_size;
+    /**
+     * @brief Sample format of WAV and raw files.
+     */
+    SampleFormat m_format;
+    /**
+     * @brief Sampling frequency of WAV and raw files, in hertz.
+     */
+    double m_samplingFrequency;
+    /**
+     * @brief Factor from integer samples to elongation.
+     */
+    double m_scale;
+    /**
+     * @brief Envelope pyramid, from blocks of EnvelopeBlockSize samples up to a single block.
+     */
+    QVector<EnvelopeLevel> m_envelopeLevels;
+    /**
+     * @brief Whether all the blocks of the pyramid are computed.
+     */
+    bool m_envelopeBuilt;
+    /**
+     * @brief Protects the blocks of the pyramid, written by the thread that builds it.
+     */
+    mutable QMutex m_envelopeMutex;
+};
+
+#endif // MAPPEDWAVEFORM_H
@@ -0,0 +1,121 @@
+#include "perfCounters.h"
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+
+
+namespace
+{
+    /**
+     * @brief Number of recent timings kept per counter for the average and percentile.
+     */
+    const int RecentTimingCount = 256;
+
+    /**
+     * @brief Data recorded for one counter.
+     */
+    struct Counter
+    {
+        Counter() : count(0), lastValue(0.0), recentTimings(), recentPosition(0) {}
+
+        /**
+         * @brief Number of records.
+         */
+        qint64 count;
+        /**
+         * @brief Last value, or last timing in milliseconds.
+         */
+        double lastValue;
+        /**
+         * @brief Recent timings, in nanoseconds (ring buffer once full).
+         */
+        QVector<qint64> recentTimings;
+        /**
+         * @brief Position of the oldest recent timing, once the ring buffer is full.
+         */
+        int recentPosition;
+    };
+
+    /**
+     * @brief Protects the counters, which can be recorded from any thread.
+     */
+    QMutex counterMutex;
+    /**
+     * @brief Counters by name.
+     */
+    QMap<QByteArray, Counter> counters;
+}
+
+void PerfCounters::addTiming(const char *name, qint64 nanoseconds)
+{
+    QMutexLocker locker(&counterMutex);
+    Counter &counter = counters[QByteArray(name)];
+    ++counter.count;
+    if (counter.recentTimings.size() < RecentTimingCount)
+    {
+        counter.recentTimings.append(nanoseconds);
+    }
+    else
+    {
+        counter.recentTimings[counter.recentPosition] = nanoseconds;
+        counter.recentPosition = (counter.recentPosition + 1) % RecentTimingCount;
+    }
+    counter.lastValue = nanoseconds / 1e6;
+}
+
+void PerfCounters::addValue(const char *name, double value)
+{
+    QMutexLocker locker(&counterMutex);
+    Counter &counter = counters[QByteArray(name)];
+    ++counter.count;
+    counter.lastValue = value;
+}
+
+qint64 PerfCounters::count(const char *name)
+{
+    QMutexLocker locker(&counterMutex);
+    return counters.value(QByteArray(name)).count;
+}
+
+double PerfCounters::lastValue(const char *name)
+{
+    QMutexLocker locker(&counterMutex);
+    return counters.value(QByteArray(name)).lastValue;
+}
+
+QVector<PerfCounters::Statistics> PerfCounters::statistics()
+{
+    QMutexLocker locker(&counterMutex);
+    QVector<Statistics> result;
+    for (QMap<QByteArray, Counter>::const_iterator it = counters.constBegin(); it != counters.constEnd(); ++it)
+    {
+        const Counter &counter = it.value();
+        Statistics statistics;
+        statistics.name = QString::fromLatin1(it.key());
+        statistics.count = counter.count;
+        statistics.lastValue = counter.lastValue;
+        statistics.isTiming = !counter.recentTimings.isEmpty();
+        statistics.lastMs = 0.0;
+        statistics.averageMs = 0.0;
+        statistics.p99Ms = 0.0;
+
+        // Timings: last, average and 99th percentile of the recent ones
+        int size = counter.recentTimings.size();
+        if (size > 0)
+        {
+            int last = (size < RecentTimingCount) ? size - 1 : (counter.recentPosition + RecentTimingCount - 1) % RecentTimingCount;
+            QVector<qint64> sorted = counter.recentTimings;
+            double sum = 0.0;
+            for (int i = 0; i < size; ++i)
+                sum += sorted.at(i);
+            int percentile = qMin((int)(size * 0.99), size - 1);
+            std::nth_element(sorted.begin(), sorted.begin() + percentile, sorted.end());
+            statistics.lastMs = counter.recentTimings.at(last) / 1e6;
+            statistics.averageMs = sum / size / 1e6;
+            statistics.p99Ms = sorted.at(percentile) / 1e6;
+        }
+        result.append(statistics);
+    }
+    return result;
+}
@@ -0,0 +1,124 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Registry of the timings and values recorded on the hot paths of the application.
+ *
+ * Timings are recorded with SWG_PERF_SCOPE, which times the enclosing scope, and values with
+ * SWG_PERF_VALUE. Both macros expand to nothing unless SWG_PERF_COUNTERS is defined (qmake
+ * CONFIG += perf_counters), so they cost nothing in normal builds. The registry can be used
+ * from any thread.
+ */
+class PerfCounters
+{
+public:
+    /**
+     * @brief Summary of one counter.
+     */
+    struct Statistics
+    {
+        /**
+         * @brief Name of the counter.
+         */
+        QString name;
+        /**
+         * @brief Number of times the counter has been recorded since the application started.
+         */
+        qint64 count;
+        /**
+         * @brief Whether the counter records timings (SWG_PERF_SCOPE) or values (SWG_PERF_VALUE).
+         */
+        bool isTiming;
+        /**
+         * @brief Last timing, in milliseconds.
+         */
+        double lastMs;
+        /**
+         * @brief Average of the recent timings, in milliseconds.
+         */
+        double averageMs;
+        /**
+         * @brief 99th percentile of the recent timings, in milliseconds.
+         */
+        double p99Ms;
+        /**
+         * @brief Last value recorded with SWG_PERF_VALUE.
+         */
+        double lastValue;
+    };
+
+    /**
+     * @brief Records a timing.
+     * @param name Name of the counter.
+     * @param nanoseconds Duration, in nanoseconds.
+     */
+    static void addTiming(const char *name, qint64 nanoseconds);
+    /**
+     * @brief Records a value.
+     * @param name Name of the counter.
+     * @param value Value.
+     */
+    static void addValue(const char *name, double value);
+    /**
+     * @brief Gets the number of times a counter has been recorded.
+     * @param name Name of the counter.
+     * @return Number of records, or 0 if it has never been recorded.
+     */
+    static qint64 count(const char *name);
+    /**
+     * @brief Gets the last value of a counter.
+     * @param name Name of the counter.
+     * @return Last value, or 0 if it has never been recorded.
+     */
+    static double lastValue(const char *name);
+    /**
+     * @brief Gets a summary of all the counters, sorted by name.
+     * @return One summary per counter.
+     */
+    static QVector<Statistics> statistics();
+};
+
+/**
+ * @brief Records the time spent between its construction and destruction in a counter.
+ */
+class PerfScope
+{
+public:
+    /**
+     * @brief Constructor. Starts the timer.
+     * @param name Name of the counter, a string literal.
+     */
+    explicit PerfScope(const char *name) : m_name(name) { m_timer.start(); }
+    /**
+     * @brief Destructor. Records the time elapsed.
+     */
+    ~PerfScope() { PerfCounters::addTiming(m_name, m_timer.nsecsElapsed()); }
+
+private:
+    /**
+     * @brief Name of the counter.
+     */
+    const char *m_name;
+    /**
+     * @brief Timer started at construction.
+     */
+    QElapsedTimer m_timer;
+};
+
+#define SWG_PERF_CONCATENATE_(a, b) a##b
+#define SWG_PERF_CONCATENATE(a, b) SWG_PERF_CONCATENATE_(a, b)
+
+#ifdef SWG_PERF_COUNTERS
+#define SWG_PERF_SCOPE(name) PerfScope SWG_PERF_CONCATENATE(perfScope, __LINE__)(name)
+#define SWG_PERF_VALUE(name, value) PerfCounters::addValue(name, value)
+#else
+#define SWG_PERF_SCOPE(name)
+#define SWG_PERF_VALUE(name, value)
+#endif
+
+#endif // PERFCOUNTERS_H
@@ -1,11 +1,67 @@
 #include "plotWindow.h"
 #include "ui_plotWindow.h"
 #include <QDebug>
+#include <QPicture>
+#include "perfCounters.h"
+#include "traceRecorder.h"
+#include <algorithm>
 
 
+/**
+ * @brief Compares chunks of a waveform file with a time, to find the first chunk that ends at or after it.
+ * @param chunk Chunk.
+ * @param time Time, in seconds.
+ * @return true if the chunk ends before the time, or false otherwise.
+ */
+static bool chunkEndsBefore(const WaveFile::ChunkSummary &chunk, double time)
+{
+    return chunk.lastTime < time;
+}
+
+/**
+ * @brief Compares chunks of a waveform file with a time, to find the first chunk that starts after it.
+ * @param time Time, in seconds.
+ * @param chunk Chunk.
+ * @return true if the chunk starts after the time, or false otherwise.
+ */
+static bool chunkStartsAfter(double time, const WaveFile::ChunkSummary &chunk)
+{
+    return time < chunk.firstTime;
+}
+
 PlotWindow::PlotWindow(QWidget *parent) :
     QWidget(parent),
-    m_ui(new Ui::PlotWindow)
+    m_ui(new Ui::PlotWindow),
+    m_overlayLayer(NULL),
+    m_tracer(NULL),
+    m_tracerLabel(NULL),
+    m_timeVector(),
+    m_elongationVector(),
+    m_samplingFrequency(0.0),
+    m_streamQueue(NULL),
+    m_streamGenerator(NULL),
+    m_streamGraph(NULL),
+    m_streamTimer(NULL),
+    m_streamKeys(),
+    m_streamValues(),
+    m_streamWindowLength(0.0),
+    m_streamFrameClock(),
+    m_streamStatisticsClock(),
+    m_streamSamplesDrawn(0),
+    m_streamDroppedFrames(0),
+    m_trigger(),
+    m_triggerEnabled(false),
+    m_preTriggerRatio(0.5),
+    m_hudText(NULL),
+    m_hudTimer(NULL),
+    m_hudClock(),
+    m_hudReplotCount(0),
+    m_waveFile(NULL),
+    m_overviewMinGraph(NULL),
+    m_overviewMaxGraph(NULL),
+    m_fileFirstChunk(-1),
+    m_fileChunkCount(0),
+    m_recordingGraph(NULL)
 {
     m_ui->setupUi(this);
 
@@ -24,18 +80,124 @@ PlotWindow::PlotWindow(QWidget *parent) :
     // Set axes labels
     m_ui->widget_plot->xAxis->setLabel("time [seconds]");
     m_ui->widget_plot->yAxis->setLabel("elongation [units]");
+
+    // Create the measurement cursor on a buffered layer above the rest of the plot,
+    // so following the mouse only repaints that layer and not the whole graph
+    m_ui->widget_plot->addLayer("overlay", m_ui->widget_plot->layer("legend"), QCustomPlot::limAbove);
+    m_overlayLayer = m_ui->widget_plot->layer("overlay");
+    m_overlayLayer->setMode(QCPLayer::lmBuffered);
+    m_tracer = new QCPItemTracer(m_ui->widget_plot);
+    m_ui->widget_plot->addItem(m_tracer);
+    m_tracer->setLayer(m_overlayLayer);
+    m_tracer->setStyle(QCPItemTracer::tsCrosshair);
+    m_tracer->setPen(QPen(QColor(255, 0, 0), 0, Qt::DashLine));
+    m_tracer->setSelectable(false);
+    m_tracer->setVisible(false);
+    m_tracerLabel = new QCPItemText(m_ui->widget_plot);
+    m_ui->widget_plot->addItem(m_tracerLabel);
+    m_tracerLabel->setLayer(m_overlayLayer);
+    m_tracerLabel->setPositionAlignment(Qt::AlignLeft | Qt::AlignBottom);
+    m_tracerLabel->position->setParentAnchor(m_tracer->position);
+    m_tracerLabel->position->setCoords(5, -5);
+    m_tracerLabel->setTextAlignment(Qt::AlignLeft);
+    m_tracerLabel->setBrush(QBrush(QColor(255, 255, 255, 200)));
+    m_tracerLabel->setPadding(QMargins(3, 3, 3, 3));
+    m_tracerLabel->setSelectable(false);
+    m_tracerLabel->setVisible(false);
+
+    // Create the performance overlay in the top left corner of the axis rect, hidden by default
+    m_hudText = new QCPItemText(m_ui->widget_plot);
+    m_ui->widget_plot->addItem(m_hudText);
+    m_hudText->setLayer(m_overlayLayer);
+    m_hudText->position->setType(QCPItemPosition::ptAxisRectRatio);
+    m_hudText->position->setCoords(0.01, 0.01);
+    m_hudText->setPositionAlignment(Qt::AlignLeft | Qt::AlignTop);
+    m_hudText->setTextAlignment(Qt::AlignLeft);
+    QFont hudFont("Monospace", 8);
+    hudFont.setStyleHint(QFont::TypeWriter);
+    m_hudText->setFont(hudFont);
+    m_hudText->setBrush(QBrush(QColor(255, 255, 255, 220)));
+    m_hudText->setPadding(QMargins(3, 3, 3, 3));
+    m_hudText->setSelectable(false);
+    m_hudText->setVisible(false);
+    m_hudTimer = new QTimer(this);
+    m_hudTimer->setInterval(HudRefreshInterval);
+
+    // Create the graph used in streaming mode, hidden until a stream is started
+    m_streamGraph = new StreamingGraph(m_ui->widget_plot->xAxis, m_ui->widget_plot->yAxis, 1);
+    m_ui->widget_plot->addPlottable(m_streamGraph);
+    m_streamGraph->setPen(QPen(QColor(0, 0, 255)));
+    m_streamGraph->setName("Stream");
+    m_streamGraph->setVisible(false);
+    m_streamGraph->removeFromLegend();
+    m_streamTimer = new QTimer(this);
+    m_streamTimer->setInterval(StreamFrameInterval);
+
+    connect(m_ui->widget_plot, SIGNAL(mouseMove(QMouseEvent*)), this, SLOT(onPlotMouseMoved(QMouseEvent*)));
+    connect(m_streamTimer, SIGNAL(timeout()), this, SLOT(onStreamTimerTimeout()));
+    connect(m_hudTimer, SIGNAL(timeout()), this, SLOT(onHudTimerTimeout()));
+    m_ui->widget_plot->installEventFilter(this);
 }
 
 PlotWindow::~PlotWindow()
 {
+    // Stop the generator before the queue it writes to is destroyed
+    if (m_streamGenerator != NULL)
+        delete m_streamGenerator;
+    if (m_streamQueue != NULL)
+        delete m_streamQueue;
+    if (m_waveFile != NULL)
+        delete m_waveFile;
+
     delete m_ui;
 }
 
 bool PlotWindow::saveToFile(QString &fileName)
 {
+    SWG_TRACE_SCOPE("PlotWindow::saveToFile");
     return m_ui->widget_plot->savePng(fileName);
 }
 
+void PlotWindow::saveToFileInBackground(const QString &fileName, ImageExporter *exporter)
+{
+    SWG_TRACE_SCOPE("PlotWindow::saveToFileInBackground");
+
+    // Only the painter commands are recorded here, at the size of the widget as savePng does
+    QCustomPlot *plot = m_ui->widget_plot;
+    QPicture picture;
+    QCPPainter painter;
+    if (painter.begin(&picture))
+    {
+        plot->toPainter(&painter, plot->width(), plot->height());
+        painter.end();
+    }
+
+    exporter->setPicture(picture, plot->size());
+    exporter->setOutput(fileName, "PNG");
+    exporter->start();
+}
+
+bool PlotWindow::saveToVectorFile(const QString &fileName, VectorExporter::Format format, int resolution)
+{
+    SWG_TRACE_SCOPE("PlotWindow::saveToVectorFile");
+    return VectorExporter::save(m_ui->widget_plot, fileName, format, 0, 0, resolution);
+}
+
+PlotWindow::MemoryUsage PlotWindow::memoryUsage() const
+{
+    QCustomPlot *plot = m_ui->widget_plot;
+    MemoryUsage usage;
+    usage.graphData = m_streamGraph->memoryUsage();
+    for (int i = 0; i < plot->graphCount(); ++i)
+        usage.graphData += plot->graph(i)->dataMemoryUsage();
+    usage.streamBuffers = (qint64)(m_streamKeys.capacity() + m_streamValues.capacity()) * sizeof(double);
+    if (m_streamQueue != NULL)
+        usage.streamBuffers += (qint64)m_streamQueue->capacity() * 2 * sizeof(double);
+    usage.paintBuffers = plot->paintBufferMemoryUsage();
+    usage.labelCaches = plot->labelCacheMemoryUsage();
+    return usage;
+}
+
 QCPGraph::LineStyle PlotWindow::getLineStyle()
 {
     QCPGraph::LineStyle lineStyle = QCPGraph::lsNone;
@@ -48,17 +210,143 @@ QCPGraph::LineStyle PlotWindow::getLineStyle()
 
 void PlotWindow::loadEquation(SinusoidalEquation *equation)
 {
+    SWG_PERF_SCOPE("PlotWindow::loadEquation");
+    SWG_TRACE_SCOPE("PlotWindow::loadEquation");
+
+    // While streaming, only the parameters of the stream change
+    if (isStreaming())
+    {
+        configureStream(equation);
+        return;
+    }
+
+    closeWaveFile();
     if (m_ui->widget_plot->graphCount() > 0)
     {
+        // Keep the samples for the measurement cursor (implicitly shared, so no copy is made)
+        m_timeVector = equation->timeVector();
+        m_elongationVector = equation->elongationVector();
+        // Rate of the samples actually held, which is lower when the solve was decimated
+        m_samplingFrequency = equation->samplingFrequency() / equation->decimationFactor();
+        m_tracer->setVisible(false);
+        m_tracerLabel->setVisible(false);
         // Assign the data of the equation to the graph
-        m_ui->widget_plot->graph(0)->setData(equation->timeVector(), equation->elongationVector());
-        // Set axes ranges, so we see all data
+        m_ui->widget_plot->graph(0)->setData(m_timeVector, m_elongationVector);
+        // Set axes ranges, so we see all data, including the recording overlaid
         m_ui->widget_plot->graph(0)->rescaleAxes();
+        if (m_recordingGraph != NULL)
+            m_recordingGraph->rescaleAxes(true);
         // Refresh graph
         m_ui->widget_plot->replot();
     }
 }
 
+bool PlotWindow::loadWaveFile(const QString &fileName)
+{
+    SWG_TRACE_SCOPE("PlotWindow::loadWaveFile");
+
+    if (isStreaming() || m_ui->widget_plot->graphCount() == 0)
+        return false;
+    WaveFileReader *reader = new WaveFileReader();
+    if (!reader->open(fileName) || reader->chunks().isEmpty())
+    {
+        delete reader;
+        return false;
+    }
+    closeWaveFile();
+    m_waveFile = reader;
+
+    // Overview of the whole file from its index: one point per chunk for its minimum and its maximum
+    const QVector<WaveFile::ChunkSummary> &chunks = reader->chunks();
+    QVector<double> keys(chunks.size());
+    QVector<double> minima(chunks.size());
+    QVector<double> maxima(chunks.size());
+    double minimum = chunks.first().minimum;
+    double maximum = chunks.first().maximum;
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        keys[i] = 0.5 * (chunks.at(i).firstTime + chunks.at(i).lastTime);
+        minima[i] = chunks.at(i).minimum;
+        maxima[i] = chunks.at(i).maximum;
+        minimum = qMin(minimum, minima[i]);
+        maximum = qMax(maximum, maxima[i]);
+    }
+    QCustomPlot *plot = m_ui->widget_plot;
+    if (m_overviewMinGraph == NULL)
+    {
+        // Drawn on the grid layer, below the samples
+        QColor color = plot->graph(0)->pen().color();
+        m_overviewMinGraph = plot->addGraph();
+        m_overviewMaxGraph = plot->addGraph();
+        m_overviewMinGraph->setName("Overview minimum");
+        m_overviewMaxGraph->setName("Overview maximum");
+        m_overviewMinGraph->setLayer("grid");
+        m_overviewMaxGraph->setLayer("grid");
+        m_overviewMinGraph->setPen(QPen(color.lighter(150)));
+        m_overviewMaxGraph->setPen(QPen(color.lighter(150)));
+        color.setAlpha(60);
+        m_overviewMaxGraph->setBrush(QBrush(color));
+        m_overviewMaxGraph->setChannelFillGraph(m_overviewMinGraph);
+        m_overviewMinGraph->removeFromLegend();
+        m_overviewMaxGraph->removeFromLegend();
+    }
+    m_overviewMinGraph->setData(keys, minima);
+    m_overviewMaxGraph->setData(keys, maxima);
+    m_overviewMinGraph->setVisible(true);
+    m_overviewMaxGraph->setVisible(true);
+
+    // The samples are only read once zoomed in
+    hideMeasurementCursor();
+    m_timeVector.clear();
+    m_elongationVector.clear();
+    m_samplingFrequency = reader->parameters().samplingFrequency;
+    plot->graph(0)->clearData();
+    m_fileFirstChunk = -1;
+    m_fileChunkCount = 0;
+
+    // Show the whole file, and let the user drag and zoom the time axis
+    updateInteractions();
+    connect(plot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(onFileRangeChanged(QCPRange)));
+    double margin = qMax(0.05 * (maximum - minimum), 1e-9);
+    plot->yAxis->setRange(minimum - margin, maximum + margin);
+    plot->xAxis->setRange(chunks.first().firstTime, chunks.last().lastTime);
+    plot->replot();
+    return true;
+}
+
+void PlotWindow::showRecording(MappedWaveform *waveform, const QString &name)
+{
+    SWG_TRACE_SCOPE("PlotWindow::showRecording");
+
+    closeRecording();
+    QCustomPlot *plot = m_ui->widget_plot;
+    m_recordingGraph = new MappedGraph(plot->xAxis, plot->yAxis, waveform);
+    plot->addPlottable(m_recordingGraph);
+    m_recordingGraph->setPen(QPen(QColor(255, 128, 0)));
+    m_recordingGraph->setName(name);
+    m_recordingGraph->setVisible(!isStreaming());
+    connect(m_recordingGraph, SIGNAL(envelopeBuilt()), this, SLOT(onRecordingEnvelopeBuilt()));
+
+    // Show the whole recording along with what was already shown. Its value range is only known from
+    // the sample format until it has been read in the background
+    if (!isStreaming())
+        m_recordingGraph->rescaleAxes(true);
+    updateInteractions();
+    plot->replot();
+}
+
+void PlotWindow::closeRecording()
+{
+    if (m_recordingGraph == NULL)
+        return;
+
+    // The plot deletes the graph, which unmaps the file
+    m_ui->widget_plot->removePlottable(m_recordingGraph);
+    m_recordingGraph = NULL;
+    updateInteractions();
+    m_ui->widget_plot->replot();
+}
+
 void PlotWindow::changeLineStyle(QCPGraph::LineStyle style)
 {
     if (m_ui->widget_plot->graphCount() > 0)
@@ -73,11 +361,363 @@ void PlotWindow::changeColor(QColor &color)
     if (m_ui->widget_plot->graphCount() > 0)
     {
         m_ui->widget_plot->graph(0)->setPen(QPen(color));
+        m_streamGraph->setPen(QPen(color));
         m_ui->widget_plot->replot();
     }
 }
 
+void PlotWindow::startStreaming(SinusoidalEquation *equation)
+{
+    if (isStreaming())
+        return;
+
+    // Swap the finite graph for the streaming one
+    closeWaveFile();
+    hideMeasurementCursor();
+    if (m_ui->widget_plot->graphCount() > 0)
+        m_ui->widget_plot->graph(0)->setVisible(false);
+    if (m_recordingGraph != NULL)
+        m_recordingGraph->setVisible(false);
+    m_streamGraph->setVisible(true);
+
+    // Create the queue and the generator thread, and start drawing at display rate
+    if (m_streamQueue == NULL)
+        m_streamQueue = new SampleQueue(StreamQueueCapacity);
+    m_streamKeys.resize(m_streamQueue->capacity());
+    m_streamValues.resize(m_streamQueue->capacity());
+    m_streamGenerator = new StreamGenerator(m_streamQueue);
+    m_streamGraph->setCapacity(1);
+    configureStream(equation);
+    m_streamSamplesDrawn = 0;
+    m_streamDroppedFrames = 0;
+    m_streamGenerator->start(QThread::HighPriority);
+    m_streamFrameClock.start();
+    m_streamStatisticsClock.start();
+    m_streamTimer->start();
+}
+
+void PlotWindow::stopStreaming(SinusoidalEquation *equation)
+{
+    if (!isStreaming())
+        return;
+
+    // Stop the generator and throw away the samples it left in the queue
+    m_streamTimer->stop();
+    delete m_streamGenerator;
+    m_streamGenerator = NULL;
+    while (m_streamQueue->pop(m_streamKeys.data(), m_streamValues.data(), m_streamKeys.size()) > 0)
+        ;
+
+    // Swap the streaming graph for the finite one
+    m_streamGraph->setVisible(false);
+    m_streamGraph->clearData();
+    if (m_ui->widget_plot->graphCount() > 0)
+        m_ui->widget_plot->graph(0)->setVisible(true);
+    if (m_recordingGraph != NULL)
+        m_recordingGraph->setVisible(true);
+    loadEquation(equation);
+}
+
+void PlotWindow::configureTrigger(bool enabled, TriggerEngine::Slope slope, double level, double holdoff, double preTriggerRatio)
+{
+    m_trigger.setSlope(slope);
+    m_trigger.setLevel(level);
+    m_trigger.setHoldoff(holdoff);
+    if (enabled != m_triggerEnabled || preTriggerRatio != m_preTriggerRatio)
+    {
+        m_triggerEnabled = enabled;
+        m_preTriggerRatio = qBound(0.0, preTriggerRatio, 1.0);
+
+        // Start again from an empty sweep and graph
+        m_trigger.setSweepLength(m_streamGraph->capacity(), (int)(m_preTriggerRatio * m_streamGraph->capacity()));
+        m_streamGraph->clearData();
+    }
+}
+
+void PlotWindow::setPerformanceHudVisible(bool visible)
+{
+    if (visible)
+    {
+        m_hudReplotCount = PerfCounters::count("QCustomPlot::replot");
+        m_hudClock.start();
+        m_hudText->setText("Collecting...");
+        m_hudTimer->start();
+    }
+    else
+    {
+        m_hudTimer->stop();
+    }
+    m_hudText->setVisible(visible);
+    m_overlayLayer->replot();
+}
+
+void PlotWindow::onPlotMouseMoved(QMouseEvent *event)
+{
+    // The measurement cursor only works on the finite equation
+    if (isStreaming())
+        return;
+
+    QCPAxisRect *axisRect = m_ui->widget_plot->axisRect();
+    if (!axisRect->rect().contains(event->pos()))
+    {
+        hideMeasurementCursor();
+        return;
+    }
+
+    int index = nearestSampleIndex(m_ui->widget_plot->xAxis->pixelToCoord(event->pos().x()));
+    if (index < 0)
+        return;
+
+    // Move the cursor to the nearest sample and only repaint the overlay layer
+    m_tracer->position->setCoords(m_timeVector.at(index), m_elongationVector.at(index));
+    m_tracerLabel->setText(QString("time: %1 s\nelongation: %2").arg(m_timeVector.at(index), 0, 'g', 10).arg(m_elongationVector.at(index), 0, 'g', 10));
+    m_tracer->setVisible(true);
+    m_tracerLabel->setVisible(true);
+    m_overlayLayer->replot();
+}
+
+void PlotWindow::onStreamTimerTimeout()
+{
+    SWG_TRACE_SCOPE("PlotWindow::onStreamTimerTimeout");
+
+    // Count the frames missed since the previous one
+    qint64 frameTime = m_streamFrameClock.restart();
+    if (frameTime >= 2 * StreamFrameInterval)
+        m_streamDroppedFrames += (int)(frameTime / StreamFrameInterval) - 1;
+
+    // Move all the queued samples to the graph
+    int count = m_streamQueue->pop(m_streamKeys.data(), m_streamValues.data(), m_streamKeys.size());
+    if (m_triggerEnabled)
+    {
+        // Only draw the last complete sweep, if there is a new one
+        m_streamSamplesDrawn += count;
+        m_trigger.process(m_streamKeys.constData(), m_streamValues.constData(), count);
+        if (m_trigger.takeSweep())
+        {
+            const QVector<double> &keys = m_trigger.sweepKeys();
+            m_streamGraph->clearData();
+            m_streamGraph->addData(keys.constData(), m_trigger.sweepValues().constData(), keys.size());
+            m_ui->widget_plot->xAxis->setRange(keys.first(), keys.last());
+            m_ui->widget_plot->replot();
+        }
+    }
+    else if (count > 0)
+    {
+        m_streamGraph->addData(m_streamKeys.constData(), m_streamValues.constData(), count);
+        m_streamSamplesDrawn += count;
+
+        // Scroll so that the newest sample is at the right border
+        double lastKey = m_streamGraph->lastKey();
+        m_ui->widget_plot->xAxis->setRange(lastKey - m_streamWindowLength, lastKey);
+        m_ui->widget_plot->replot();
+    }
+
+    // Publish the counters once per second
+    qint64 elapsed = m_streamStatisticsClock.elapsed();
+    if (elapsed >= 1000)
+    {
+        double samplesPerSecond = m_streamSamplesDrawn * 1000.0 / elapsed;
+        emit streamStatisticsChanged(samplesPerSecond, m_streamQueue->size(), m_streamGenerator->droppedSamples(), m_streamDroppedFrames);
+        m_streamSamplesDrawn = 0;
+        m_streamStatisticsClock.restart();
+    }
+}
+
+void PlotWindow::onHudTimerTimeout()
+{
+    // Frames per second since the previous refresh
+    qint64 replotCount = PerfCounters::count("QCustomPlot::replot");
+    double fps = (replotCount - m_hudReplotCount) * 1000.0 / qMax(m_hudClock.restart(), (qint64)1);
+    m_hudReplotCount = replotCount;
+
+    // Points drawn in the last frame vs points held by the graph being shown
+    double pointsDrawn;
+    int pointsStored;
+    if (isStreaming())
+    {
+        pointsDrawn = PerfCounters::lastValue("StreamingGraph::draw points");
+        pointsStored = m_streamGraph->size();
+    }
+    else
+    {
+        pointsDrawn = PerfCounters::lastValue("QCPGraph::draw points");
+        pointsStored = (m_ui->widget_plot->graphCount() > 0) ? m_ui->widget_plot->graph(0)->data()->size() : 0;
+    }
+
+    QStringList lines;
+    lines << QString("FPS: %1").arg(fps, 0, 'f', 1);
+    lines << QString("points drawn/stored: %1/%2").arg(pointsDrawn, 0, 'f', 0).arg(pointsStored);
+    lines << QString("%1 %2 %3 %4").arg("[ms]", -34).arg("last", 8).arg("avg", 8).arg("p99", 8);
+    QVector<PerfCounters::Statistics> statistics = PerfCounters::statistics();
+    for (int i = 0; i < statistics.size(); ++i)
+    {
+        if (!statistics.at(i).isTiming)
+            continue;
+        lines << QString("%1 %2 %3 %4")
+                 .arg(statistics.at(i).name, -34)
+                 .arg(statistics.at(i).lastMs, 8, 'f', 2)
+                 .arg(statistics.at(i).averageMs, 8, 'f', 2)
+                 .arg(statistics.at(i).p99Ms, 8, 'f', 2);
+    }
+    m_hudText->setText(lines.join("\n"));
+    m_overlayLayer->replot();
+}
+
+void PlotWindow::onRecordingEnvelopeBuilt()
+{
+    if (m_recordingGraph == NULL || sender() != m_recordingGraph)
+        return;
+
+    double min = 0.0;
+    double max = 0.0;
+    if (!isStreaming() && !m_recordingGraph->waveform()->valueBounds(min, max))
+        m_recordingGraph->rescaleValueAxis(true);
+    m_ui->widget_plot->replot();
+}
+
+void PlotWindow::onFileRangeChanged(const QCPRange &range)
+{
+    SWG_TRACE_SCOPE("PlotWindow::onFileRangeChanged");
+
+    if (m_waveFile == NULL)
+        return;
+
+    // Chunks in view, found in the index by their time
+    const QVector<WaveFile::ChunkSummary> &chunks = m_waveFile->chunks();
+    int first = (int)(std::lower_bound(chunks.constBegin(), chunks.constEnd(), range.lower, chunkEndsBefore) - chunks.constBegin());
+    int end = (int)(std::upper_bound(chunks.constBegin(), chunks.constEnd(), range.upper, chunkStartsAfter) - chunks.constBegin());
+    qint64 samples = 0;
+    for (int i = first; i < end && samples <= FileDetailMaxSamples; ++i)
+        samples += chunks.at(i).count;
+
+    // Read the samples of those chunks if they are few enough, and otherwise only show the overview
+    if (end > first && samples <= FileDetailMaxSamples)
+    {
+        if (first == m_fileFirstChunk && end - first == m_fileChunkCount)
+            return;
+        if (m_waveFile->readChunks(first, end - first, m_timeVector, m_elongationVector))
+        {
+            m_ui->widget_plot->graph(0)->setData(m_timeVector, m_elongationVector);
+            m_fileFirstChunk = first;
+            m_fileChunkCount = end - first;
+            return;
+        }
+    }
+    if (m_fileChunkCount > 0 || !m_timeVector.isEmpty())
+    {
+        hideMeasurementCursor();
+        m_timeVector.clear();
+        m_elongationVector.clear();
+        m_ui->widget_plot->graph(0)->clearData();
+    }
+    m_fileFirstChunk = -1;
+    m_fileChunkCount = 0;
+}
+
 void PlotWindow::resizeEvent(QResizeEvent *event)
 {
     emit widgetResized(event->size());
 }
+
+bool PlotWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_ui->widget_plot && event->type() == QEvent::Leave)
+        hideMeasurementCursor();
+
+    return QWidget::eventFilter(watched, event);
+}
+
+int PlotWindow::nearestSampleIndex(double time) const
+{
+    int count = m_timeVector.size();
+    if (count == 0)
+        return -1;
+
+    int index;
+    if (m_samplingFrequency > 0.0)
+    {
+        // Uniformly sampled data: compute the index directly
+        double position = (time - m_timeVector.first()) * m_samplingFrequency;
+        index = (int)qBound(0.0, position + 0.5, (double)(count - 1));
+    }
+    else
+    {
+        // Otherwise search the first sample not before the given time
+        index = (int)(std::lower_bound(m_timeVector.constBegin(), m_timeVector.constEnd(), time) - m_timeVector.constBegin());
+        if (index >= count)
+            index = count - 1;
+    }
+
+    // Correct the accumulated rounding of the time samples by checking the neighbours
+    while (index > 0 && qAbs(m_timeVector.at(index - 1) - time) <= qAbs(m_timeVector.at(index) - time))
+        --index;
+    while (index < count - 1 && qAbs(m_timeVector.at(index + 1) - time) < qAbs(m_timeVector.at(index) - time))
+        ++index;
+
+    return index;
+}
+
+void PlotWindow::hideMeasurementCursor()
+{
+    if (m_tracer->visible())
+    {
+        m_tracer->setVisible(false);
+        m_tracerLabel->setVisible(false);
+        m_overlayLayer->replot();
+    }
+}
+
+void PlotWindow::closeWaveFile()
+{
+    if (m_waveFile == NULL)
+        return;
+
+    QCustomPlot *plot = m_ui->widget_plot;
+    disconnect(plot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(onFileRangeChanged(QCPRange)));
+    m_overviewMinGraph->clearData();
+    m_overviewMaxGraph->clearData();
+    m_overviewMinGraph->setVisible(false);
+    m_overviewMaxGraph->setVisible(false);
+    delete m_waveFile;
+    m_waveFile = NULL;
+    m_fileFirstChunk = -1;
+    m_fileChunkCount = 0;
+    updateInteractions();
+}
+
+void PlotWindow::updateInteractions()
+{
+    QCustomPlot *plot = m_ui->widget_plot;
+    if (m_waveFile != NULL || m_recordingGraph != NULL)
+    {
+        plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+        plot->axisRect()->setRangeDrag(Qt::Horizontal);
+        plot->axisRect()->setRangeZoom(Qt::Horizontal);
+    }
+    else
+    {
+        plot->setInteractions(QCP::Interactions());
+    }
+}
+
+void PlotWindow::configureStream(SinusoidalEquation *equation)
+{
+    m_streamGenerator->setParameters(equation->amplitude(), equation->oscillationFrequency(), equation->initialDelay(), equation->numberOfPeriods(),
+                                     equation->samplingFrequency(), equation->attenuationFactor());
+
+    // Show as many periods as the finite equation would, keeping enough samples to fill the window
+    m_streamWindowLength = equation->numberOfPeriods() / equation->oscillationFrequency();
+    double windowSamples = qMin(m_streamWindowLength * equation->samplingFrequency() + 1.0, (double)StreamGraphMaxCapacity);
+    int capacity = qMax((int)windowSamples, 2);
+    if (capacity != m_streamGraph->capacity())
+    {
+        m_streamGraph->setCapacity(capacity);
+        m_trigger.setSweepLength(capacity, (int)(m_preTriggerRatio * capacity));
+    }
+
+    // The wave never leaves the amplitude, so the value axis stays fixed
+    double amplitude = qAbs(equation->amplitude());
+    if (amplitude <= 0.0)
+        amplitude = 1.0;
+    m_ui->widget_plot->yAxis->setRange(-1.1 * amplitude, 1.1 * amplitude);
+}
@@ -2,8 +2,18 @@
 #define PLOTWINDOW_H
 
 #include <qcustomplot.h>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QWidget>
+#include "imageExporter.h"
+#include "mappedGraph.h"
+#include "sampleQueue.h"
 #include "sinusoidalEquation.h"
+#include "streamGenerator.h"
+#include "streamingGraph.h"
+#include "triggerEngine.h"
+#include "vectorExporter.h"
+#include "waveFile.h"
 
 
 namespace Ui {
@@ -18,6 +28,29 @@ class PlotWindow : public QWidget
     Q_OBJECT
 
 public:
+    /**
+     * @brief Memory held by the widget, in bytes.
+     */
+    struct MemoryUsage
+    {
+        /**
+         * @brief Data containers of the graphs, including the ring buffer of the streaming graph.
+         */
+        qint64 graphData;
+        /**
+         * @brief Sample queue and scratch buffers of the stream.
+         */
+        qint64 streamBuffers;
+        /**
+         * @brief Paint buffers of the plot and of its buffered layers.
+         */
+        qint64 paintBuffers;
+        /**
+         * @brief Cached tick label pixmaps, glyphs and formatted numbers.
+         */
+        qint64 labelCaches;
+    };
+
     /**
      * @brief Constructor.
      * @param parent Parent widget.
@@ -33,11 +66,58 @@ public:
      * @return true if the file is correctly saved, or false otherwise.
      */
     bool saveToFile(QString &fileName);
+    /**
+     * @brief Starts saving the graph to a PNG file without blocking. The drawing is recorded at once,
+     * and rendered and encoded by the exporter in its thread.
+     * @param fileName Full path of the file where the graph will be saved.
+     * @param exporter Exporter that saves the image, which must not be running. It is started here.
+     */
+    void saveToFileInBackground(const QString &fileName, ImageExporter *exporter);
+    /**
+     * @brief Saves the graph to a vector document, decimating dense graphs to its resolution.
+     * @param fileName Full path of the file where the graph will be saved.
+     * @param format Format of the document.
+     * @param resolution Resolution of the document, in dots per inch.
+     * @return true if the file is correctly saved, or false otherwise.
+     */
+    bool saveToVectorFile(const QString &fileName, VectorExporter::Format format, int resolution);
     /**
      * @brief Gets the line style used to draw the graph.
      * @return Line style currently being used.
      */
     QCPGraph::LineStyle getLineStyle();
+    /**
+     * @brief Gets whether the widget is showing a continuous stream of samples.
+     * @return true if streaming, or false if showing a finite equation.
+     */
+    bool isStreaming() { return m_streamGenerator != NULL; }
+    /**
+     * @brief Gets the memory held by the graphs, the stream and the drawing caches.
+     * @return Bytes held by each of them.
+     */
+    MemoryUsage memoryUsage() const;
+    /**
+     * @brief Shows a waveform file instead of the equation. The whole file is shown as the band between
+     * the minimum and maximum of each chunk, taken from its index, and the samples of the chunks in view
+     * are read and drawn once they are few enough. The time axis can be dragged and zoomed with the mouse.
+     * Loading an equation or starting a stream closes the file.
+     * @param fileName Full path of the file.
+     * @return true if the file is shown, or false if it could not be read or a stream is running.
+     */
+    bool loadWaveFile(const QString &fileName);
+    /**
+     * @brief Overlays a recorded waveform on the equation, drawn from its mapping without copying its
+     * samples. It stays over the equations loaded afterwards until closed, and is hidden while streaming.
+     * The time axis can be dragged and zoomed with the mouse.
+     * @param waveform Mapped samples of the recording. The widget takes its ownership.
+     * @param name Name of the recording.
+     */
+    void showRecording(MappedWaveform *waveform, const QString &name);
+    /**
+     * @brief Gets whether a recording is overlaid.
+     * @return true if there is a recording, or false otherwise.
+     */
+    bool hasRecording() const { return m_recordingGraph != NULL; }
 
 signals:
     /**
@@ -45,6 +125,14 @@ signals:
      * @param size New size.
      */
     void widgetResized(const QSize &size);
+    /**
+     * @brief Signal emitted once per second while streaming, with the performance counters of the stream.
+     * @param samplesPerSecond Samples drawn per second during the last interval.
+     * @param queueDepth Samples waiting in the queue between the generator and the widget.
+     * @param droppedSamples Samples discarded since the stream started because the queue was full.
+     * @param droppedFrames Display frames missed since the stream started because drawing took too long.
+     */
+    void streamStatisticsChanged(double samplesPerSecond, int queueDepth, qint64 droppedSamples, int droppedFrames);
 
 public slots:
     /**
@@ -62,6 +150,63 @@ public slots:
      * @param color New color.
      */
     void changeColor(QColor &color);
+    /**
+     * @brief Starts showing a continuous stream of samples of the equation, scrolling in real time.
+     * The window shows as many periods as the number of periods of the equation.
+     * @param equation Equation whose parameters are used to generate the samples.
+     */
+    void startStreaming(SinusoidalEquation *equation);
+    /**
+     * @brief Stops the stream of samples and shows the finite equation again.
+     * @param equation Equation to be drawn.
+     */
+    void stopStreaming(SinusoidalEquation *equation);
+    /**
+     * @brief Changes the trigger used in streaming mode. When enabled, only complete sweeps starting
+     * at a trigger are drawn, with the time relative to the trigger, instead of the scrolling window.
+     * @param enabled Whether the trigger is enabled.
+     * @param slope Slope of the signal that fires the trigger.
+     * @param level Elongation the signal has to cross to fire the trigger.
+     * @param holdoff Minimum time between two triggers, in seconds.
+     * @param preTriggerRatio Fraction of the sweep before the trigger, between 0 and 1.
+     */
+    void configureTrigger(bool enabled, TriggerEngine::Slope slope, double level, double holdoff, double preTriggerRatio);
+    /**
+     * @brief Shows or hides the performance overlay: timings of the hot paths, points drawn and stored, and FPS.
+     * The timings are only available when the application is built with CONFIG += perf_counters.
+     * @param visible Whether the overlay is shown.
+     */
+    void setPerformanceHudVisible(bool visible);
+    /**
+     * @brief Removes the overlaid recording, if any, and unmaps its file.
+     */
+    void closeRecording();
+
+private slots:
+    /**
+     * @brief Handles the event fired when the mouse moves over the plot, moving the measurement cursor to the nearest sample.
+     * @param event Event parameters.
+     */
+    void onPlotMouseMoved(QMouseEvent *event);
+    /**
+     * @brief Handles the display timer while streaming: moves the queued samples to the graph and redraws it.
+     */
+    void onStreamTimerTimeout();
+    /**
+     * @brief Handles the refresh timer of the performance overlay.
+     */
+    void onHudTimerTimeout();
+    /**
+     * @brief Handles the event fired when the visible time range changes while showing a waveform file,
+     * reading the samples of the chunks in view if they are few enough.
+     * @param range New time range.
+     */
+    void onFileRangeChanged(const QCPRange &range);
+    /**
+     * @brief Handles the end of the reading of the overlaid recording: fits the value axis to it if its
+     * samples had no known bounds, and draws all of it.
+     */
+    void onRecordingEnvelopeBuilt();
 
 protected:
     /**
@@ -69,12 +214,185 @@ protected:
      * @param event Event parameters.
      */
     void resizeEvent(QResizeEvent *event);
+    /**
+     * @brief Overrides the eventFilter method to hide the measurement cursor when the mouse leaves the plot.
+     * @param watched Object that received the event.
+     * @param event Event parameters.
+     * @return true if the event has been handled, or false otherwise.
+     */
+    bool eventFilter(QObject *watched, QEvent *event);
 
 private:
+    /**
+     * @brief Interval between display frames while streaming, in milliseconds.
+     */
+    static const int StreamFrameInterval = 16;
+    /**
+     * @brief Minimum number of samples the queue between the generator and the widget can hold.
+     */
+    static const int StreamQueueCapacity = 1 << 20;
+    /**
+     * @brief Maximum number of samples kept in the streaming graph.
+     */
+    static const int StreamGraphMaxCapacity = 1 << 22;
+    /**
+     * @brief Interval between refreshes of the performance overlay, in milliseconds.
+     */
+    static const int HudRefreshInterval = 500;
+    /**
+     * @brief Maximum number of samples of a waveform file read and drawn at once.
+     */
+    static const int FileDetailMaxSamples = 1 << 20;
+
+    /**
+     * @brief Finds the sample whose time is nearest to the given one.
+     * Uses index arithmetic for uniformly sampled data, or a binary search otherwise.
+     * @param time Time value, in seconds.
+     * @return Index of the nearest sample, or -1 if there is no data.
+     */
+    int nearestSampleIndex(double time) const;
+    /**
+     * @brief Hides the measurement cursor and refreshes the overlay layer.
+     */
+    void hideMeasurementCursor();
+    /**
+     * @brief Applies the parameters of the equation to the running stream and resizes the visible window.
+     * @param equation Equation whose parameters are used.
+     */
+    void configureStream(SinusoidalEquation *equation);
+    /**
+     * @brief Stops showing the waveform file, if any.
+     */
+    void closeWaveFile();
+    /**
+     * @brief Enables dragging and zooming the time axis with the mouse while a file is shown.
+     */
+    void updateInteractions();
+
     /**
      * @brief Widget's user interface definition.
      */
     Ui::PlotWindow *m_ui;
+    /**
+     * @brief Layer with its own paint buffer, where the measurement cursor is drawn.
+     */
+    QCPLayer *m_overlayLayer;
+    /**
+     * @brief Tracer that marks the sample nearest to the mouse.
+     */
+    QCPItemTracer *m_tracer;
+    /**
+     * @brief Text that shows the time and elongation of the traced sample.
+     */
+    QCPItemText *m_tracerLabel;
+    /**
+     * @brief Time samples of the equation currently drawn, in seconds.
+     */
+    QVector<double> m_timeVector;
+    /**
+     * @brief Elongation samples of the equation currently drawn.
+     */
+    QVector<double> m_elongationVector;
+    /**
+     * @brief Sampling frequency of the data currently drawn, in hertz, or 0 if it is not uniformly sampled.
+     */
+    double m_samplingFrequency;
+    /**
+     * @brief Queue of samples from the stream generator to the widget.
+     */
+    SampleQueue *m_streamQueue;
+    /**
+     * @brief Thread that generates the stream of samples, or NULL if not streaming.
+     */
+    StreamGenerator *m_streamGenerator;
+    /**
+     * @brief Graph that shows the most recent samples of the stream.
+     */
+    StreamingGraph *m_streamGraph;
+    /**
+     * @brief Timer that redraws the stream at display rate.
+     */
+    QTimer *m_streamTimer;
+    /**
+     * @brief Buffer where the keys are taken out of the queue.
+     */
+    QVector<double> m_streamKeys;
+    /**
+     * @brief Buffer where the values are taken out of the queue.
+     */
+    QVector<double> m_streamValues;
+    /**
+     * @brief Length of the visible window of the stream, in seconds.
+     */
+    double m_streamWindowLength;
+    /**
+     * @brief Measures the time between display frames.
+     */
+    QElapsedTimer m_streamFrameClock;
+    /**
+     * @brief Measures the interval over which the throughput is computed.
+     */
+    QElapsedTimer m_streamStatisticsClock;
+    /**
+     * @brief Samples drawn since the throughput was last computed.
+     */
+    qint64 m_streamSamplesDrawn;
+    /**
+     * @brief Display frames missed since the stream started.
+     */
+    int m_streamDroppedFrames;
+    /**
+     * @brief Trigger that cuts sweeps out of the stream.
+     */
+    TriggerEngine m_trigger;
+    /**
+     * @brief Whether the stream is drawn as triggered sweeps instead of a scrolling window.
+     */
+    bool m_triggerEnabled;
+    /**
+     * @brief Fraction of the sweep before the trigger.
+     */
+    double m_preTriggerRatio;
+    /**
+     * @brief Text of the performance overlay, drawn on the overlay layer.
+     */
+    QCPItemText *m_hudText;
+    /**
+     * @brief Timer that refreshes the performance overlay.
+     */
+    QTimer *m_hudTimer;
+    /**
+     * @brief Measures the interval over which the FPS are computed.
+     */
+    QElapsedTimer m_hudClock;
+    /**
+     * @brief Number of replots when the FPS were last computed.
+     */
+    qint64 m_hudReplotCount;
+    /**
+     * @brief Waveform file being shown, or NULL if showing the equation or a stream.
+     */
+    WaveFileReader *m_waveFile;
+    /**
+     * @brief Graph of the minimum of each chunk of the waveform file.
+     */
+    QCPGraph *m_overviewMinGraph;
+    /**
+     * @brief Graph of the maximum of each chunk of the waveform file, filled down to the minimum.
+     */
+    QCPGraph *m_overviewMaxGraph;
+    /**
+     * @brief First chunk of the waveform file whose samples are drawn.
+     */
+    int m_fileFirstChunk;
+    /**
+     * @brief Number of chunks of the waveform file whose samples are drawn.
+     */
+    int m_fileChunkCount;
+    /**
+     * @brief Graph of the overlaid recording, or NULL if there is none.
+     */
+    MappedGraph *m_recordingGraph;
 };
 
 #endif // PLOTWINDOW_H
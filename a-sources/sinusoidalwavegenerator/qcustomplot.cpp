@@ -25,6 +25,22 @@
 
 #include "qcustomplot.h"
 
+// Hot-path timers of the application, only available when building it with CONFIG += perf_counters
+#ifdef SWG_PERF_COUNTERS
+#  include "perfCounters.h"
+#else
+#  define SWG_PERF_SCOPE(name)
+#  define SWG_PERF_VALUE(name, value)
+#endif
+
+// Timeline events of the application, only available when building it with CONFIG += tracing
+#ifdef SWG_TRACING
+#  include "traceRecorder.h"
+#else
+#  define SWG_TRACE_SCOPE(name)
+#  define SWG_TRACE_SCOPE_ARG(name, argument)
+#endif
+
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -741,7 +757,8 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mParentPlot(parentPlot),
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
-  mVisible(true)
+  mVisible(true),
+  mMode(lmLogical)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -774,6 +791,95 @@ void QCPLayer::setVisible(bool visible)
   mVisible = visible;
 }
 
+/*!
+  Sets how this layer is rendered when the parent plot is replotted.
+  
+  In the default mode \ref lmLogical, the layer is drawn into the main paint buffer of the plot,
+  together with all other logical layers.
+  
+  In \ref lmBuffered mode, the layer is drawn into its own paint buffer, which is composited above
+  the main paint buffer when the widget is painted. Such a layer can be refreshed on its own with
+  \ref replot, without redrawing any of the other layers. This is useful for layers that change
+  frequently and contain only cheap objects, like a tracer following the mouse cursor.
+  
+  Note that buffered layers are always shown above all logical layers, regardless of their index.
+  Exports like \ref QCustomPlot::savePng draw all layers in the order of their index.
+  
+  The new mode takes effect on the next \ref QCustomPlot::replot.
+*/
+void QCPLayer::setMode(QCPLayer::LayerMode mode)
+{
+  mMode = mode;
+}
+
+/*!
+  If the layer mode (\ref setMode) is \ref lmBuffered, redraws only the layerables on this layer
+  into the paint buffer of the layer and schedules a repaint of the parent plot. The layout and the
+  other layers are not updated, so this requires a prior \ref QCustomPlot::replot.
+  
+  If the layer mode is \ref lmLogical, this calls \ref QCustomPlot::replot of the parent plot.
+*/
+void QCPLayer::replot()
+{
+  if (mMode == lmBuffered && !mParentPlot->mReplotting)
+  {
+    drawToPaintBuffer();
+    mParentPlot->update();
+  } else
+    mParentPlot->replot();
+}
+
+/*!
+  Returns the number of bytes held by the paint buffer of this layer. Only layers in \ref lmBuffered
+  mode have a paint buffer, for all other layers this returns 0.
+  
+  \see QCustomPlot::paintBufferMemoryUsage
+*/
+qint64 QCPLayer::memoryUsage() const
+{
+  return (qint64)mPaintBuffer.width()*mPaintBuffer.height()*mPaintBuffer.depth()/8;
+}
+
+/*! \internal
+  
+  Draws all visible layerables on this layer with \a painter, in the order of \ref children.
+*/
+void QCPLayer::draw(QCPPainter *painter)
+{
+  foreach (QCPLayerable *child, mChildren)
+  {
+    if (child->realVisibility())
+    {
+      painter->save();
+      painter->setClipRect(child->clipRect().translated(0, -1));
+      child->applyDefaultAntialiasingHint(painter);
+      child->draw(painter);
+      painter->restore();
+    }
+  }
+}
+
+/*! \internal
+  
+  Clears the paint buffer of this layer, resizing it to the size of the main paint buffer of the
+  parent plot if necessary, and draws the layerables into it. Used for layers in \ref lmBuffered
+  mode.
+*/
+void QCPLayer::drawToPaintBuffer()
+{
+  if (mPaintBuffer.size() != mParentPlot->mPaintBuffer.size())
+    mPaintBuffer = QPixmap(mParentPlot->mPaintBuffer.size());
+  mPaintBuffer.fill(Qt::transparent);
+  QCPPainter painter;
+  painter.begin(&mPaintBuffer);
+  if (painter.isActive())
+  {
+    painter.setRenderHint(QPainter::HighQualityAntialiasing);
+    draw(&painter);
+    painter.end();
+  }
+}
+
 /*! \internal
   
   Adds the \a layerable to the list of this layer. If \a prepend is set to true, the layerable will
@@ -4045,6 +4151,11 @@ QCPAxis::QCPAxis(QCPAxisRect *parent, AxisType type) :
   mAxisPainter(new QCPAxisPainterPrivate(parent->parentPlot())),
   mLowestVisibleTick(0),
   mHighestVisibleTick(-1),
+  mTickVectorStepIndexed(false),
+  mTickVectorFirstStep(0),
+  mCachedTickLabelsFirstStep(0),
+  mCachedTickLabelsStep(0),
+  mCachedTickLabelsPrecision(0),
   mCachedMarginValid(false),
   mCachedMargin(0)
 {
@@ -5476,6 +5587,21 @@ QList<QCPAbstractItem*> QCPAxis::items() const
   return result;
 }
 
+/*!
+  Returns the number of bytes held by the caches of the tick labels of this axis: the rendered label
+  pixmaps and the formatted number labels that are reused across pans.
+  
+  \see QCustomPlot::labelCacheMemoryUsage
+*/
+qint64 QCPAxis::labelCacheMemoryUsage() const
+{
+  qint64 result = mAxisPainter->labelCacheMemoryUsage();
+  result += (qint64)mCachedTickLabels.capacity()*sizeof(QString);
+  for (int i=0; i<mCachedTickLabels.size(); ++i)
+    result += (qint64)mCachedTickLabels.at(i).capacity()*sizeof(QChar);
+  return result;
+}
+
 /*!
   Transforms a margin side to the logically corresponding axis type. (QCP::msLeft to
   QCPAxis::atLeft, QCP::msRight to QCPAxis::atRight, etc.)
@@ -5522,6 +5648,7 @@ void QCPAxis::setupTickVectors()
   if ((!mTicks && !mTickLabels && !mGrid->visible()) || mRange.size() <= 0) return;
   
   // fill tick vectors, either by auto generating or by notifying user to fill the vectors himself
+  mTickVectorStepIndexed = false;
   if (mAutoTicks)
   {
     generateAutoTicks();
@@ -5575,8 +5702,33 @@ void QCPAxis::setupTickVectors()
     mTickVectorLabels.resize(vecsize);
     if (mTickLabelType == ltNumber)
     {
+      // while panning, the tick step stays the same and most ticks were already labeled in the last
+      // call. Reuse those labels by their step index and only format the newly exposed ticks:
+      bool reuseLabels = mTickVectorStepIndexed &&
+          mCachedTickLabelsStep == mTickStep &&
+          mCachedTickLabelsFormatChar == mNumberFormatChar &&
+          mCachedTickLabelsPrecision == mNumberPrecision &&
+          mCachedTickLabelsLocale == mParentPlot->locale();
       for (int i=mLowestVisibleTick; i<=mHighestVisibleTick; ++i)
-        mTickVectorLabels[i] = mParentPlot->locale().toString(mTickVector.at(i), mNumberFormatChar.toLatin1(), mNumberPrecision);
+      {
+        qint64 cacheIndex = mTickVectorFirstStep+i-mCachedTickLabelsFirstStep;
+        if (reuseLabels && cacheIndex >= 0 && cacheIndex < mCachedTickLabels.size() && !mCachedTickLabels.at((int)cacheIndex).isEmpty())
+          mTickVectorLabels[i] = mCachedTickLabels.at((int)cacheIndex);
+        else
+          mTickVectorLabels[i] = mParentPlot->locale().toString(mTickVector.at(i), mNumberFormatChar.toLatin1(), mNumberPrecision);
+      }
+      if (mTickVectorStepIndexed)
+      {
+        // the cache only covers the visible ticks, so labels of ticks that left the range are dropped:
+        mCachedTickLabels.fill(QString(), vecsize);
+        for (int i=mLowestVisibleTick; i<=mHighestVisibleTick; ++i)
+          mCachedTickLabels[i] = mTickVectorLabels.at(i);
+        mCachedTickLabelsFirstStep = mTickVectorFirstStep;
+        mCachedTickLabelsStep = mTickStep;
+        mCachedTickLabelsFormatChar = mNumberFormatChar;
+        mCachedTickLabelsPrecision = mNumberPrecision;
+        mCachedTickLabelsLocale = mParentPlot->locale();
+      }
     } else if (mTickLabelType == ltDateTime)
     {
       for (int i=mLowestVisibleTick; i<=mHighestVisibleTick; ++i)
@@ -5639,6 +5791,8 @@ void QCPAxis::generateAutoTicks()
     mTickVector.resize(tickcount);
     for (int i=0; i<tickcount; ++i)
       mTickVector[i] = (firstStep+i)*mTickStep;
+    mTickVectorFirstStep = firstStep;
+    mTickVectorStepIndexed = true;
   } else // mScaleType == stLogarithmic
   {
     // Generate tick positions according to logbase scaling:
@@ -6044,6 +6198,166 @@ QCP::Interaction QCPAxis::selectionCategory() const
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGlyphAtlas
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGlyphAtlas
+
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It holds the glyphs that typically make up numeric tick labels (digits, signs, decimal
+  separators, the exponent character and the multiplication signs of beautiful powers), rendered
+  once per font and color into a single pixmap. Labels that only consist of these characters can
+  then be measured and drawn by blitting glyphs from the atlas, without shaping and rasterizing
+  text on every replot.
+  
+  One atlas is shared by all axes of a QCustomPlot. Kerning is not applied when composing labels,
+  which for the digit glyphs of common fonts makes no visible difference.
+*/
+
+/*!
+  Constructs an empty glyph atlas. The glyphs of a font are rendered the first time a text with that
+  font is measured or drawn.
+*/
+QCPGlyphAtlas::QCPGlyphAtlas() :
+  mCharacters(QLatin1String("0123456789+-.,eE ")),
+  mMetrics(8), // cache at most 8 fonts
+  mAtlases(8) // cache at most 8 font/color combinations
+{
+  mCharacters.append(QChar(215)); // multiplication cross of beautiful powers
+  mCharacters.append(QChar(183)); // multiplication dot of beautiful powers
+  mCharacters.append(QChar(0x2212)); // minus sign
+}
+
+/*!
+  Returns whether all characters of \a text are available in the atlas.
+*/
+bool QCPGlyphAtlas::canCompose(const QString &text) const
+{
+  for (int i=0; i<text.size(); ++i)
+  {
+    if (!mCharacters.contains(text.at(i)))
+      return false;
+  }
+  return !text.isEmpty();
+}
+
+/*!
+  Returns the size of \a text when drawn with \a font, consisting of the summed advances of its
+  glyphs and the line height of the font. \a text must satisfy \ref canCompose.
+*/
+QSize QCPGlyphAtlas::textSize(const QFont &font, const QString &text)
+{
+  GlyphMetrics *metrics = glyphMetrics(font);
+  int width = 0;
+  for (int i=0; i<text.size(); ++i)
+    width += metrics->advances.value(text.at(i));
+  return QSize(width, metrics->height);
+}
+
+/*!
+  Draws \a text with \a font and the pen color of \a painter, such that the top left corner of the
+  text line is at \a topLeft. \a text must satisfy \ref canCompose.
+*/
+void QCPGlyphAtlas::drawText(QCPPainter *painter, const QPointF &topLeft, const QFont &font, const QString &text)
+{
+  FontAtlas *atlas = fontAtlas(font, painter->pen().color());
+  double x = topLeft.x();
+  for (int i=0; i<text.size(); ++i)
+  {
+    const Glyph &glyph = atlas->glyphs[text.at(i)];
+    painter->drawPixmap(QPointF(x, topLeft.y())-glyph.origin, atlas->pixmap, glyph.source);
+    x += glyph.advance;
+  }
+}
+
+/*!
+  Returns the number of bytes held by the rendered glyph pixmaps of all cached fonts and colors.
+*/
+qint64 QCPGlyphAtlas::memoryUsage() const
+{
+  qint64 result = 0;
+  foreach (const QString &key, mAtlases.keys())
+  {
+    const QPixmap &pixmap = mAtlases.object(key)->pixmap;
+    result += (qint64)pixmap.width()*pixmap.height()*pixmap.depth()/8;
+  }
+  return result;
+}
+
+/*! \internal
+  
+  Returns the advances of the atlas characters and the line height for \a font, calculating them
+  if the font isn't cached yet.
+*/
+QCPGlyphAtlas::GlyphMetrics *QCPGlyphAtlas::glyphMetrics(const QFont &font)
+{
+  QString key = font.toString();
+  GlyphMetrics *metrics = mMetrics.object(key);
+  if (!metrics)
+  {
+    metrics = new GlyphMetrics;
+    QFontMetrics fontMetrics(font);
+    for (int i=0; i<mCharacters.size(); ++i)
+      metrics->advances.insert(mCharacters.at(i), fontMetrics.width(mCharacters.at(i)));
+    metrics->height = fontMetrics.height();
+    mMetrics.insert(key, metrics);
+  }
+  return metrics;
+}
+
+/*! \internal
+  
+  Returns the atlas for \a font and \a color, rendering all glyphs into a new atlas pixmap if the
+  combination isn't cached yet. Each glyph cell is padded, so glyphs extending beyond their advance
+  (negative bearings, antialiasing) are not cut off.
+*/
+QCPGlyphAtlas::FontAtlas *QCPGlyphAtlas::fontAtlas(const QFont &font, const QColor &color)
+{
+  QString key = font.toString()+color.name()+QString::number(color.alpha(), 16);
+  FontAtlas *atlas = mAtlases.object(key);
+  if (!atlas)
+  {
+    atlas = new FontAtlas;
+    QFontMetrics fontMetrics(font);
+    const int padding = 2;
+    const int cellHeight = fontMetrics.height()+2*padding;
+    // lay out glyph cells in a single row:
+    int atlasWidth = 0;
+    for (int i=0; i<mCharacters.size(); ++i)
+    {
+      const QChar c = mCharacters.at(i);
+      QRect inkBounds = fontMetrics.boundingRect(c);
+      Glyph glyph;
+      glyph.advance = fontMetrics.width(c);
+      glyph.origin = QPoint(padding-qMin(0, inkBounds.left()), padding);
+      int cellWidth = glyph.origin.x()+qMax(glyph.advance, inkBounds.right()+1)+padding;
+      glyph.source = QRect(atlasWidth, 0, cellWidth, cellHeight);
+      atlas->glyphs.insert(c, glyph);
+      atlasWidth += cellWidth;
+    }
+    // render glyphs:
+    atlas->pixmap = QPixmap(atlasWidth, cellHeight);
+    atlas->pixmap.fill(Qt::transparent);
+    QCPPainter atlasPainter(&atlas->pixmap);
+    atlasPainter.setFont(font);
+    atlasPainter.setPen(color);
+    for (int i=0; i<mCharacters.size(); ++i)
+    {
+      const Glyph &glyph = atlas->glyphs[mCharacters.at(i)];
+      atlasPainter.drawText(glyph.source.topLeft()+glyph.origin+QPoint(0, fontMetrics.ascent()), QString(mCharacters.at(i)));
+    }
+    atlasPainter.end();
+    mAtlases.insert(key, atlas);
+  }
+  return atlas;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPAxisPainterPrivate
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -6337,6 +6651,21 @@ void QCPAxisPainterPrivate::clearCache()
   mLabelCache.clear();
 }
 
+/*! \internal
+  
+  Returns the number of bytes held by the label pixmaps in the internal label cache.
+*/
+qint64 QCPAxisPainterPrivate::labelCacheMemoryUsage() const
+{
+  qint64 result = 0;
+  foreach (const QString &key, mLabelCache.keys())
+  {
+    const QPixmap &pixmap = mLabelCache.object(key)->pixmap;
+    result += (qint64)pixmap.width()*pixmap.height()*pixmap.depth()/8;
+  }
+  return result;
+}
+
 /*! \internal
   
   Returns a hash that allows uniquely identifying whether the label parameters have changed such
@@ -6388,7 +6717,9 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
     case QCPAxis::atTop:    labelAnchor = QPointF(position, axisRect.top()-distanceToAxis-offset); break;
     case QCPAxis::atBottom: labelAnchor = QPointF(position, axisRect.bottom()+distanceToAxis+offset); break;
   }
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
+  bool cachingEnabled = mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching);
+  bool glyphAtlasEnabled = cachingEnabled && !painter->modes().testFlag(QCPPainter::pmVectorized) && useGlyphAtlas(text);
+  if (cachingEnabled && !glyphAtlasEnabled) // label caching enabled, and label can't be composed from glyph atlas
   {
     CachedLabel *cachedLabel = mLabelCache.take(text); // attempt to get label from cache
     if (!cachedLabel)  // no cached label existed, create it
@@ -6417,7 +6748,7 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
       finalSize = cachedLabel->pixmap.size();
     }
     mLabelCache.insert(text, cachedLabel); // return label to cache or insert for the first time if newly created
-  } else // label caching disabled, draw text directly on surface:
+  } else // label caching disabled or label composed from glyph atlas, draw text directly on surface:
   {
     TickLabelData labelData = getTickLabelData(painter->font(), text);
     QPointF finalPosition = labelAnchor + getTickLabelDrawOffset(labelData);
@@ -6432,7 +6763,10 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
     }
     if (!labelClippedByBorder)
     {
-      drawTickLabel(painter, finalPosition.x(), finalPosition.y(), labelData);
+      if (glyphAtlasEnabled)
+        drawTickLabelGlyphs(painter, finalPosition.x(), finalPosition.y(), labelData);
+      else
+        drawTickLabel(painter, finalPosition.x(), finalPosition.y(), labelData);
       finalSize = labelData.rotatedTotalBounds.size();
     }
   }
@@ -6482,6 +6816,39 @@ void QCPAxisPainterPrivate::drawTickLabel(QCPPainter *painter, double x, double
   painter->setFont(oldFont);
 }
 
+/*! \internal
+  
+  This is a \ref placeTickLabel helper function.
+  
+  Draws the tick label specified in \a labelData with \a painter at the pixel positions \a x and \a
+  y, by composing it from the glyph atlas of the parent plot. It produces the same layout as \ref
+  drawTickLabel, and is used instead of it for labels that satisfy \ref useGlyphAtlas.
+*/
+void QCPAxisPainterPrivate::drawTickLabelGlyphs(QCPPainter *painter, double x, double y, const TickLabelData &labelData) const
+{
+  QCPGlyphAtlas *atlas = mParentPlot->mGlyphAtlas;
+  atlas->drawText(painter, QPointF(x, y), labelData.baseFont, labelData.basePart);
+  if (!labelData.expPart.isEmpty()) // indicator that beautiful powers must be used
+    atlas->drawText(painter, QPointF(x+labelData.baseBounds.width()+1, y), labelData.expFont, labelData.expPart);
+}
+
+/*! \internal
+  
+  Returns whether the tick label \a text is measured and drawn with the glyph atlas of the parent
+  plot (see \ref QCPGlyphAtlas), instead of being rendered into an individual cached pixmap. This
+  is the case for unrotated labels that only consist of atlas characters, if label caching is
+  enabled (\ref QCP::phCacheLabels) and the plot is drawn by a painter that is neither in \ref
+  QCPPainter::pmVectorized nor in \ref QCPPainter::pmNoCaching mode. Otherwise the labels are
+  measured with QFontMetrics, like the text drawn for them.
+*/
+bool QCPAxisPainterPrivate::useGlyphAtlas(const QString &text) const
+{
+  return mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) &&
+         mParentPlot->mGlyphAtlasPainter &&
+         qFuzzyIsNull(tickLabelRotation) &&
+         mParentPlot->mGlyphAtlas->canCompose(text);
+}
+
 /*! \internal
   
   This is a \ref placeTickLabel helper function.
@@ -6530,13 +6897,23 @@ QCPAxisPainterPrivate::TickLabelData QCPAxisPainterPrivate::getTickLabelData(con
     else
       result.expFont.setPixelSize(result.expFont.pixelSize()*0.75);
     // calculate bounding rects of base part, exponent part and total one:
-    result.baseBounds = QFontMetrics(result.baseFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip, result.basePart);
-    result.expBounds = QFontMetrics(result.expFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip, result.expPart);
+    if (useGlyphAtlas(result.basePart+result.expPart))
+    {
+      result.baseBounds = QRect(QPoint(0, 0), mParentPlot->mGlyphAtlas->textSize(result.baseFont, result.basePart));
+      result.expBounds = QRect(QPoint(0, 0), mParentPlot->mGlyphAtlas->textSize(result.expFont, result.expPart));
+    } else
+    {
+      result.baseBounds = QFontMetrics(result.baseFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip, result.basePart);
+      result.expBounds = QFontMetrics(result.expFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip, result.expPart);
+    }
     result.totalBounds = result.baseBounds.adjusted(0, 0, result.expBounds.width()+2, 0); // +2 consists of the 1 pixel spacing between base and exponent (see drawTickLabel) and an extra pixel to include AA
   } else // useBeautifulPowers == false
   {
     result.basePart = text;
-    result.totalBounds = QFontMetrics(result.baseFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip | Qt::AlignHCenter, result.basePart);
+    if (useGlyphAtlas(result.basePart))
+      result.totalBounds = QRect(QPoint(0, 0), mParentPlot->mGlyphAtlas->textSize(result.baseFont, result.basePart));
+    else
+      result.totalBounds = QFontMetrics(result.baseFont).boundingRect(0, 0, 0, 0, Qt::TextDontClip | Qt::AlignHCenter, result.basePart);
   }
   result.totalBounds.moveTopLeft(QPoint(0, 0)); // want bounding box aligned top left at origin, independent of how it was created, to make further processing simpler
   
@@ -6666,7 +7043,7 @@ void QCPAxisPainterPrivate::getMaxTickLabelSize(const QFont &font, const QString
 {
   // note: this function must return the same tick label sizes as the placeTickLabel function.
   QSize finalSize;
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && mLabelCache.contains(text)) // label caching enabled and have cached label
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !useGlyphAtlas(text) && mLabelCache.contains(text)) // label caching enabled and have cached label
   {
     const CachedLabel *cachedLabel = mLabelCache.object(text);
     finalSize = cachedLabel->pixmap.size();
@@ -9033,6 +9410,8 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mPlottingHints(QCP::phCacheLabels|QCP::phForceRepaint),
   mMultiSelectModifier(Qt::ControlModifier),
   mPaintBuffer(size()),
+  mGlyphAtlas(new QCPGlyphAtlas),
+  mGlyphAtlasPainter(true),
   mMouseEventElement(0),
   mReplotting(false)
 {
@@ -9098,6 +9477,8 @@ QCustomPlot::~QCustomPlot()
   mCurrentLayer = 0;
   qDeleteAll(mLayers); // don't use removeLayer, because it would prevent the last layer to be removed
   mLayers.clear();
+  
+  delete mGlyphAtlas;
 }
 
 /*!
@@ -10361,6 +10742,8 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
 {
   if (mReplotting) // incase signals loop back to replot slot
     return;
+  SWG_PERF_SCOPE("QCustomPlot::replot");
+  SWG_TRACE_SCOPE("QCustomPlot::replot");
   mReplotting = true;
   emit beforeReplot();
   
@@ -10542,6 +10925,8 @@ bool QCustomPlot::savePdf(const QString &fileName, bool noCosmeticPen, int width
 */
 bool QCustomPlot::savePng(const QString &fileName, int width, int height, double scale, int quality)
 {
+  SWG_PERF_SCOPE("QCustomPlot::savePng");
+  SWG_TRACE_SCOPE("QCustomPlot::savePng");
   return saveRastered(fileName, width, height, scale, "PNG", quality);
 }
 
@@ -10653,6 +11038,12 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
   Q_UNUSED(event);
   QPainter painter(this);
   painter.drawPixmap(0, 0, mPaintBuffer);
+  // composite layers that have their own paint buffer:
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (layer->mode() == QCPLayer::lmBuffered && !layer->mPaintBuffer.isNull())
+      painter.drawPixmap(0, 0, layer->mPaintBuffer);
+  }
 }
 
 /*! \internal
@@ -10867,6 +11258,10 @@ void QCustomPlot::wheelEvent(QWheelEvent *event)
 */
 void QCustomPlot::draw(QCPPainter *painter)
 {
+  // tick labels are measured during the layout phases, so they must know beforehand whether the
+  // painter composes them from the glyph atlas (vectorized and uncached exports draw text directly):
+  mGlyphAtlasPainter = !painter->modes().testFlag(QCPPainter::pmVectorized) && !painter->modes().testFlag(QCPPainter::pmNoCaching);
+  
   // run through layout phases:
   mPlotLayout->update(QCPLayoutElement::upPreparation);
   mPlotLayout->update(QCPLayoutElement::upMargins);
@@ -10875,20 +11270,16 @@ void QCustomPlot::draw(QCPPainter *painter)
   // draw viewport background pixmap:
   drawBackground(painter);
 
-  // draw all layered objects (grid, axes, plottables, items, legend,...):
+  // draw all layered objects (grid, axes, plottables, items, legend,...). When drawing to the main
+  // paint buffer, buffered layers are drawn into their own buffers instead (see paintEvent):
+  bool toPaintBuffer = painter->device() == &mPaintBuffer;
   foreach (QCPLayer *layer, mLayers)
   {
-    foreach (QCPLayerable *child, layer->children())
-    {
-      if (child->realVisibility())
-      {
-        painter->save();
-        painter->setClipRect(child->clipRect().translated(0, -1));
-        child->applyDefaultAntialiasingHint(painter);
-        child->draw(painter);
-        painter->restore();
-      }
-    }
+    SWG_TRACE_SCOPE_ARG("QCPLayer::draw", layer->index());
+    if (toPaintBuffer && layer->mode() == QCPLayer::lmBuffered)
+      layer->drawToPaintBuffer();
+    else
+      layer->draw(painter);
   }
   
   /* Debug code to draw all layout element rects
@@ -11134,6 +11525,37 @@ void QCustomPlot::toPainter(QCPPainter *painter, int width, int height)
     qDebug() << Q_FUNC_INFO << "Passed painter is not active";
 }
 
+/*!
+  Returns the number of bytes held by the paint buffers of the plot: the main paint buffer and the
+  buffers of all layers in \ref QCPLayer::lmBuffered mode.
+  
+  \see labelCacheMemoryUsage, QCPGraph::dataMemoryUsage
+*/
+qint64 QCustomPlot::paintBufferMemoryUsage() const
+{
+  qint64 result = (qint64)mPaintBuffer.width()*mPaintBuffer.height()*mPaintBuffer.depth()/8;
+  foreach (QCPLayer *layer, mLayers)
+    result += layer->memoryUsage();
+  return result;
+}
+
+/*!
+  Returns the number of bytes held by the caches used to draw tick labels: the glyph atlas shared by
+  all axes and the label caches of each axis (\ref QCPAxis::labelCacheMemoryUsage).
+  
+  \see paintBufferMemoryUsage, QCPGraph::dataMemoryUsage
+*/
+qint64 QCustomPlot::labelCacheMemoryUsage() const
+{
+  qint64 result = mGlyphAtlas->memoryUsage();
+  foreach (QCPAxisRect *rect, axisRects())
+  {
+    foreach (QCPAxis *axis, rect->axes())
+      result += axis->labelCacheMemoryUsage();
+  }
+  return result;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPColorGradient
@@ -14475,7 +14897,15 @@ QCPData::QCPData(double key, double value) :
   To directly create a graph inside a plot, you can also use the simpler QCustomPlot::addGraph function.
 */
 QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-  QCPAbstractPlottable(keyAxis, valueAxis)
+  QCPAbstractPlottable(keyAxis, valueAxis),
+  mHitIndexValid(false),
+  mHitIndexKeyReversed(false),
+  mHitIndexValueReversed(false),
+  mHitIndexKeyScaleType(QCPAxis::stLinear),
+  mHitIndexValueScaleType(QCPAxis::stLinear),
+  mHitIndexKeyLogBase(10),
+  mHitIndexValueLogBase(10),
+  mHitIndexDataCount(0)
 {
   mData = new QCPDataMap;
   
@@ -14510,6 +14940,7 @@ QCPGraph::~QCPGraph()
 */
 void QCPGraph::setData(QCPDataMap *data, bool copy)
 {
+  invalidateHitIndex();
   if (mData == data)
   {
     qDebug() << Q_FUNC_INFO << "The data pointer is already in (and owned by) this plottable" << reinterpret_cast<quintptr>(data);
@@ -14533,6 +14964,8 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
 */
 void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 {
+  SWG_PERF_SCOPE("QCPGraph::setData");
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14556,6 +14989,7 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14582,6 +15016,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14609,6 +15044,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14635,6 +15071,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14662,6 +15099,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError, const QVector<double> &valueError)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14691,6 +15129,7 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
+  invalidateHitIndex();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14720,6 +15159,7 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 */
 void QCPGraph::setLineStyle(LineStyle ls)
 {
+  invalidateHitIndex();
   mLineStyle = ls;
 }
 
@@ -14731,6 +15171,7 @@ void QCPGraph::setLineStyle(LineStyle ls)
 */
 void QCPGraph::setScatterStyle(const QCPScatterStyle &style)
 {
+  invalidateHitIndex();
   mScatterStyle = style;
 }
 
@@ -14842,6 +15283,7 @@ void QCPGraph::setChannelFillGraph(QCPGraph *targetGraph)
 */
 void QCPGraph::setAdaptiveSampling(bool enabled)
 {
+  invalidateHitIndex();
   mAdaptiveSampling = enabled;
 }
 
@@ -14855,6 +15297,7 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
 */
 void QCPGraph::addData(const QCPDataMap &dataMap)
 {
+  invalidateHitIndex();
   mData->unite(dataMap);
 }
 
@@ -14868,6 +15311,7 @@ void QCPGraph::addData(const QCPDataMap &dataMap)
 */
 void QCPGraph::addData(const QCPData &data)
 {
+  invalidateHitIndex();
   mData->insertMulti(data.key, data);
 }
 
@@ -14881,6 +15325,7 @@ void QCPGraph::addData(const QCPData &data)
 */
 void QCPGraph::addData(double key, double value)
 {
+  invalidateHitIndex();
   QCPData newData;
   newData.key = key;
   newData.value = value;
@@ -14897,6 +15342,7 @@ void QCPGraph::addData(double key, double value)
 */
 void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &values)
 {
+  invalidateHitIndex();
   int n = qMin(keys.size(), values.size());
   QCPData newData;
   for (int i=0; i<n; ++i)
@@ -14913,6 +15359,7 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
 */
 void QCPGraph::removeDataBefore(double key)
 {
+  invalidateHitIndex();
   QCPDataMap::iterator it = mData->begin();
   while (it != mData->end() && it.key() < key)
     it = mData->erase(it);
@@ -14924,6 +15371,7 @@ void QCPGraph::removeDataBefore(double key)
 */
 void QCPGraph::removeDataAfter(double key)
 {
+  invalidateHitIndex();
   if (mData->isEmpty()) return;
   QCPDataMap::iterator it = mData->upperBound(key);
   while (it != mData->end())
@@ -14939,6 +15387,7 @@ void QCPGraph::removeDataAfter(double key)
 */
 void QCPGraph::removeData(double fromKey, double toKey)
 {
+  invalidateHitIndex();
   if (fromKey >= toKey || mData->isEmpty()) return;
   QCPDataMap::iterator it = mData->upperBound(fromKey);
   QCPDataMap::iterator itEnd = mData->upperBound(toKey);
@@ -14956,6 +15405,7 @@ void QCPGraph::removeData(double fromKey, double toKey)
 */
 void QCPGraph::removeData(double key)
 {
+  invalidateHitIndex();
   mData->remove(key);
 }
 
@@ -14965,9 +15415,26 @@ void QCPGraph::removeData(double key)
 */
 void QCPGraph::clearData()
 {
+  invalidateHitIndex();
   mData->clear();
 }
 
+/*!
+  Returns an estimate of the number of bytes held by the data of this graph: the data container,
+  where every data point is a map node with a key, a \ref QCPData and three node pointers, and the
+  pixel column index used by \ref selectTest.
+  
+  \see QCustomPlot::paintBufferMemoryUsage
+*/
+qint64 QCPGraph::dataMemoryUsage() const
+{
+  qint64 result = (qint64)mData->size()*(sizeof(double)+sizeof(QCPData)+3*sizeof(void*));
+  result += (qint64)(mHitIndexSpanLower.capacity()+mHitIndexSpanUpper.capacity())*sizeof(double);
+  result += (qint64)mHitIndexColumnStart.capacity()*sizeof(int);
+  result += (qint64)mHitIndexPoints.capacity()*sizeof(QPointF);
+  return result;
+}
+
 /* inherits documentation from base class */
 double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
 {
@@ -15082,6 +15549,7 @@ void QCPGraph::draw(QCPPainter *painter)
   
   // fill vectors with data appropriate to plot style:
   getPlotData(lineData, scatterData);
+  SWG_PERF_VALUE("QCPGraph::draw points", qMax(lineData->size(), scatterData ? scatterData->size() : 0));
   
   // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
@@ -15653,6 +16121,8 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData)
 */
 void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const
 {
+  SWG_PERF_SCOPE("QCPGraph::getPreparedData");
+  SWG_TRACE_SCOPE("QCPGraph::getPreparedData");
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
@@ -16392,6 +16862,12 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint) const
   if (mLineStyle == lsNone && mScatterStyle.isNone())
     return -1.0;
   
+  // use the pixel space hit index, (re)building it only if plot geometry or data changed:
+  if (!hitIndexUpToDate())
+    updateHitIndex();
+  if (mHitIndexValid)
+    return hitIndexDistance(pixelPoint);
+  
   // calculate minimum distances to graph representation:
   if (mLineStyle == lsNone)
   {
@@ -16446,6 +16922,211 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint) const
   }
 }
 
+/*! \internal
+  
+  Marks the hit index used by \ref pointDistance as outdated, so it is rebuilt on the next
+  selection test. Called whenever the data or the visual representation of the graph changes.
+  
+  Changes made directly to the QCPDataMap returned by \ref data are only detected if they alter the
+  number of data points. The index is always rebuilt if axis ranges or the axis rect change.
+  
+  \see updateHitIndex
+*/
+void QCPGraph::invalidateHitIndex()
+{
+  mHitIndexValid = false;
+}
+
+/*! \internal
+  
+  Returns whether the hit index still describes the graph as it is currently represented on screen,
+  i.e. whether it was built for the current axis rect geometry, axis ranges and data count.
+*/
+bool QCPGraph::hitIndexUpToDate() const
+{
+  if (!mHitIndexValid)
+    return false;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis)
+    return false;
+  // everything that maps coordinates to pixels, plus the data:
+  return mHitIndexRect == keyAxis->axisRect()->rect() &&
+         mHitIndexKeyRange == keyAxis->range() &&
+         mHitIndexValueRange == valueAxis->range() &&
+         mHitIndexKeyReversed == keyAxis->rangeReversed() &&
+         mHitIndexValueReversed == valueAxis->rangeReversed() &&
+         mHitIndexKeyScaleType == keyAxis->scaleType() &&
+         mHitIndexValueScaleType == valueAxis->scaleType() &&
+         mHitIndexKeyLogBase == keyAxis->scaleLogBase() &&
+         mHitIndexValueLogBase == valueAxis->scaleLogBase() &&
+         mHitIndexDataCount == mData->size();
+}
+
+/*! \internal
+  
+  Builds the pixel space acceleration structure used by \ref pointDistance. The key pixel extent of
+  the axis rect is divided into columns of one pixel each.
+  
+  If the graph has a line, each column stores the span of value pixels the line covers inside that
+  column. Because adaptive sampling already reduces the line to a few points per pixel (see \ref
+  getPreparedData), building the index costs about as much as one call to \ref getPlotData.
+  
+  If the line style is \ref lsNone, the scatter points are sorted into their columns instead, so
+  only points of columns near the tested position need to be visited.
+  
+  Selection tests then only visit columns around the tested pixel, and stop as soon as the key pixel
+  distance of the next column exceeds the best distance found so far.
+*/
+void QCPGraph::updateHitIndex() const
+{
+  mHitIndexValid = false;
+  mHitIndexSpanLower.clear();
+  mHitIndexSpanUpper.clear();
+  mHitIndexColumnStart.clear();
+  mHitIndexPoints.clear();
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  
+  const QRect rect = keyAxis->axisRect()->rect();
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  const int columnOrigin = keyIsVertical ? rect.top() : rect.left();
+  const int columnCount = keyIsVertical ? rect.height() : rect.width();
+  if (columnCount <= 0)
+    return;
+  
+  if (mLineStyle != lsNone)
+  {
+    QVector<QPointF> lineData;
+    getPlotData(&lineData, 0);
+    mHitIndexSpanLower.fill(std::numeric_limits<double>::max(), columnCount);
+    mHitIndexSpanUpper.fill(-std::numeric_limits<double>::max(), columnCount);
+    double *spanLower = mHitIndexSpanLower.data();
+    double *spanUpper = mHitIndexSpanUpper.data();
+    // impulse plots only connect pairs of points, all other line styles connect consecutive points:
+    const int step = mLineStyle == lsImpulse ? 2 : 1;
+    if (lineData.size() == 1)
+      lineData.append(lineData.first());
+    for (int i=0; i<lineData.size()-1; i+=step)
+    {
+      double k1 = (keyIsVertical ? lineData.at(i).y() : lineData.at(i).x()) - columnOrigin;
+      double v1 = keyIsVertical ? lineData.at(i).x() : lineData.at(i).y();
+      double k2 = (keyIsVertical ? lineData.at(i+1).y() : lineData.at(i+1).x()) - columnOrigin;
+      double v2 = keyIsVertical ? lineData.at(i+1).x() : lineData.at(i+1).y();
+      if (k1 > k2)
+      {
+        qSwap(k1, k2);
+        qSwap(v1, v2);
+      }
+      if (k2 < 0 || k1 >= columnCount)
+        continue;
+      const double slope = k2 > k1 ? (v2-v1)/(k2-k1) : 0;
+      const int firstColumn = qMax(0, (int)qFloor(k1));
+      const int lastColumn = qMin(columnCount-1, (int)qFloor(k2));
+      for (int c=firstColumn; c<=lastColumn; ++c)
+      {
+        // value pixels of the segment at the borders of this column (or at its end points, if inside):
+        const double a = v1 + slope*(qMax(k1, (double)c)-k1);
+        const double b = v1 + slope*(qMin(k2, (double)(c+1))-k1);
+        spanLower[c] = qMin(spanLower[c], qMin(a, b));
+        spanUpper[c] = qMax(spanUpper[c], qMax(a, b));
+      }
+    }
+  } else
+  {
+    QVector<QCPData> scatterData;
+    getScatterPlotData(&scatterData);
+    QVector<int> pointColumn(scatterData.size());
+    mHitIndexColumnStart.fill(0, columnCount+1);
+    for (int i=0; i<scatterData.size(); ++i)
+    {
+      const double k = keyAxis->coordToPixel(scatterData.at(i).key) - columnOrigin;
+      pointColumn[i] = qBound(0, (int)qFloor(k), columnCount-1);
+      ++mHitIndexColumnStart[pointColumn.at(i)+1];
+    }
+    for (int c=0; c<columnCount; ++c)
+      mHitIndexColumnStart[c+1] += mHitIndexColumnStart.at(c);
+    // counting sort of the points into their columns:
+    QVector<int> insertPos = mHitIndexColumnStart;
+    mHitIndexPoints.resize(scatterData.size());
+    for (int i=0; i<scatterData.size(); ++i)
+      mHitIndexPoints[insertPos[pointColumn.at(i)]++] = coordsToPixels(scatterData.at(i).key, scatterData.at(i).value);
+  }
+  
+  mHitIndexRect = rect;
+  mHitIndexKeyRange = keyAxis->range();
+  mHitIndexValueRange = valueAxis->range();
+  mHitIndexKeyReversed = keyAxis->rangeReversed();
+  mHitIndexValueReversed = valueAxis->rangeReversed();
+  mHitIndexKeyScaleType = keyAxis->scaleType();
+  mHitIndexValueScaleType = valueAxis->scaleType();
+  mHitIndexKeyLogBase = keyAxis->scaleLogBase();
+  mHitIndexValueLogBase = valueAxis->scaleLogBase();
+  mHitIndexDataCount = mData->size();
+  mHitIndexValid = true;
+}
+
+/*! \internal
+  
+  Returns the distance of \a pixelPoint to the graph, using the hit index built by \ref
+  updateHitIndex. Returns -1.0 if no part of the graph is visible.
+  
+  For lines, the distance is measured to the value pixel span of each column, which deviates from
+  the exact distance to the line segments by at most one pixel.
+*/
+double QCPGraph::hitIndexDistance(const QPointF &pixelPoint) const
+{
+  const bool keyIsVertical = mKeyAxis.data()->orientation() == Qt::Vertical;
+  const double k = (keyIsVertical ? pixelPoint.y()-mHitIndexRect.top() : pixelPoint.x()-mHitIndexRect.left());
+  const double v = keyIsVertical ? pixelPoint.x() : pixelPoint.y();
+  const bool hasLine = mLineStyle != lsNone;
+  const int columnCount = hasLine ? mHitIndexSpanLower.size() : mHitIndexColumnStart.size()-1;
+  if (columnCount <= 0)
+    return -1.0;
+  
+  const int startColumn = qBound(0, (int)qFloor(k), columnCount-1);
+  double minDistSqr = std::numeric_limits<double>::max();
+  bool searchLower = true, searchUpper = true;
+  for (int d=0; searchLower || searchUpper; ++d)
+  {
+    for (int side=0; side<2; ++side)
+    {
+      if ((side == 0 && !searchLower) || (side == 1 && !searchUpper) || (d == 0 && side == 1))
+        continue;
+      const int c = side == 0 ? startColumn-d : startColumn+d;
+      if (c < 0 || c >= columnCount)
+      {
+        (side == 0 ? searchLower : searchUpper) = false;
+        continue;
+      }
+      // key pixel distance between the tested point and the column bounds:
+      const double dk = k < c ? c-k : (k > c+1 ? k-(c+1) : 0);
+      if (dk*dk >= minDistSqr)
+      {
+        (side == 0 ? searchLower : searchUpper) = false;
+        continue;
+      }
+      if (hasLine)
+      {
+        const double lower = mHitIndexSpanLower.at(c);
+        const double upper = mHitIndexSpanUpper.at(c);
+        if (lower > upper)
+          continue;
+        const double dv = v < lower ? lower-v : (v > upper ? v-upper : 0);
+        minDistSqr = qMin(minDistSqr, dk*dk + dv*dv);
+      } else
+      {
+        for (int i=mHitIndexColumnStart.at(c); i<mHitIndexColumnStart.at(c+1); ++i)
+          minDistSqr = qMin(minDistSqr, QVector2D(mHitIndexPoints.at(i)-pixelPoint).lengthSquared());
+      }
+    }
+  }
+  if (minDistSqr == std::numeric_limits<double>::max())
+    return -1.0;
+  return qSqrt(minDistSqr);
+}
+
 /*! \internal
   
   Finds the highest index of \a data, whose points y value is just below \a y. Assumes y values in
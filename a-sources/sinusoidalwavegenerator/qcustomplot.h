@@ -371,8 +371,19 @@ class QCP_LIB_DECL QCPLayer : public QObject
   Q_PROPERTY(int index READ index)
   Q_PROPERTY(QList<QCPLayerable*> children READ children)
   Q_PROPERTY(bool visible READ visible WRITE setVisible)
+  Q_PROPERTY(LayerMode mode READ mode WRITE setMode)
   /// \endcond
 public:
+  /*!
+    Defines how the layer is rendered when the plot is replotted.
+    
+    \see setMode
+  */
+  enum LayerMode { lmLogical   ///< Layer is drawn into the main paint buffer of the plot together with all other logical layers
+                   ,lmBuffered ///< Layer has its own paint buffer and can be replotted on its own with \ref replot
+                 };
+  Q_ENUMS(LayerMode)
+  
   QCPLayer(QCustomPlot* parentPlot, const QString &layerName);
   ~QCPLayer();
   
@@ -382,9 +393,15 @@ public:
   int index() const { return mIndex; }
   QList<QCPLayerable*> children() const { return mChildren; }
   bool visible() const { return mVisible; }
+  LayerMode mode() const { return mMode; }
   
   // setters:
   void setVisible(bool visible);
+  void setMode(LayerMode mode);
+  
+  // non-property methods:
+  void replot();
+  qint64 memoryUsage() const;
   
 protected:
   // property members:
@@ -393,10 +410,16 @@ protected:
   int mIndex;
   QList<QCPLayerable*> mChildren;
   bool mVisible;
+  LayerMode mMode;
+  
+  // non-property members:
+  QPixmap mPaintBuffer;
   
   // non-virtual methods:
   void addChild(QCPLayerable *layerable, bool prepend);
   void removeChild(QCPLayerable *layerable);
+  void draw(QCPPainter *painter);
+  void drawToPaintBuffer();
   
 private:
   Q_DISABLE_COPY(QCPLayer)
@@ -469,6 +492,7 @@ private:
   Q_DISABLE_COPY(QCPLayerable)
   
   friend class QCustomPlot;
+  friend class QCPLayer;
   friend class QCPAxisRect;
 };
 
@@ -1214,6 +1238,7 @@ public:
   QList<QCPAbstractPlottable*> plottables() const;
   QList<QCPGraph*> graphs() const;
   QList<QCPAbstractItem*> items() const;
+  qint64 labelCacheMemoryUsage() const;
   
   static AxisType marginSideToAxisType(QCP::MarginSide side);
   static Qt::Orientation orientation(AxisType type) { return type==atBottom||type==atTop ? Qt::Horizontal : Qt::Vertical; }
@@ -1277,6 +1302,14 @@ protected:
   QVector<double> mTickVector;
   QVector<QString> mTickVectorLabels;
   QVector<double> mSubTickVector;
+  bool mTickVectorStepIndexed; // whether mTickVector holds consecutive multiples of mTickStep, starting at mTickVectorFirstStep
+  qint64 mTickVectorFirstStep;
+  QVector<QString> mCachedTickLabels; // number labels of the last tick vector, reused while the tick step and format stay the same
+  qint64 mCachedTickLabelsFirstStep;
+  double mCachedTickLabelsStep;
+  QChar mCachedTickLabelsFormatChar;
+  int mCachedTickLabelsPrecision;
+  QLocale mCachedTickLabelsLocale;
   bool mCachedMarginValid;
   int mCachedMargin;
   
@@ -1318,6 +1351,42 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(QCPAxis::AxisTypes)
 Q_DECLARE_METATYPE(QCPAxis::SelectablePart)
 
 
+class QCPGlyphAtlas
+{
+public:
+  QCPGlyphAtlas();
+  
+  bool canCompose(const QString &text) const;
+  QSize textSize(const QFont &font, const QString &text);
+  void drawText(QCPPainter *painter, const QPointF &topLeft, const QFont &font, const QString &text);
+  qint64 memoryUsage() const;
+  
+protected:
+  struct Glyph
+  {
+    QRect source; // rect of the glyph cell in the atlas pixmap
+    QPoint origin; // top left of the text line, relative to the glyph cell
+    int advance;
+  };
+  struct GlyphMetrics
+  {
+    QHash<QChar, int> advances;
+    int height;
+  };
+  struct FontAtlas
+  {
+    QPixmap pixmap;
+    QHash<QChar, Glyph> glyphs;
+  };
+  QString mCharacters;
+  QCache<QString, GlyphMetrics> mMetrics;
+  QCache<QString, FontAtlas> mAtlases;
+  
+  GlyphMetrics *glyphMetrics(const QFont &font);
+  FontAtlas *fontAtlas(const QFont &font, const QColor &color);
+};
+
+
 class QCPAxisPainterPrivate
 {
 public:
@@ -1327,6 +1396,7 @@ public:
   virtual void draw(QCPPainter *painter);
   virtual int size() const;
   void clearCache();
+  qint64 labelCacheMemoryUsage() const;
   
   QRect axisSelectionBox() const { return mAxisSelectionBox; }
   QRect tickLabelsSelectionBox() const { return mTickLabelsSelectionBox; }
@@ -1379,9 +1449,13 @@ protected:
   
   virtual void placeTickLabel(QCPPainter *painter, double position, int distanceToAxis, const QString &text, QSize *tickLabelsSize);
   virtual void drawTickLabel(QCPPainter *painter, double x, double y, const TickLabelData &labelData) const;
+  virtual void drawTickLabelGlyphs(QCPPainter *painter, double x, double y, const TickLabelData &labelData) const;
   virtual TickLabelData getTickLabelData(const QFont &font, const QString &text) const;
   virtual QPointF getTickLabelDrawOffset(const TickLabelData &labelData) const;
   virtual void getMaxTickLabelSize(const QFont &font, const QString &text, QSize *tickLabelsSize) const;
+  
+  // non-virtual methods:
+  bool useGlyphAtlas(const QString &text) const;
 };
 
 
@@ -1814,6 +1888,8 @@ public:
   bool saveRastered(const QString &fileName, int width, int height, double scale, const char *format, int quality=-1);
   QPixmap toPixmap(int width=0, int height=0, double scale=1.0);
   void toPainter(QCPPainter *painter, int width=0, int height=0);
+  qint64 paintBufferMemoryUsage() const;
+  qint64 labelCacheMemoryUsage() const;
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpHint);
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
@@ -1865,6 +1941,8 @@ protected:
   
   // non-property members:
   QPixmap mPaintBuffer;
+  QCPGlyphAtlas *mGlyphAtlas;
+  bool mGlyphAtlasPainter;
   QPoint mMousePressPos;
   QPointer<QCPLayoutElement> mMouseEventElement;
   bool mReplotting;
@@ -1892,6 +1970,7 @@ protected:
   
   friend class QCPLegend;
   friend class QCPAxis;
+  friend class QCPAxisPainterPrivate;
   friend class QCPLayer;
   friend class QCPAxisRect;
 };
@@ -2566,6 +2645,7 @@ public:
   void removeDataAfter(double key);
   void removeData(double fromKey, double toKey);
   void removeData(double key);
+  qint64 dataMemoryUsage() const;
   
   // reimplemented virtual methods:
   virtual void clearData();
@@ -2589,6 +2669,18 @@ protected:
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
   
+  // non-property members:
+  mutable bool mHitIndexValid;
+  mutable QRect mHitIndexRect;
+  mutable QCPRange mHitIndexKeyRange, mHitIndexValueRange;
+  mutable bool mHitIndexKeyReversed, mHitIndexValueReversed;
+  mutable QCPAxis::ScaleType mHitIndexKeyScaleType, mHitIndexValueScaleType;
+  mutable double mHitIndexKeyLogBase, mHitIndexValueLogBase;
+  mutable int mHitIndexDataCount;
+  mutable QVector<double> mHitIndexSpanLower, mHitIndexSpanUpper; // value pixel span of the line per key pixel column (lower > upper for empty columns)
+  mutable QVector<int> mHitIndexColumnStart; // index of the first point of each key pixel column in mHitIndexPoints, plus one end entry
+  mutable QVector<QPointF> mHitIndexPoints; // scatter points in pixel coordinates, grouped by key pixel column
+  
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
@@ -2625,6 +2717,10 @@ protected:
   int findIndexBelowY(const QVector<QPointF> *data, double y) const;
   int findIndexAboveY(const QVector<QPointF> *data, double y) const;
   double pointDistance(const QPointF &pixelPoint) const;
+  void invalidateHitIndex();
+  bool hitIndexUpToDate() const;
+  void updateHitIndex() const;
+  double hitIndexDistance(const QPointF &pixelPoint) const;
   
   friend class QCustomPlot;
   friend class QCPLegend;
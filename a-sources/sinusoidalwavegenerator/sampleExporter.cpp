@@ -0,0 +1,283 @@
+#include "sampleExporter.h"
+#include <QtEndian>
+#include <cstdio>
+#include <cstring>
+#include "perfCounters.h"
+#include "traceRecorder.h"
+
+
+SampleConverter::SampleConverter(SampleFormat format, double fullScale, bool dither)
+    : m_format(format),
+      m_scale(1.0),
+      m_dither(dither),
+      m_ditherState(0x9E3779B9u)
+{
+    double maxInteger = (format == Int24) ? 8388607.0 : 32767.0;
+    m_scale = (fullScale > 0.0) ? maxInteger / fullScale : maxInteger;
+}
+
+int SampleConverter::bytesPerSample(SampleFormat format)
+{
+    switch (format)
+    {
+    case Float32:
+        return 4;
+    case Float64:
+        return 8;
+    case Int16:
+        return 2;
+    case Int24:
+        return 3;
+    }
+    return 0;
+}
+
+double SampleConverter::nextDither()
+{
+    // Two uniform values from a xorshift generator, added to get a triangular distribution
+    quint32 first = m_ditherState;
+    first ^= first << 13;
+    first ^= first >> 17;
+    first ^= first << 5;
+    quint32 second = first;
+    second ^= second << 13;
+    second ^= second >> 17;
+    second ^= second << 5;
+    m_ditherState = second;
+    return ((double)first + (double)second) * (1.0 / 4294967296.0) - 1.0;
+}
+
+int SampleConverter::convert(const double *values, int count, char *output)
+{
+    // The loops without dither are plain conversions that the compiler vectorizes. Integers are
+    // clipped, offset to be positive so that truncating rounds to the nearest, and offset back
+    switch (m_format)
+    {
+    case Float32:
+    {
+        float *samples = reinterpret_cast<float *>(output);
+        for (int i = 0; i < count; ++i)
+            samples[i] = (float)values[i];
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        for (int i = 0; i < count; ++i)
+        {
+            quint32 bits;
+            memcpy(&bits, samples + i, sizeof(bits));
+            qToLittleEndian<quint32>(bits, reinterpret_cast<uchar *>(samples + i));
+        }
+#endif
+        break;
+    }
+    case Float64:
+    {
+        memcpy(output, values, count * sizeof(double));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        for (int i = 0; i < count; ++i)
+        {
+            quint64 bits;
+            memcpy(&bits, output + i * sizeof(double), sizeof(bits));
+            qToLittleEndian<quint64>(bits, reinterpret_cast<uchar *>(output + i * sizeof(double)));
+        }
+#endif
+        break;
+    }
+    case Int16:
+    {
+        qint16 *samples = reinterpret_cast<qint16 *>(output);
+        if (m_dither)
+        {
+            for (int i = 0; i < count; ++i)
+                samples[i] = (qint16)((qint32)(qBound(-32768.0, values[i] * m_scale + nextDither(), 32767.0) + 32768.5) - 32768);
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+                samples[i] = (qint16)((qint32)(qBound(-32768.0, values[i] * m_scale, 32767.0) + 32768.5) - 32768);
+        }
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        for (int i = 0; i < count; ++i)
+            qToLittleEndian<qint16>(samples[i], reinterpret_cast<uchar *>(samples + i));
+#endif
+        break;
+    }
+    case Int24:
+    {
+        // Bytes written one by one, so no byte order is involved
+        uchar *bytes = reinterpret_cast<uchar *>(output);
+        for (int i = 0; i < count; ++i)
+        {
+            double value = values[i] * m_scale;
+            if (m_dither)
+                value += nextDither();
+            qint32 sample = (qint32)(qBound(-8388608.0, value, 8388607.0) + 8388608.5) - 8388608;
+            bytes[3 * i] = (uchar)sample;
+            bytes[3 * i + 1] = (uchar)(sample >> 8);
+            bytes[3 * i + 2] = (uchar)(sample >> 16);
+        }
+        break;
+    }
+    }
+    return count * bytesPerSample(m_format);
+}
+
+QByteArray SampleExporter::delimitedHeader(char separator)
+{
+    return QByteArray("time") + separator + "elongation\n";
+}
+
+int SampleExporter::formatDelimited(const double *times, const double *elongations, int count, char separator, char *output)
+{
+    int position = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        position += DoubleConversion::toShortest(times[i], output + position);
+        output[position++] = separator;
+        position += DoubleConversion::toShortest(elongations[i], output + position);
+        output[position++] = '\n';
+    }
+    return position;
+}
+
+bool SampleExporter::writeDelimited(QIODevice *device, const QVector<double> &timeVector, const QVector<double> &elongationVector, char separator)
+{
+    SWG_PERF_SCOPE("SampleExporter::writeDelimited");
+    SWG_TRACE_SCOPE("SampleExporter::writeDelimited");
+
+    QByteArray header = delimitedHeader(separator);
+    if (device->write(header) != header.size())
+        return false;
+
+    // Format blocks of as many lines as surely fit in the buffer
+    QByteArray buffer(BufferSize, Qt::Uninitialized);
+    int count = qMin(timeVector.size(), elongationVector.size());
+    int blockSize = BufferSize / MaxDelimitedLineLength;
+    const double *times = timeVector.constData();
+    const double *elongations = elongationVector.constData();
+    for (int i = 0; i < count; i += blockSize)
+    {
+        int bytes = formatDelimited(times + i, elongations + i, qMin(blockSize, count - i), separator, buffer.data());
+        if (device->write(buffer.constData(), bytes) != bytes)
+            return false;
+    }
+    return true;
+}
+
+bool SampleExporter::writeDelimited(const QString &fileName, const QVector<double> &timeVector, const QVector<double> &elongationVector, char separator)
+{
+    QFile file(fileName);
+    if (!openFile(file, fileName))
+        return false;
+
+    bool written = writeDelimited(&file, timeVector, elongationVector, separator);
+    return file.flush() && written;
+}
+
+bool SampleExporter::writeRaw(QIODevice *device, const QVector<double> &elongationVector, SampleFormat format, double fullScale, bool dither)
+{
+    SWG_PERF_SCOPE("SampleExporter::writeRaw");
+    SWG_TRACE_SCOPE("SampleExporter::writeRaw");
+
+    // Doubles are already in the output format on little-endian machines, write them at once
+    int count = elongationVector.size();
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (format == Float64)
+    {
+        qint64 bytes = (qint64)count * sizeof(double);
+        return device->write(reinterpret_cast<const char *>(elongationVector.constData()), bytes) == bytes;
+    }
+#endif
+
+    // Otherwise convert the samples in blocks that fill the buffer
+    SampleConverter converter(format, fullScale, dither);
+    QByteArray buffer(BufferSize, Qt::Uninitialized);
+    int blockSize = BufferSize / SampleConverter::bytesPerSample(format);
+    const double *values = elongationVector.constData();
+    for (int i = 0; i < count; i += blockSize)
+    {
+        int bytes = converter.convert(values + i, qMin(blockSize, count - i), buffer.data());
+        if (device->write(buffer.constData(), bytes) != bytes)
+            return false;
+    }
+    return true;
+}
+
+bool SampleExporter::writeRaw(const QString &fileName, const QVector<double> &elongationVector, SampleFormat format, double fullScale, bool dither)
+{
+    QFile file(fileName);
+    if (!openFile(file, fileName))
+        return false;
+
+    bool written = writeRaw(&file, elongationVector, format, fullScale, dither);
+    return file.flush() && written;
+}
+
+QByteArray SampleExporter::wavHeader(qint64 sampleCount, double samplingFrequency, SampleFormat format)
+{
+    // Float formats need the extended format chunk and a fact chunk with the number of samples
+    bool isFloat = (format == Float32 || format == Float64);
+    int bytes = SampleConverter::bytesPerSample(format);
+    int formatSize = isFloat ? 18 : 16;
+    int headerSize = 12 + 8 + formatSize + (isFloat ? 12 : 0) + 8;
+    qint64 dataSize = sampleCount * bytes;
+    qint64 riffSize = headerSize - 8 + dataSize + (dataSize & 1);
+    if (riffSize > Q_INT64_C(0xFFFFFFFF))
+        return QByteArray();
+    qint64 sampleRate = qBound(Q_INT64_C(1), qRound64(samplingFrequency), Q_INT64_C(0xFFFFFFFF));
+
+    QByteArray header(headerSize, '\0');
+    uchar *p = reinterpret_cast<uchar *>(header.data());
+    memcpy(p, "RIFF", 4);
+    qToLittleEndian<quint32>((quint32)riffSize, p + 4);
+    memcpy(p + 8, "WAVE", 4);
+    memcpy(p + 12, "fmt ", 4);
+    qToLittleEndian<quint32>(formatSize, p + 16);
+    qToLittleEndian<quint16>(isFloat ? 3 : 1, p + 20); // WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+    qToLittleEndian<quint16>(1, p + 22); // channels
+    qToLittleEndian<quint32>((quint32)sampleRate, p + 24);
+    qToLittleEndian<quint32>((quint32)qMin(sampleRate * bytes, Q_INT64_C(0xFFFFFFFF)), p + 28); // bytes per second
+    qToLittleEndian<quint16>(bytes, p + 32); // block align
+    qToLittleEndian<quint16>(bytes * 8, p + 34); // bits per sample
+    p += 20 + formatSize;
+    if (isFloat)
+    {
+        memcpy(p, "fact", 4);
+        qToLittleEndian<quint32>(4, p + 4);
+        qToLittleEndian<quint32>((quint32)sampleCount, p + 8);
+        p += 12;
+    }
+    memcpy(p, "data", 4);
+    qToLittleEndian<quint32>((quint32)dataSize, p + 4);
+    return header;
+}
+
+bool SampleExporter::writeWav(QIODevice *device, const QVector<double> &elongationVector, double samplingFrequency, SampleFormat format, double fullScale, bool dither)
+{
+    QByteArray header = wavHeader(elongationVector.size(), samplingFrequency, format);
+    if (header.isEmpty() || device->write(header) != header.size())
+        return false;
+    if (!writeRaw(device, elongationVector, format, fullScale, dither))
+        return false;
+
+    // Chunks have an even size
+    if (((qint64)elongationVector.size() * SampleConverter::bytesPerSample(format)) & 1)
+        return device->write("\0", 1) == 1;
+    return true;
+}
+
+bool SampleExporter::writeWav(const QString &fileName, const QVector<double> &elongationVector, double samplingFrequency, SampleFormat format, double fullScale, bool dither)
+{
+    QFile file(fileName);
+    if (!openFile(file, fileName))
+        return false;
+
+    bool written = writeWav(&file, elongationVector, samplingFrequency, format, fullScale, dither);
+    return file.flush() && written;
+}
+
+bool SampleExporter::openFile(QFile &file, const QString &fileName)
+{
+    // Files are written without Qt buffering, since the samples are already written in large blocks
+    if (fileName == "-")
+        return file.open(stdout, QIODevice::WriteOnly);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered);
+}
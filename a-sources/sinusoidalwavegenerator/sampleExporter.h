@@ -0,0 +1,196 @@
+#ifndef SAMPLEEXPORTER_H
+#define SAMPLEEXPORTER_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include "doubleConversion.h"
+
+/**
+ * @brief Binary encoding of a sample.
+ */
+enum SampleFormat
+{
+    Float32,    ///< IEEE 754 single precision
+    Float64,    ///< IEEE 754 double precision
+    Int16,      ///< Signed 16-bit integer, full scale mapped to 32767
+    Int24       ///< Signed 24-bit integer, full scale mapped to 8388607
+};
+
+/**
+ * @brief Converts samples to a binary sample format, little-endian.
+ *
+ * Integer formats scale the samples so that the full scale maps to the largest integer, clip the
+ * samples outside of it and round to the nearest integer. Rounding can add triangular (TPDF) dither
+ * of one least significant bit, which turns the quantization distortion into uncorrelated noise.
+ * The dither generator keeps its state between calls, so a long signal can be converted in blocks.
+ */
+class SampleConverter
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param format Sample format to convert to.
+     * @param fullScale Absolute value that maps to the largest integer. Not used by float formats.
+     * @param dither Whether to add TPDF dither before rounding. Not used by float formats.
+     */
+    SampleConverter(SampleFormat format, double fullScale, bool dither);
+
+    /**
+     * @brief Gets the size of a sample in a format.
+     * @param format Sample format.
+     * @return Bytes per sample.
+     */
+    static int bytesPerSample(SampleFormat format);
+    /**
+     * @brief Converts a block of samples.
+     * @param values Samples.
+     * @param count Number of samples.
+     * @param output Buffer of at least count * bytesPerSample() bytes.
+     * @return Number of bytes written.
+     */
+    int convert(const double *values, int count, char *output);
+
+private:
+    /**
+     * @brief Gets the next dither value, a triangular distribution between -1 and 1.
+     * @return Dither, in least significant bits.
+     */
+    double nextDither();
+
+    /**
+     * @brief Sample format to convert to.
+     */
+    SampleFormat m_format;
+    /**
+     * @brief Factor from sample values to integers.
+     */
+    double m_scale;
+    /**
+     * @brief Whether TPDF dither is added before rounding.
+     */
+    bool m_dither;
+    /**
+     * @brief State of the xorshift generator of the dither.
+     */
+    quint32 m_ditherState;
+};
+
+/**
+ * @brief Writes the samples of a wave (time vs elongation) to files, as text or binary.
+ *
+ * Samples are formatted or converted straight from the vectors into a large buffer, which is written
+ * to the device each time it fills up, so exporting never holds more than one buffer in memory.
+ */
+class SampleExporter
+{
+public:
+    /**
+     * @brief Largest size of a line of delimited text: two numbers, the separator and the line break.
+     */
+    static const int MaxDelimitedLineLength = 2 * DoubleConversion::MaxLength + 2;
+
+    /**
+     * @brief Gets the header line of delimited text.
+     * @param separator Field separator, ',' for CSV or '\t' for TSV.
+     * @return Header line, including the line break.
+     */
+    static QByteArray delimitedHeader(char separator);
+    /**
+     * @brief Formats a block of samples as lines of delimited text, without header.
+     * @param times Time of each sample, in seconds.
+     * @param elongations Elongation of each sample.
+     * @param count Number of samples.
+     * @param separator Field separator, ',' for CSV or '\t' for TSV.
+     * @param output Buffer of at least count * MaxDelimitedLineLength bytes.
+     * @return Number of bytes written.
+     */
+    static int formatDelimited(const double *times, const double *elongations, int count, char separator, char *output);
+    /**
+     * @brief Writes the samples as delimited text: a header line and one line per sample.
+     *
+     * Numbers are written with the shortest text that reads back as the same double, with a dot as
+     * decimal separator regardless of the locale.
+     * @param device Device open for writing.
+     * @param timeVector Time of each sample, in seconds.
+     * @param elongationVector Elongation of each sample.
+     * @param separator Field separator, ',' for CSV or '\t' for TSV.
+     * @return true if all the samples are written, or false otherwise.
+     */
+    static bool writeDelimited(QIODevice *device, const QVector<double> &timeVector, const QVector<double> &elongationVector, char separator);
+    /**
+     * @brief Writes the samples as delimited text to a file.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @param timeVector Time of each sample, in seconds.
+     * @param elongationVector Elongation of each sample.
+     * @param separator Field separator, ',' for CSV or '\t' for TSV.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    static bool writeDelimited(const QString &fileName, const QVector<double> &timeVector, const QVector<double> &elongationVector, char separator);
+    /**
+     * @brief Writes the elongation of the samples as raw little-endian binary, without header.
+     * @param device Device open for writing.
+     * @param elongationVector Elongation of each sample.
+     * @param format Sample format.
+     * @param fullScale Absolute value that maps to the largest integer, for integer formats.
+     * @param dither Whether to add TPDF dither when quantizing to integer formats.
+     * @return true if all the samples are written, or false otherwise.
+     */
+    static bool writeRaw(QIODevice *device, const QVector<double> &elongationVector, SampleFormat format, double fullScale, bool dither);
+    /**
+     * @brief Writes the elongation of the samples as raw little-endian binary to a file.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @param elongationVector Elongation of each sample.
+     * @param format Sample format.
+     * @param fullScale Absolute value that maps to the largest integer, for integer formats.
+     * @param dither Whether to add TPDF dither when quantizing to integer formats.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    static bool writeRaw(const QString &fileName, const QVector<double> &elongationVector, SampleFormat format, double fullScale, bool dither);
+    /**
+     * @brief Gets the header of a mono RIFF WAVE file: PCM for integer formats, IEEE float for float formats.
+     * @param sampleCount Number of samples of the file.
+     * @param samplingFrequency Sampling frequency, in hertz. Rounded to an integer.
+     * @param format Sample format.
+     * @return Header, or an empty array if the samples do not fit in a WAVE file (4 GiB).
+     */
+    static QByteArray wavHeader(qint64 sampleCount, double samplingFrequency, SampleFormat format);
+    /**
+     * @brief Writes the elongation of the samples as a mono RIFF WAVE file.
+     * @param device Device open for writing.
+     * @param elongationVector Elongation of each sample.
+     * @param samplingFrequency Sampling frequency, in hertz. Rounded to an integer.
+     * @param format Sample format.
+     * @param fullScale Absolute value that maps to the largest integer, for integer formats.
+     * @param dither Whether to add TPDF dither when quantizing to integer formats.
+     * @return true if all the samples are written, or false otherwise.
+     */
+    static bool writeWav(QIODevice *device, const QVector<double> &elongationVector, double samplingFrequency, SampleFormat format, double fullScale, bool dither);
+    /**
+     * @brief Writes the elongation of the samples as a mono RIFF WAVE file.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @param elongationVector Elongation of each sample.
+     * @param samplingFrequency Sampling frequency, in hertz. Rounded to an integer.
+     * @param format Sample format.
+     * @param fullScale Absolute value that maps to the largest integer, for integer formats.
+     * @param dither Whether to add TPDF dither when quantizing to integer formats.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    static bool writeWav(const QString &fileName, const QVector<double> &elongationVector, double samplingFrequency, SampleFormat format, double fullScale, bool dither);
+    /**
+     * @brief Opens a file for exporting, without Qt buffering since exports write large blocks.
+     * @param file File, not open yet.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @return true if the file is open, or false otherwise.
+     */
+    static bool openFile(QFile &file, const QString &fileName);
+
+private:
+    /**
+     * @brief Size of the buffer written to the device at once, in bytes.
+     */
+    static const int BufferSize = 1 << 22;
+};
+
+#endif // SAMPLEEXPORTER_H
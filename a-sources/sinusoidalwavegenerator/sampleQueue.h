@@ -0,0 +1,119 @@
+#ifndef SAMPLEQUEUE_H
+#define SAMPLEQUEUE_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+/**
+ * @brief Lock-free queue of samples between one producer thread and one consumer thread.
+ *
+ * The producer only writes the tail index and the consumer only writes the head index, so no lock
+ * is needed: each side publishes its index with release semantics after copying the samples, and
+ * reads the other side's index with acquire semantics before touching them. The indices increase
+ * forever and are reduced with a mask, so the capacity is always a power of two.
+ */
+class SampleQueue
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param capacity Minimum number of samples the queue can hold. Rounded up to a power of two.
+     */
+    explicit SampleQueue(int capacity)
+        : m_keys(),
+          m_values(),
+          m_mask(0),
+          m_head(0),
+          m_tail(0)
+    {
+        int roundedCapacity = 1;
+        while (roundedCapacity < capacity)
+            roundedCapacity *= 2;
+        m_keys.fill(0.0, roundedCapacity);
+        m_values.fill(0.0, roundedCapacity);
+        m_mask = roundedCapacity - 1;
+    }
+
+    /**
+     * @brief Gets the maximum number of samples the queue can hold.
+     * @return Capacity of the queue.
+     */
+    int capacity() const { return m_mask + 1; }
+    /**
+     * @brief Gets the number of samples waiting in the queue. Can be called from any thread.
+     * @return Number of samples.
+     */
+    int size() const { return (int)((unsigned int)m_tail.loadAcquire() - (unsigned int)m_head.loadAcquire()); }
+
+    /**
+     * @brief Appends samples to the queue. Must only be called from the producer thread.
+     * @param keys Keys of the samples.
+     * @param values Values of the samples.
+     * @param count Number of samples.
+     * @return Number of samples appended, smaller than count if the queue is full.
+     */
+    int push(const double *keys, const double *values, int count)
+    {
+        unsigned int tail = (unsigned int)m_tail.load();
+        unsigned int head = (unsigned int)m_head.loadAcquire();
+        int written = qMin(count, capacity() - (int)(tail - head));
+        double *queueKeys = m_keys.data();
+        double *queueValues = m_values.data();
+        for (int i = 0; i < written; ++i)
+        {
+            unsigned int position = (tail + i) & m_mask;
+            queueKeys[position] = keys[i];
+            queueValues[position] = values[i];
+        }
+        m_tail.storeRelease((int)(tail + written));
+        return written;
+    }
+
+    /**
+     * @brief Removes the oldest samples from the queue. Must only be called from the consumer thread.
+     * @param keys Buffer where the keys are copied.
+     * @param values Buffer where the values are copied.
+     * @param maxCount Size of the buffers.
+     * @return Number of samples removed.
+     */
+    int pop(double *keys, double *values, int maxCount)
+    {
+        unsigned int head = (unsigned int)m_head.load();
+        unsigned int tail = (unsigned int)m_tail.loadAcquire();
+        int read = qMin(maxCount, (int)(tail - head));
+        const double *queueKeys = m_keys.constData();
+        const double *queueValues = m_values.constData();
+        for (int i = 0; i < read; ++i)
+        {
+            unsigned int position = (head + i) & m_mask;
+            keys[i] = queueKeys[position];
+            values[i] = queueValues[position];
+        }
+        m_head.storeRelease((int)(head + read));
+        return read;
+    }
+
+private:
+    /**
+     * @brief Ring buffer of keys.
+     */
+    QVector<double> m_keys;
+    /**
+     * @brief Ring buffer of values.
+     */
+    QVector<double> m_values;
+    /**
+     * @brief Mask that reduces an index to a position of the ring buffers.
+     */
+    unsigned int m_mask;
+    /**
+     * @brief Index of the next sample to be read, only written by the consumer.
+     */
+    QAtomicInt m_head;
+    /**
+     * @brief Index of the next sample to be written, only written by the producer.
+     */
+    QAtomicInt m_tail;
+};
+
+#endif // SAMPLEQUEUE_H
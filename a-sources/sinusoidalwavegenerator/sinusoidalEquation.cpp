@@ -1,5 +1,9 @@
 #include "sinusoidalEquation.h"
 #include <QtMath>
+#include <climits>
+#include <cmath>
+#include "perfCounters.h"
+#include "traceRecorder.h"
 
 
 SinusoidalEquation::SinusoidalEquation()
@@ -11,7 +15,12 @@ SinusoidalEquation::SinusoidalEquation()
       m_attenuationFactor(0.0),
       m_data(),
       m_timeVector(),
-      m_elongationVector()
+      m_elongationVector(),
+      m_memoryLimit(DefaultMemoryLimit),
+      m_memoryLimitPolicy(DecimateSolve),
+      m_decimationFactor(1),
+      m_refused(false),
+      m_statistics()
 {
     // Solve the equation with the default parameters
     solveEquation();
@@ -53,30 +62,134 @@ void SinusoidalEquation::setAttenuationFactor(double attenuationFactor)
     solveEquation();
 }
 
+void SinusoidalEquation::setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor)
+{
+    m_amplitude = amplitude;
+    m_oscillationFrequency = oscillationFrequency;
+    m_initialDelay = initialDelay;
+    m_numberOfPeriods = numberOfPeriods;
+    m_samplingFrequency = samplingFrequency;
+    m_attenuationFactor = attenuationFactor;
+    solveEquation();
+}
+
+void SinusoidalEquation::setMemoryLimit(qint64 memoryLimit)
+{
+    m_memoryLimit = memoryLimit;
+    solveIfLimitOutcomeChanged();
+}
+
+void SinusoidalEquation::setMemoryLimitPolicy(MemoryLimitPolicy memoryLimitPolicy)
+{
+    m_memoryLimitPolicy = memoryLimitPolicy;
+    solveIfLimitOutcomeChanged();
+}
+
+qint64 SinusoidalEquation::memoryUsage() const
+{
+    return (qint64)m_data.capacity() * sizeof(QPointF) + (qint64)(m_timeVector.capacity() + m_elongationVector.capacity()) * sizeof(double);
+}
+
+qint64 SinusoidalEquation::requiredMemory() const
+{
+    return sampleCount(1) * BytesPerSample;
+}
+
+double SinusoidalEquation::energy()
+{
+    // The samples of a decimated solve each stand for a longer period
+    return m_statistics.sumOfSquares() * m_decimationFactor / m_samplingFrequency;
+}
+
+qint64 SinusoidalEquation::sampleCount(int decimationFactor) const
+{
+    return sampleCount(m_oscillationFrequency, m_numberOfPeriods, m_samplingFrequency, decimationFactor);
+}
+
+qint64 SinusoidalEquation::sampleCount(double oscillationFrequency, int numberOfPeriods, double samplingFrequency, int decimationFactor)
+{
+    double tmax = numberOfPeriods * (1.0 / oscillationFrequency);
+    double step = decimationFactor / samplingFrequency;
+    if (!(tmax >= 0.0) || !(step > 0.0))
+        return 0;
+
+    // Saturate so that the count can still be multiplied by the size of a sample
+    double count = std::floor(tmax / step) + 1.0;
+    double maxCount = (double)(LLONG_MAX / BytesPerSample);
+    return (count < maxCount) ? (qint64)count : (qint64)maxCount;
+}
+
+int SinusoidalEquation::plannedDecimationFactor() const
+{
+    // The vectors cannot hold more than MaxSampleCount samples, whatever the memory limit
+    qint64 count = sampleCount(1);
+    qint64 maxCount = MaxSampleCount;
+    if (m_memoryLimit > 0)
+        maxCount = qMin(maxCount, qMax(m_memoryLimit / BytesPerSample, (qint64)1));
+    if (count <= maxCount)
+        return 1;
+    if (m_memoryLimitPolicy == RefuseSolve)
+        return 0;
+
+    // Keep one sample out of every decimationFactor, so that the samples fit. The last period can
+    // add a sample to the estimate, so the factor is checked against the exact count
+    int decimationFactor = (int)qMin((count + maxCount - 1) / maxCount, (qint64)INT_MAX);
+    while (decimationFactor < INT_MAX && sampleCount(decimationFactor) > maxCount)
+        ++decimationFactor;
+    return decimationFactor;
+}
+
+void SinusoidalEquation::solveIfLimitOutcomeChanged()
+{
+    // The samples only change if the new limit or policy decimates them differently, or refuses them
+    if (plannedDecimationFactor() != (m_refused ? 0 : m_decimationFactor))
+        solveEquation();
+}
+
 void SinusoidalEquation::solveEquation()
 {
-    // Clear vectors
+    SWG_PERF_SCOPE("SinusoidalEquation::solveEquation");
+    SWG_TRACE_SCOPE("SinusoidalEquation::solveEquation");
+
+    // Check the memory the samples would take before allocating anything
+    int decimationFactor = plannedDecimationFactor();
+    m_refused = (decimationFactor == 0);
+    if (m_refused)
+    {
+        emit solveRefused(requiredMemory());
+        return;
+    }
+    qint64 count = sampleCount(decimationFactor);
+    m_decimationFactor = decimationFactor;
+
+    // Clear vectors and allocate them once, for exactly the samples of sampleCount()
     m_data.clear();
     m_timeVector.clear();
     m_elongationVector.clear();
+    m_data.reserve((int)count);
+    m_timeVector.reserve((int)count);
+    m_elongationVector.reserve((int)count);
+    m_statistics.clear();
 
-    // Calculate new values
-    double tmax = m_numberOfPeriods * (1.0 / m_oscillationFrequency);
-    for (double t = 0.0; t <= tmax; t = t + (1.0 / m_samplingFrequency))
+    // Calculate new values. The time of each sample is computed from its index, as the exporters and
+    // the sweeps do, instead of accumulating the step and its rounding
+    double angularFrequency = 2 * M_PI * m_oscillationFrequency;
+    double initialPhase = qDegreesToRadians(m_initialDelay);
+    for (qint64 i = 0; i < count; ++i)
     {
-        // Current attenuation
-        double currentAttenuationFactor = (1.0 - (m_attenuationFactor * t));
-        if (currentAttenuationFactor < 0.0)
-            currentAttenuationFactor = 0.0;
+        double t = (i * decimationFactor) / m_samplingFrequency;
 
         // Current values of time vs elongation
         double currentTimeValue = t;
-        double currentElongationValue = m_amplitude * currentAttenuationFactor * qSin(2 * M_PI * m_oscillationFrequency * t + qDegreesToRadians(m_initialDelay));
+        double currentElongationValue = elongation(m_amplitude, angularFrequency, initialPhase, m_attenuationFactor, t);
 
         // Add values to vectors
         m_data.append(QPointF(currentTimeValue, currentElongationValue));
         m_timeVector.append(currentTimeValue);
         m_elongationVector.append(currentElongationValue);
+
+        // Statistics from the value just computed, instead of reading the samples again afterwards
+        m_statistics.add(currentElongationValue);
     }
 
     // Notify the modification of the wave values
@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QPointF>
 #include <QVector>
+#include <QtMath>
+#include "waveStatistics.h"
 
 /**
  * @brief Sinusoidal wave form.
@@ -24,8 +26,33 @@ class SinusoidalEquation : public QObject
     Q_PROPERTY(QVector<QPointF> Data READ data)
     Q_PROPERTY(QVector<double> TimeVector READ timeVector)
     Q_PROPERTY(QVector<double> ElongationVector READ elongationVector)
+    Q_PROPERTY(qint64 MemoryLimit READ memoryLimit WRITE setMemoryLimit)
+    Q_PROPERTY(MemoryLimitPolicy LimitPolicy READ memoryLimitPolicy WRITE setMemoryLimitPolicy)
+    Q_PROPERTY(int DecimationFactor READ decimationFactor)
+    Q_PROPERTY(qint64 MemoryUsage READ memoryUsage)
+    Q_PROPERTY(double Peak READ peak)
+    Q_PROPERTY(double Rms READ rms)
+    Q_PROPERTY(double Mean READ mean)
+    Q_PROPERTY(double Energy READ energy)
+    Q_PROPERTY(double CrestFactor READ crestFactor)
+    Q_PROPERTY(qint64 ZeroCrossings READ zeroCrossings)
+    Q_ENUMS(MemoryLimitPolicy)
 
 public:
+    /**
+     * @brief What to do when solving the equation would take more memory than the limit.
+     */
+    enum MemoryLimitPolicy
+    {
+        RefuseSolve,    ///< Keep the previous samples and emit solveRefused()
+        DecimateSolve   ///< Solve with a lower sampling frequency, an integer fraction of the requested one
+    };
+
+    /**
+     * @brief Default memory limit of the samples, in bytes.
+     */
+    static const qint64 DefaultMemoryLimit = Q_INT64_C(1) << 30;
+
     /**
      * @brief Constructor.
      */
@@ -76,12 +103,105 @@ public:
      * @return Vector of elongation samples.
      */
     QVector<double> elongationVector() { return m_elongationVector; }
+    /**
+     * @brief Gets the maximum memory the samples may take, in bytes, including their copy in the graph.
+     * @return Memory limit, or 0 if there is no limit.
+     */
+    qint64 memoryLimit() { return m_memoryLimit; }
+    /**
+     * @brief Gets what is done when solving the equation would exceed the memory limit.
+     * @return Policy applied.
+     */
+    MemoryLimitPolicy memoryLimitPolicy() { return m_memoryLimitPolicy; }
+    /**
+     * @brief Gets the factor by which the sampling frequency was divided to fit in the memory limit.
+     * @return 1 if the samples were taken at the requested sampling frequency, or greater if decimated.
+     */
+    int decimationFactor() { return m_decimationFactor; }
+    /**
+     * @brief Gets the number of bytes held by the sample vectors.
+     * @return Bytes allocated.
+     */
+    qint64 memoryUsage() const;
+    /**
+     * @brief Gets the number of bytes the samples would take for the current parameters, without decimation,
+     * in the vectors and in the graph that plots them.
+     * @return Bytes required.
+     */
+    qint64 requiredMemory() const;
+
+    /**
+     * @brief Gets the number of samples of a wave, from time 0 to the end of its last period.
+     * Used by everything that generates the wave, so that they all give the same samples.
+     * @param oscillationFrequency Oscillation frequency of the wave, in hertz.
+     * @param numberOfPeriods Number of periods of the wave.
+     * @param samplingFrequency Sampling frequency of the wave, in hertz.
+     * @param decimationFactor Factor by which the sampling frequency is divided.
+     * @return Number of samples, saturated so that it can still be multiplied by the size of a sample.
+     */
+    static qint64 sampleCount(double oscillationFrequency, int numberOfPeriods, double samplingFrequency, int decimationFactor = 1);
+    /**
+     * @brief Evaluates the wave at a time. The attenuation decreases linearly and stays at zero once reached.
+     * @param amplitude Amplitude of the wave.
+     * @param angularFrequency Angular frequency of the wave, in radians per second.
+     * @param initialPhase Initial phase of the wave, in radians.
+     * @param attenuationFactor Attenuation factor of the wave, in units per second.
+     * @param t Time, in seconds.
+     * @return Elongation.
+     */
+    static inline double elongation(double amplitude, double angularFrequency, double initialPhase, double attenuationFactor, double t)
+    {
+        double currentAttenuationFactor = (1.0 - (attenuationFactor * t));
+        if (currentAttenuationFactor < 0.0)
+            currentAttenuationFactor = 0.0;
+        return amplitude * currentAttenuationFactor * qSin(angularFrequency * t + initialPhase);
+    }
+    /**
+     * @brief Gets the statistics of the elongation samples, computed while solving.
+     * @return Statistics of the samples.
+     */
+    const WaveStatistics &statistics() const { return m_statistics; }
+    /**
+     * @brief Gets the largest absolute elongation of the samples.
+     * @return Peak elongation.
+     */
+    double peak() { return m_statistics.peak(); }
+    /**
+     * @brief Gets the root mean square of the elongation samples.
+     * @return RMS elongation.
+     */
+    double rms() { return m_statistics.rms(); }
+    /**
+     * @brief Gets the mean of the elongation samples.
+     * @return Mean elongation.
+     */
+    double mean() { return m_statistics.mean(); }
+    /**
+     * @brief Gets the energy of the wave: sum of the squared elongations times the sampling period.
+     * @return Energy, in units^2 * seconds.
+     */
+    double energy();
+    /**
+     * @brief Gets the ratio of the peak to the RMS of the elongation samples.
+     * @return Crest factor, or 0 if the RMS is 0.
+     */
+    double crestFactor() { return m_statistics.crestFactor(); }
+    /**
+     * @brief Gets the number of sign changes between consecutive non-zero elongation samples.
+     * @return Number of zero crossings.
+     */
+    qint64 zeroCrossings() { return m_statistics.zeroCrossings(); }
 
 signals:
     /**
      * @brief Signal emited when the equation has changed.
      */
     void equationChanged();
+    /**
+     * @brief Signal emited when the equation is not solved because it would exceed the memory limit.
+     * @param requiredMemory Bytes the samples would have taken.
+     */
+    void solveRefused(qint64 requiredMemory);
 
 public slots:
     /**
@@ -114,6 +234,29 @@ public slots:
      * @param attenuationFactor Attenuation factor of the sinusoidal wave.
      */
     void setAttenuationFactor(double attenuationFactor);
+    /**
+     * @brief Sets all the parameters of the sinusoidal wave at once, solving the equation only once.
+     * @param amplitude Amplitude of the sinusoidal wave.
+     * @param oscillationFrequency Oscillation frequency of the sinusoidal wave, in hertz.
+     * @param initialDelay Initial delay of the sinusoidal wave, in degrees.
+     * @param numberOfPeriods Number of periods of the sinusoidal wave.
+     * @param samplingFrequency Sampling frequency of the sinusoidal wave, in hertz.
+     * @param attenuationFactor Attenuation factor of the sinusoidal wave.
+     */
+    void setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor);
+    /**
+     * @brief Sets the maximum memory the samples may take. It is a soft limit: it is checked before solving.
+     * The equation is only solved again if the limit changes its decimation, or whether it is refused.
+     * Whatever the limit, the samples never exceed MaxSampleCount.
+     * @param memoryLimit Memory limit, in bytes, or 0 for no limit other than MaxSampleCount.
+     */
+    void setMemoryLimit(qint64 memoryLimit);
+    /**
+     * @brief Sets what is done when solving the equation would exceed the memory limit. The equation is
+     * only solved again if it is over the limit.
+     * @param memoryLimitPolicy Policy to apply.
+     */
+    void setMemoryLimitPolicy(MemoryLimitPolicy memoryLimitPolicy);
 
 private slots:
     /**
@@ -122,6 +265,37 @@ private slots:
     void solveEquation();
 
 private:
+    /**
+     * @brief Bytes taken by each sample in the QCPDataMap of the graph that plots it: a node with three
+     * links, the key and a QCPData of six doubles, plus about two words of allocator overhead.
+     */
+    static const int GraphBytesPerSample = 5 * sizeof(void *) + 7 * sizeof(double);
+    /**
+     * @brief Bytes taken by each sample: one point and two doubles, and its copy in the graph.
+     */
+    static const int BytesPerSample = sizeof(QPointF) + 2 * sizeof(double) + GraphBytesPerSample;
+    /**
+     * @brief Largest number of samples a QVector of points can hold, whose allocation, header included,
+     * is limited to INT_MAX bytes. Larger solves are decimated or refused even without a memory limit.
+     */
+    static const int MaxSampleCount = (0x7fffffff - 64) / sizeof(QPointF);
+
+    /**
+     * @brief Gets the number of samples of the equation at a fraction of the sampling frequency.
+     * @param decimationFactor Factor by which the sampling frequency is divided.
+     * @return Number of samples.
+     */
+    qint64 sampleCount(int decimationFactor) const;
+    /**
+     * @brief Gets the decimation factor a solve would use with the current parameters and memory limit.
+     * @return Decimation factor, or 0 if the solve would be refused.
+     */
+    int plannedDecimationFactor() const;
+    /**
+     * @brief Solves the equation again only if the memory limit or its policy change the outcome of the last solve.
+     */
+    void solveIfLimitOutcomeChanged();
+
     /**
      * @brief Amplitude of the sinusoidal wave.
      */
@@ -158,6 +332,26 @@ private:
      * @brief Vector of elongation samples.
      */
     QVector<double> m_elongationVector;
+    /**
+     * @brief Maximum memory the samples may take, in bytes, or 0 for no limit.
+     */
+    qint64 m_memoryLimit;
+    /**
+     * @brief What is done when solving the equation would exceed the memory limit.
+     */
+    MemoryLimitPolicy m_memoryLimitPolicy;
+    /**
+     * @brief Factor by which the sampling frequency was divided in the last solve.
+     */
+    int m_decimationFactor;
+    /**
+     * @brief Whether the last solve was refused, so the samples are those of earlier parameters.
+     */
+    bool m_refused;
+    /**
+     * @brief Statistics of the elongation samples of the last solve.
+     */
+    WaveStatistics m_statistics;
 };
 
 #endif // SINUSOIDALEQUATION_H
@@ -0,0 +1,74 @@
+#include "startupTiming.h"
+#include <QDebug>
+#include <QEvent>
+#include <QStringList>
+#include <QTimer>
+
+
+QElapsedTimer StartupTiming::s_clock;
+QVector<QPair<QString, qint64> > StartupTiming::s_marks;
+bool StartupTiming::s_enabled = false;
+
+StartupTiming::StartupTiming(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void StartupTiming::start()
+{
+    s_marks.clear();
+    s_clock.start();
+}
+
+void StartupTiming::setEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+void StartupTiming::mark(const QString &phase)
+{
+    if (s_clock.isValid())
+        s_marks.append(qMakePair(phase, s_clock.nsecsElapsed()));
+}
+
+void StartupTiming::watchFirstFrame(QWidget *widget)
+{
+    // The watcher is owned by the widget, and removes itself after the first paint
+    widget->installEventFilter(new StartupTiming(widget));
+}
+
+QString StartupTiming::report()
+{
+    QStringList lines;
+    lines << "Startup timing [ms] (since start, phase duration):";
+    qint64 previous = 0;
+    for (int i = 0; i < s_marks.size(); ++i)
+    {
+        lines << QString("%1 %2  %3")
+                 .arg(s_marks.at(i).second / 1e6, 9, 'f', 2)
+                 .arg((s_marks.at(i).second - previous) / 1e6, 9, 'f', 2)
+                 .arg(s_marks.at(i).first);
+        previous = s_marks.at(i).second;
+    }
+    return lines.join("\n");
+}
+
+bool StartupTiming::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint)
+    {
+        // The frame is complete when the event loop is reached again
+        watched->removeEventFilter(this);
+        QTimer::singleShot(0, this, SLOT(onFirstFramePainted()));
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void StartupTiming::onFirstFramePainted()
+{
+    mark("first frame painted");
+    if (s_enabled)
+        qDebug() << qPrintable(report());
+    deleteLater();
+}
@@ -0,0 +1,84 @@
+#ifndef STARTUPTIMING_H
+#define STARTUPTIMING_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QWidget>
+
+/**
+ * @brief Records how long each phase of the application startup takes, up to the first frame painted.
+ *
+ * The phases are marked with mark() as startup goes on, which only stores a timestamp. The breakdown
+ * is written to the debug output once the watched widget has been painted for the first time, if it
+ * has been enabled with setEnabled().
+ */
+class StartupTiming : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Starts the clock. Must be called first thing in main().
+     */
+    static void start();
+    /**
+     * @brief Enables or disables writing the breakdown to the debug output.
+     * @param enabled Whether the breakdown is written.
+     */
+    static void setEnabled(bool enabled);
+    /**
+     * @brief Records the end of a startup phase.
+     * @param phase Name of the phase.
+     */
+    static void mark(const QString &phase);
+    /**
+     * @brief Marks the first frame and writes the breakdown when the widget is painted for the first time.
+     * @param widget Widget whose first paint ends the startup.
+     */
+    static void watchFirstFrame(QWidget *widget);
+    /**
+     * @brief Builds the breakdown of the phases recorded so far.
+     * @return One line per phase, with the time since start and the duration of the phase, in milliseconds.
+     */
+    static QString report();
+
+protected:
+    /**
+     * @brief Overrides the eventFilter method to detect the first paint of the watched widget.
+     * @param watched Object that received the event.
+     * @param event Event parameters.
+     * @return Always false, the event is not handled.
+     */
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private slots:
+    /**
+     * @brief Handles the event fired once the first frame has been painted.
+     */
+    void onFirstFramePainted();
+
+private:
+    /**
+     * @brief Constructor. Only used internally to watch the first frame.
+     * @param parent Parent object.
+     */
+    StartupTiming(QObject *parent);
+
+    /**
+     * @brief Clock started at the beginning of main().
+     */
+    static QElapsedTimer s_clock;
+    /**
+     * @brief Name and time since start of each phase, in nanoseconds.
+     */
+    static QVector<QPair<QString, qint64> > s_marks;
+    /**
+     * @brief Whether the breakdown is written to the debug output.
+     */
+    static bool s_enabled;
+};
+
+#endif // STARTUPTIMING_H
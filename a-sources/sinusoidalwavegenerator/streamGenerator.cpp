@@ -0,0 +1,146 @@
+#include "streamGenerator.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QtMath>
+#include <cmath>
+#include "traceRecorder.h"
+
+
+StreamGenerator::StreamGenerator(SampleQueue *queue, QObject *parent)
+    : QThread(parent),
+      m_queue(queue),
+      m_mutex(),
+      m_stopRequested(0),
+      m_parametersChanged(false),
+      m_amplitude(1.0),
+      m_oscillationFrequency(100.0),
+      m_initialDelay(0.0),
+      m_numberOfPeriods(1),
+      m_samplingFrequency(10000.0),
+      m_attenuationFactor(0.0),
+      m_generatedSamples(0),
+      m_droppedSamples(0)
+{
+    // Name of the thread in traces
+    setObjectName("Stream generator");
+}
+
+StreamGenerator::~StreamGenerator()
+{
+    stop();
+}
+
+void StreamGenerator::setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor)
+{
+    QMutexLocker locker(&m_mutex);
+    m_amplitude = amplitude;
+    m_oscillationFrequency = oscillationFrequency;
+    m_initialDelay = initialDelay;
+    m_numberOfPeriods = numberOfPeriods;
+    m_samplingFrequency = samplingFrequency;
+    m_attenuationFactor = attenuationFactor;
+    m_parametersChanged = true;
+}
+
+void StreamGenerator::stop()
+{
+    m_stopRequested.storeRelease(1);
+    wait();
+}
+
+qint64 StreamGenerator::generatedSamples()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generatedSamples;
+}
+
+qint64 StreamGenerator::droppedSamples()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedSamples;
+}
+
+void StreamGenerator::run()
+{
+    double keys[BlockSize];
+    double values[BlockSize];
+
+    // Local copy of the parameters, so the mutex is only taken once per block
+    double amplitude = 0.0;
+    double oscillationFrequency = 0.0;
+    double initialDelay = 0.0;
+    double windowLength = 0.0;
+    double samplingFrequency = 0.0;
+    double attenuationFactor = 0.0;
+
+    // Time of the first sample since the clock was started, and samples generated since then.
+    // The time of each sample is computed from its index so that rounding errors do not add up
+    QElapsedTimer clock;
+    double clockStartTime = 0.0;
+    qint64 clockSamples = 0;
+    double phase = 0.0;
+    clock.start();
+
+    while (!m_stopRequested.loadAcquire())
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_parametersChanged)
+            {
+                // A new sampling frequency restarts the clock at the current time
+                if (m_samplingFrequency != samplingFrequency)
+                {
+                    if (samplingFrequency > 0.0)
+                        clockStartTime += clockSamples / samplingFrequency;
+                    clockSamples = 0;
+                    clock.restart();
+                }
+                amplitude = m_amplitude;
+                oscillationFrequency = m_oscillationFrequency;
+                initialDelay = qDegreesToRadians(m_initialDelay);
+                windowLength = (oscillationFrequency > 0.0) ? qMax(m_numberOfPeriods, 1) / oscillationFrequency : 0.0;
+                samplingFrequency = m_samplingFrequency;
+                attenuationFactor = m_attenuationFactor;
+                m_parametersChanged = false;
+            }
+        }
+
+        // Number of samples that should have been generated by now
+        qint64 due = (samplingFrequency > 0.0) ? (qint64)(clock.nsecsElapsed() * 1e-9 * samplingFrequency) - clockSamples : 0;
+        if (due <= 0)
+        {
+            msleep(1);
+            continue;
+        }
+
+        int count = (int)qMin(due, (qint64)BlockSize);
+        SWG_TRACE_SCOPE_ARG("StreamGenerator::generateBlock", count);
+        double phaseStep = 2 * M_PI * oscillationFrequency / samplingFrequency;
+        for (int i = 0; i < count; ++i)
+        {
+            double t = clockStartTime + (clockSamples + i) / samplingFrequency;
+
+            // The attenuation counts from the start of the window of the sample, as the one-shot solve
+            // counts it from time 0, so a damped stream keeps repeating instead of staying flat at 0
+            double windowTime = (windowLength > 0.0) ? std::fmod(t, windowLength) : t;
+            double currentAttenuationFactor = (1.0 - (attenuationFactor * windowTime));
+            if (currentAttenuationFactor < 0.0)
+                currentAttenuationFactor = 0.0;
+
+            keys[i] = t;
+            values[i] = amplitude * currentAttenuationFactor * qSin(phase + initialDelay);
+
+            // Keep the phase small so that it does not lose precision
+            phase += phaseStep;
+            if (phase >= 2 * M_PI)
+                phase -= 2 * M_PI * qFloor(phase / (2 * M_PI));
+        }
+        clockSamples += count;
+
+        int pushed = m_queue->push(keys, values, count);
+
+        QMutexLocker locker(&m_mutex);
+        m_generatedSamples += count;
+        m_droppedSamples += count - pushed;
+    }
+}
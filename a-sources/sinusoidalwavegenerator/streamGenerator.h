@@ -0,0 +1,122 @@
+#ifndef STREAMGENERATOR_H
+#define STREAMGENERATOR_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include "sampleQueue.h"
+
+/**
+ * @brief Thread that keeps generating samples of a sinusoidal wave in real time.
+ *
+ * Samples are produced at the sampling frequency, paced by a clock, and appended to a SampleQueue.
+ * The phase is accumulated from sample to sample, so the wave stays continuous when its parameters
+ * change. Samples that do not fit in the queue are discarded and counted as dropped.
+ *
+ * The attenuation restarts at every window of as many periods as the finite equation solves, so that
+ * the stream repeats the damped wave of the one-shot solve instead of fading out for good.
+ */
+class StreamGenerator : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor.
+     * @param queue Queue where the samples are appended.
+     * @param parent Parent object.
+     */
+    StreamGenerator(SampleQueue *queue, QObject *parent = 0);
+    /**
+     * @brief Destructor. Stops the thread.
+     */
+    ~StreamGenerator();
+
+    /**
+     * @brief Changes the parameters of the wave. Takes effect with the next block of samples.
+     * @param amplitude Amplitude of the wave.
+     * @param oscillationFrequency Oscillation frequency of the wave, in hertz.
+     * @param initialDelay Initial delay of the wave, in degrees.
+     * @param numberOfPeriods Number of periods of the window the attenuation restarts at.
+     * @param samplingFrequency Sampling frequency, in hertz.
+     * @param attenuationFactor Attenuation factor, in units per second.
+     */
+    void setParameters(double amplitude, double oscillationFrequency, double initialDelay, int numberOfPeriods, double samplingFrequency, double attenuationFactor);
+    /**
+     * @brief Asks the thread to finish and waits for it.
+     */
+    void stop();
+    /**
+     * @brief Gets the number of samples generated since the thread started.
+     * @return Number of samples.
+     */
+    qint64 generatedSamples();
+    /**
+     * @brief Gets the number of samples discarded because the queue was full.
+     * @return Number of samples.
+     */
+    qint64 droppedSamples();
+
+protected:
+    /**
+     * @brief Generates samples until stop() is called.
+     */
+    void run();
+
+private:
+    /**
+     * @brief Maximum number of samples generated at once.
+     */
+    static const int BlockSize = 4096;
+
+    /**
+     * @brief Queue where the samples are appended.
+     */
+    SampleQueue *m_queue;
+    /**
+     * @brief Protects the parameters and counters, shared with the GUI thread.
+     */
+    QMutex m_mutex;
+    /**
+     * @brief Set to non-zero to ask the thread to finish.
+     */
+    QAtomicInt m_stopRequested;
+    /**
+     * @brief Whether the parameters changed since the thread last read them.
+     */
+    bool m_parametersChanged;
+    /**
+     * @brief Amplitude of the wave.
+     */
+    double m_amplitude;
+    /**
+     * @brief Oscillation frequency of the wave, in hertz.
+     */
+    double m_oscillationFrequency;
+    /**
+     * @brief Initial delay of the wave, in degrees.
+     */
+    double m_initialDelay;
+    /**
+     * @brief Number of periods of the window the attenuation restarts at.
+     */
+    int m_numberOfPeriods;
+    /**
+     * @brief Sampling frequency, in hertz.
+     */
+    double m_samplingFrequency;
+    /**
+     * @brief Attenuation factor, in units per second.
+     */
+    double m_attenuationFactor;
+    /**
+     * @brief Number of samples generated since the thread started.
+     */
+    qint64 m_generatedSamples;
+    /**
+     * @brief Number of samples discarded because the queue was full.
+     */
+    qint64 m_droppedSamples;
+};
+
+#endif // STREAMGENERATOR_H
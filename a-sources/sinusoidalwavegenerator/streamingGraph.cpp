@@ -0,0 +1,315 @@
+#include "streamingGraph.h"
+#include <QtMath>
+#include "perfCounters.h"
+
+
+StreamingGraph::StreamingGraph(QCPAxis *keyAxis, QCPAxis *valueAxis, int capacity)
+    : QCPAbstractPlottable(keyAxis, valueAxis),
+      m_keys(),
+      m_values(),
+      m_blockMin(),
+      m_blockMax(),
+      m_start(0),
+      m_size(0)
+{
+    setCapacity(capacity);
+}
+
+void StreamingGraph::setCapacity(int capacity)
+{
+    // All the memory is allocated here, appending samples never allocates
+    capacity = qMax(capacity, 1);
+    m_keys.fill(0.0, capacity);
+    m_values.fill(0.0, capacity);
+    int blockCount = (capacity + EnvelopeBlockSize - 1) / EnvelopeBlockSize;
+    m_blockMin.fill(0.0, blockCount);
+    m_blockMax.fill(0.0, blockCount);
+    m_start = 0;
+    m_size = 0;
+}
+
+void StreamingGraph::addData(double key, double value)
+{
+    // Write at the position following the newest sample, overwriting the oldest one if full
+    int capacity = m_keys.size();
+    int position = physicalIndex(m_size);
+    m_keys[position] = key;
+    m_values[position] = value;
+    if (m_size < capacity)
+        ++m_size;
+    else
+        m_start = (m_start + 1) % capacity;
+
+    // Update the envelope of the block being written. Blocks are always entered at their first
+    // position, so the envelope restarts there and afterwards only covers the new samples
+    int block = position / EnvelopeBlockSize;
+    if (position % EnvelopeBlockSize == 0)
+    {
+        m_blockMin[block] = value;
+        m_blockMax[block] = value;
+    }
+    else
+    {
+        if (value < m_blockMin.at(block))
+            m_blockMin[block] = value;
+        if (value > m_blockMax.at(block))
+            m_blockMax[block] = value;
+    }
+}
+
+void StreamingGraph::addData(const double *keys, const double *values, int count)
+{
+    // Only the last samples are kept if there are more than fit in the graph
+    int capacity = m_keys.size();
+    if (count > capacity)
+    {
+        keys += count - capacity;
+        values += count - capacity;
+        count = capacity;
+    }
+    for (int i = 0; i < count; ++i)
+        addData(keys[i], values[i]);
+}
+
+void StreamingGraph::clearData()
+{
+    // Restart at the first position so that the block envelopes stay aligned
+    m_start = 0;
+    m_size = 0;
+}
+
+double StreamingGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if ((onlySelectable && !mSelectable) || m_size == 0)
+        return -1;
+    if (!mKeyAxis || !mValueAxis)
+    {
+        qDebug() << Q_FUNC_INFO << "invalid key or value axis";
+        return -1;
+    }
+    if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    // Samples in the pixel column under the position, or the nearest one if the column is empty
+    QCPAxis *keyAxis = mKeyAxis.data();
+    double pixel = (keyAxis->orientation() == Qt::Horizontal) ? pos.x() : pos.y();
+    double key = keyAxis->pixelToCoord(pixel);
+    double lowerKey = keyAxis->pixelToCoord(pixel - 1.0);
+    double upperKey = keyAxis->pixelToCoord(pixel + 1.0);
+    if (lowerKey > upperKey)
+        qSwap(lowerKey, upperKey);
+    int from = lowerBound(lowerKey);
+    int to = lowerBound(upperKey) - 1;
+    if (to < from)
+    {
+        from = qBound(0, from, m_size - 1);
+        if (from > 0 && qAbs(m_keys.at(physicalIndex(from - 1)) - key) < qAbs(m_keys.at(physicalIndex(from)) - key))
+            --from;
+        to = from;
+        key = m_keys.at(physicalIndex(from));
+    }
+
+    // Distance to the vertical segment that is drawn for the column
+    double min = 0.0;
+    double max = 0.0;
+    envelope(from, to, min, max);
+    return qSqrt(distSqrToLine(coordsToPixels(key, min), coordsToPixels(key, max), pos));
+}
+
+void StreamingGraph::draw(QCPPainter *painter)
+{
+    SWG_PERF_SCOPE("StreamingGraph::draw");
+    if (!mKeyAxis || !mValueAxis)
+    {
+        qDebug() << Q_FUNC_INFO << "invalid key or value axis";
+        return;
+    }
+    if (m_size == 0 || mainPen().style() == Qt::NoPen)
+        return;
+
+    // Visible samples, plus one on each side so that the line reaches the borders
+    QCPAxis *keyAxis = mKeyAxis.data();
+    QCPRange range = keyAxis->range();
+    int from = qMax(lowerBound(range.lower) - 1, 0);
+    int to = qMin(lowerBound(range.upper), m_size - 1);
+    if (to < from)
+        return;
+
+    double lowerPixel = keyAxis->coordToPixel(range.lower);
+    double upperPixel = keyAxis->coordToPixel(range.upper);
+    int columnCount = qCeil(qAbs(upperPixel - lowerPixel));
+    QVector<QPointF> points;
+    if (to - from + 1 <= 2 * columnCount)
+    {
+        // Few samples, draw all of them
+        points.reserve(to - from + 1);
+        for (int i = from; i <= to; ++i)
+        {
+            int position = physicalIndex(i);
+            points.append(coordsToPixels(m_keys.at(position), m_values.at(position)));
+        }
+    }
+    else
+    {
+        // Many samples, draw the envelope of each pixel column as a vertical segment
+        points.reserve(2 * columnCount + 2);
+        double direction = (upperPixel > lowerPixel) ? 1.0 : -1.0;
+        int first = from;
+        int last = to;
+        if (m_keys.at(physicalIndex(first)) < range.lower)
+        {
+            points.append(coordsToPixels(m_keys.at(physicalIndex(first)), m_values.at(physicalIndex(first))));
+            ++first;
+        }
+        if (m_keys.at(physicalIndex(last)) > range.upper)
+            --last;
+
+        int i = first;
+        for (int column = 0; column < columnCount && i <= last; ++column)
+        {
+            double columnKey = keyAxis->pixelToCoord(lowerPixel + direction * (column + 0.5));
+            int columnEnd = (column == columnCount - 1) ? last : qMin(lowerBound(keyAxis->pixelToCoord(lowerPixel + direction * (column + 1))) - 1, last);
+            if (columnEnd < i)
+                continue;
+            double min = 0.0;
+            double max = 0.0;
+            envelope(i, columnEnd, min, max);
+            points.append(coordsToPixels(columnKey, min));
+            points.append(coordsToPixels(columnKey, max));
+            i = columnEnd + 1;
+        }
+
+        if (last < to)
+            points.append(coordsToPixels(m_keys.at(physicalIndex(to)), m_values.at(physicalIndex(to))));
+    }
+
+    SWG_PERF_VALUE("StreamingGraph::draw points", points.size());
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mainPen());
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPolyline(points.constData(), points.size());
+}
+
+void StreamingGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    // Draw line vertically centered
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(), rect.top() + rect.height() / 2.0, rect.right() + 5, rect.top() + rect.height() / 2.0));
+}
+
+QCPRange StreamingGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    QCPRange range;
+    foundRange = false;
+    if (inSignDomain == sdBoth)
+    {
+        // Keys are sorted, so the oldest and newest samples are the limits
+        if (m_size > 0)
+        {
+            range.lower = firstKey();
+            range.upper = lastKey();
+            foundRange = true;
+        }
+        return range;
+    }
+
+    for (int i = 0; i < m_size; ++i)
+    {
+        double key = m_keys.at(physicalIndex(i));
+        if ((inSignDomain == sdNegative && key >= 0.0) || (inSignDomain == sdPositive && key <= 0.0))
+            continue;
+        if (!foundRange || key < range.lower)
+            range.lower = key;
+        if (!foundRange || key > range.upper)
+            range.upper = key;
+        foundRange = true;
+    }
+    return range;
+}
+
+QCPRange StreamingGraph::getValueRange(bool &foundRange, SignDomain inSignDomain) const
+{
+    QCPRange range;
+    foundRange = false;
+    if (inSignDomain == sdBoth)
+    {
+        if (m_size > 0)
+        {
+            envelope(0, m_size - 1, range.lower, range.upper);
+            foundRange = true;
+        }
+        return range;
+    }
+
+    for (int i = 0; i < m_size; ++i)
+    {
+        double value = m_values.at(physicalIndex(i));
+        if ((inSignDomain == sdNegative && value >= 0.0) || (inSignDomain == sdPositive && value <= 0.0))
+            continue;
+        if (!foundRange || value < range.lower)
+            range.lower = value;
+        if (!foundRange || value > range.upper)
+            range.upper = value;
+        foundRange = true;
+    }
+    return range;
+}
+
+int StreamingGraph::lowerBound(double key) const
+{
+    int low = 0;
+    int high = m_size;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (m_keys.at(physicalIndex(middle)) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void StreamingGraph::envelope(int from, int to, double &min, double &max) const
+{
+    int capacity = m_keys.size();
+    min = m_values.at(physicalIndex(from));
+    max = min;
+
+    // The block of the next write only has a valid envelope if it has not been entered yet
+    int writePosition = physicalIndex(m_size);
+    int writeBlock = (writePosition % EnvelopeBlockSize == 0) ? -1 : writePosition / EnvelopeBlockSize;
+
+    int i = from;
+    while (i <= to)
+    {
+        int position = physicalIndex(i);
+        int block = position / EnvelopeBlockSize;
+        int blockEnd = qMin((block + 1) * EnvelopeBlockSize, capacity);
+        int count = blockEnd - position;
+        if (position % EnvelopeBlockSize == 0 && i + count - 1 <= to && block != writeBlock)
+        {
+            // Whole block inside the range, use its envelope
+            if (m_blockMin.at(block) < min)
+                min = m_blockMin.at(block);
+            if (m_blockMax.at(block) > max)
+                max = m_blockMax.at(block);
+        }
+        else
+        {
+            // Partial block, scan its samples
+            count = qMin(count, to - i + 1);
+            const double *values = m_values.constData() + position;
+            for (int j = 0; j < count; ++j)
+            {
+                if (values[j] < min)
+                    min = values[j];
+                if (values[j] > max)
+                    max = values[j];
+            }
+        }
+        i += count;
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef STREAMINGGRAPH_H
+#define STREAMINGGRAPH_H
+
+#include <qcustomplot.h>
+#include <QVector>
+
+/**
+ * @brief Plottable that shows the most recent samples of a continuous signal.
+ *
+ * The samples are kept in a ring buffer of fixed capacity, so appending a sample and evicting the
+ * oldest one are O(1) and never allocate memory. Keys must be appended in ascending order.
+ *
+ * A minimum/maximum envelope is maintained per block of samples while appending. When there are
+ * more samples than pixels in the visible range, each pixel column is drawn as the envelope of its
+ * samples, mostly computed from the block envelopes instead of the samples themselves.
+ */
+class StreamingGraph : public QCPAbstractPlottable
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor.
+     * @param keyAxis Axis used for the keys (time).
+     * @param valueAxis Axis used for the values (elongation).
+     * @param capacity Maximum number of samples kept in the graph.
+     */
+    StreamingGraph(QCPAxis *keyAxis, QCPAxis *valueAxis, int capacity);
+
+    /**
+     * @brief Gets the maximum number of samples kept in the graph.
+     * @return Capacity of the ring buffer.
+     */
+    int capacity() const { return m_keys.size(); }
+    /**
+     * @brief Gets the number of samples currently kept in the graph.
+     * @return Number of samples.
+     */
+    int size() const { return m_size; }
+    /**
+     * @brief Gets the key of the oldest sample. The graph must not be empty.
+     * @return Oldest key.
+     */
+    double firstKey() const { return m_keys.at(physicalIndex(0)); }
+    /**
+     * @brief Gets the key of the newest sample. The graph must not be empty.
+     * @return Newest key.
+     */
+    double lastKey() const { return m_keys.at(physicalIndex(m_size - 1)); }
+    /**
+     * @brief Gets the number of bytes held by the ring buffer and the block envelopes.
+     * @return Bytes allocated, which only depend on the capacity.
+     */
+    qint64 memoryUsage() const { return (qint64)(m_keys.capacity() + m_values.capacity() + m_blockMin.capacity() + m_blockMax.capacity()) * sizeof(double); }
+
+    /**
+     * @brief Changes the maximum number of samples kept in the graph. Removes all samples.
+     * @param capacity New capacity of the ring buffer.
+     */
+    void setCapacity(int capacity);
+    /**
+     * @brief Appends a sample, evicting the oldest one if the graph is full.
+     * @param key Key of the sample, not smaller than the key of the newest sample.
+     * @param value Value of the sample.
+     */
+    void addData(double key, double value);
+    /**
+     * @brief Appends a block of samples, evicting the oldest ones if the graph is full.
+     * @param keys Keys of the samples, in ascending order.
+     * @param values Values of the samples.
+     * @param count Number of samples.
+     */
+    void addData(const double *keys, const double *values, int count);
+
+    /**
+     * @brief Removes all samples.
+     */
+    virtual void clearData();
+    /**
+     * @brief Calculates the distance in pixels between the given position and the graph.
+     * @param pos Position in pixels.
+     * @param onlySelectable Whether to return -1 if the graph is not selectable.
+     * @param details Not used.
+     * @return Distance in pixels, or -1 if not applicable.
+     */
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const;
+
+protected:
+    /**
+     * @brief Draws the visible samples, or their envelope per pixel column if they are dense.
+     * @param painter Painter to draw with.
+     */
+    virtual void draw(QCPPainter *painter);
+    /**
+     * @brief Draws the legend icon of the graph.
+     * @param painter Painter to draw with.
+     * @param rect Rect of the icon.
+     */
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
+    /**
+     * @brief Gets the range of keys held in the graph.
+     * @param foundRange Set to whether a range could be determined.
+     * @param inSignDomain Sign domain the range is restricted to.
+     * @return Key range.
+     */
+    virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+    /**
+     * @brief Gets the range of values held in the graph.
+     * @param foundRange Set to whether a range could be determined.
+     * @param inSignDomain Sign domain the range is restricted to.
+     * @return Value range.
+     */
+    virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain = sdBoth) const;
+
+private:
+    /**
+     * @brief Number of consecutive samples summarized by one envelope block.
+     */
+    static const int EnvelopeBlockSize = 256;
+
+    /**
+     * @brief Converts an index counted from the oldest sample into an index of the ring buffer.
+     * @param logicalIndex Index counted from the oldest sample.
+     * @return Index in the ring buffer.
+     */
+    int physicalIndex(int logicalIndex) const { return (m_start + logicalIndex) % m_keys.size(); }
+    /**
+     * @brief Finds the first sample whose key is not smaller than the given one (binary search).
+     * @param key Key to search.
+     * @return Index counted from the oldest sample, or size() if all keys are smaller.
+     */
+    int lowerBound(double key) const;
+    /**
+     * @brief Calculates the minimum and maximum value of a range of samples.
+     * Uses the block envelopes for all blocks completely inside the range.
+     * @param from Index of the first sample, counted from the oldest sample.
+     * @param to Index of the last sample, counted from the oldest sample.
+     * @param min Set to the minimum value.
+     * @param max Set to the maximum value.
+     */
+    void envelope(int from, int to, double &min, double &max) const;
+
+    /**
+     * @brief Ring buffer of keys.
+     */
+    QVector<double> m_keys;
+    /**
+     * @brief Ring buffer of values.
+     */
+    QVector<double> m_values;
+    /**
+     * @brief Minimum value of each block of the ring buffer.
+     */
+    QVector<double> m_blockMin;
+    /**
+     * @brief Maximum value of each block of the ring buffer.
+     */
+    QVector<double> m_blockMax;
+    /**
+     * @brief Index of the oldest sample in the ring buffer.
+     */
+    int m_start;
+    /**
+     * @brief Number of samples in the ring buffer.
+     */
+    int m_size;
+};
+
+#endif // STREAMINGGRAPH_H
@@ -0,0 +1,248 @@
+#include "sweepEngine.h"
+#include <QThread>
+#include <QtMath>
+#include <climits>
+#include "doubleConversion.h"
+#include "perfCounters.h"
+#include "sinusoidalEquation.h"
+#include "traceRecorder.h"
+#include "waveStatistics.h"
+
+
+namespace
+{
+    /**
+     * @brief Thread that takes runs of a sweep one at a time and summarizes them, until there are no more.
+     */
+    class SweepWorker : public QThread
+    {
+    public:
+        /**
+         * @brief Constructor.
+         * @param engine Engine that knows the parameters of each run.
+         * @param first Index of the first run of the range.
+         * @param count Number of runs of the range.
+         * @param next Index in the range of the next run to take, shared by the workers.
+         * @param cancelRequested Non-zero when the workers have to stop.
+         * @param summaries Summaries of the range, indexed from its first run.
+         * @param bufferSize Number of samples generated at once.
+         */
+        SweepWorker(const SweepEngine *engine, qint64 first, int count, QAtomicInt *next, const QAtomicInt *cancelRequested,
+                    SweepEngine::Summary *summaries, int bufferSize)
+            : m_engine(engine),
+              m_first(first),
+              m_count(count),
+              m_next(next),
+              m_cancelRequested(cancelRequested),
+              m_summaries(summaries),
+              m_bufferSize(bufferSize)
+        {
+            // Name of the thread in traces
+            setObjectName("Sweep worker");
+        }
+
+        /**
+         * @brief Summarizes runs in the calling thread.
+         */
+        void process()
+        {
+            QVector<double> buffer(m_bufferSize);
+            while (m_cancelRequested->loadAcquire() == 0)
+            {
+                int i = m_next->fetchAndAddRelaxed(1);
+                if (i >= m_count)
+                    break;
+                SweepEngine::Summary summary = SweepEngine::summarize(m_engine->runParameters(m_first + i), buffer.data(), buffer.size());
+                summary.index = m_first + i;
+                m_summaries[i] = summary;
+            }
+        }
+
+    protected:
+        /**
+         * @brief Summarizes runs in the thread.
+         */
+        void run()
+        {
+            process();
+        }
+
+    private:
+        /**
+         * @brief Engine that knows the parameters of each run.
+         */
+        const SweepEngine *m_engine;
+        /**
+         * @brief Index of the first run of the range.
+         */
+        qint64 m_first;
+        /**
+         * @brief Number of runs of the range.
+         */
+        int m_count;
+        /**
+         * @brief Index in the range of the next run to take.
+         */
+        QAtomicInt *m_next;
+        /**
+         * @brief Non-zero when the workers have to stop.
+         */
+        const QAtomicInt *m_cancelRequested;
+        /**
+         * @brief Summaries of the range.
+         */
+        SweepEngine::Summary *m_summaries;
+        /**
+         * @brief Number of samples generated at once.
+         */
+        int m_bufferSize;
+    };
+}
+
+SweepEngine::SweepEngine()
+    : m_grid(),
+      m_cancelRequested(0)
+{
+    m_grid.numberOfPeriods = 1;
+    m_grid.samplingFrequency = 1000.0;
+}
+
+void SweepEngine::setGrid(const Grid &grid)
+{
+    m_grid = grid;
+}
+
+qint64 SweepEngine::runCount() const
+{
+    return (qint64)m_grid.amplitudes.size() * m_grid.oscillationFrequencies.size() * m_grid.initialDelays.size() * m_grid.attenuationFactors.size();
+}
+
+WaveFile::Parameters SweepEngine::runParameters(qint64 index) const
+{
+    WaveFile::Parameters parameters;
+    parameters.attenuationFactor = m_grid.attenuationFactors.at((int)(index % m_grid.attenuationFactors.size()));
+    index /= m_grid.attenuationFactors.size();
+    parameters.amplitude = m_grid.amplitudes.at((int)(index % m_grid.amplitudes.size()));
+    index /= m_grid.amplitudes.size();
+    parameters.initialDelay = m_grid.initialDelays.at((int)(index % m_grid.initialDelays.size()));
+    index /= m_grid.initialDelays.size();
+    parameters.oscillationFrequency = m_grid.oscillationFrequencies.at((int)(index % m_grid.oscillationFrequencies.size()));
+    parameters.numberOfPeriods = m_grid.numberOfPeriods;
+    parameters.samplingFrequency = m_grid.samplingFrequency;
+    return parameters;
+}
+
+QVector<SweepEngine::Summary> SweepEngine::solve(qint64 first, qint64 count, int threadCount)
+{
+    SWG_PERF_SCOPE("SweepEngine::solve");
+    SWG_TRACE_SCOPE("SweepEngine::solve");
+
+    qint64 runs = runCount();
+    if (count < 0)
+        count = runs - first;
+    if (first < 0 || count < 0 || first + count > runs || count > INT_MAX)
+        return QVector<Summary>();
+    m_cancelRequested.storeRelease(0);
+
+    // The workers take the runs from a shared counter, the first one in the calling thread
+    QVector<Summary> summaries((int)count);
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    threadCount = (int)qBound((qint64)1, (qint64)threadCount, qMax(count, (qint64)1));
+    QAtomicInt next(0);
+    QList<SweepWorker *> workers;
+    for (int i = 0; i < threadCount; ++i)
+        workers.append(new SweepWorker(this, first, (int)count, &next, &m_cancelRequested, summaries.data(), ChunkSize));
+    for (int i = 1; i < workers.size(); ++i)
+        workers.at(i)->start();
+    workers.at(0)->process();
+    for (int i = 1; i < workers.size(); ++i)
+        workers.at(i)->wait();
+    qDeleteAll(workers);
+
+    SWG_PERF_VALUE("SweepEngine::solve runs", count);
+    if (m_cancelRequested.loadAcquire() != 0)
+        return QVector<Summary>();
+    return summaries;
+}
+
+void SweepEngine::cancel()
+{
+    m_cancelRequested.storeRelease(1);
+}
+
+bool SweepEngine::writeSummaries(QIODevice *device, const QVector<Summary> &summaries) const
+{
+    SWG_TRACE_SCOPE_ARG("SweepEngine::writeSummaries", summaries.size());
+
+    QByteArray line;
+    char number[DoubleConversion::MaxLength];
+    for (int i = 0; i < summaries.size(); ++i)
+    {
+        const Summary &summary = summaries.at(i);
+        WaveFile::Parameters parameters = runParameters(summary.index);
+        double values[] = { parameters.amplitude, parameters.oscillationFrequency, parameters.initialDelay, parameters.attenuationFactor };
+        double statistics[] = { summary.peak, summary.rms, summary.energy };
+
+        line = QByteArray::number(summary.index);
+        for (int j = 0; j < 4; ++j)
+            line.append(',').append(number, DoubleConversion::toShortest(values[j], number));
+        line.append(',').append(QByteArray::number(summary.sampleCount));
+        for (int j = 0; j < 3; ++j)
+            line.append(',').append(number, DoubleConversion::toShortest(statistics[j], number));
+        line.append(',').append(QByteArray::number(summary.zeroCrossings)).append('\n');
+        if (device->write(line) != line.size())
+            return false;
+    }
+    return true;
+}
+
+QByteArray SweepEngine::summaryHeader()
+{
+    return "index,amplitude,oscillationFrequency,initialDelay,attenuationFactor,samples,peak,rms,energy,zeroCrossings\n";
+}
+
+SweepEngine::Summary SweepEngine::summarize(const WaveFile::Parameters &parameters, double *buffer, int bufferSize)
+{
+    Summary summary;
+    summary.index = 0;
+
+    qint64 count = SinusoidalEquation::sampleCount(parameters.oscillationFrequency, parameters.numberOfPeriods, parameters.samplingFrequency);
+    double step = 1.0 / parameters.samplingFrequency;
+
+    // Generate a chunk, then add it to the statistics
+    double angularFrequency = 2 * M_PI * parameters.oscillationFrequency;
+    double initialPhase = qDegreesToRadians(parameters.initialDelay);
+    WaveStatistics statistics;
+    for (qint64 first = 0; first < count; first += bufferSize)
+    {
+        int chunkSize = (int)qMin((qint64)bufferSize, count - first);
+        for (int i = 0; i < chunkSize; ++i)
+        {
+            double t = (first + i) / parameters.samplingFrequency;
+            buffer[i] = SinusoidalEquation::elongation(parameters.amplitude, angularFrequency, initialPhase, parameters.attenuationFactor, t);
+        }
+
+        // Each chunk is accumulated on its own and then merged, which keeps the rounding errors of
+        // long waves as small as those of a chunk
+        WaveStatistics chunk;
+        for (int i = 0; i < chunkSize; ++i)
+            chunk.add(buffer[i]);
+        statistics.merge(chunk);
+    }
+
+    summary.sampleCount = count;
+    summary.peak = statistics.peak();
+    summary.rms = statistics.rms();
+    summary.energy = statistics.sumOfSquares() * step;
+    summary.zeroCrossings = statistics.zeroCrossings();
+    return summary;
+}
+
+QVector<double> SweepEngine::range(double from, double to, int count)
+{
+    QVector<double> values;
+    for (int i = 0; i < count; ++i)
+        values.append((count == 1) ? from : from + (to - from) * i / (count - 1));
+    return values;
+}
@@ -0,0 +1,169 @@
+#ifndef SWEEPENGINE_H
+#define SWEEPENGINE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QIODevice>
+#include <QVector>
+#include "waveFile.h"
+
+/**
+ * @brief Solves many sinusoidal waves of a grid of parameters in parallel and summarizes each of them.
+ *
+ * The waves are never stored: each run generates its samples in chunks of a small buffer and keeps
+ * running sums, so a thread uses the same memory whatever the length of the waves, and the memory of
+ * the whole sweep is that of the summaries. The runs are handed out one at a time to a pool of
+ * threads, so that long and short runs balance across the cores, and each summary is stored at the
+ * index of its run, so the result does not depend on the scheduling.
+ *
+ * The samples are the same as those exported by ChunkedExporter: the formula of SinusoidalEquation
+ * without decimation, with the time of each sample computed from its index.
+ */
+class SweepEngine
+{
+public:
+    /**
+     * @brief Grid of parameters. Every combination of the values of the lists is a run.
+     */
+    struct Grid
+    {
+        /**
+         * @brief Amplitudes of the waves.
+         */
+        QVector<double> amplitudes;
+        /**
+         * @brief Oscillation frequencies of the waves, in hertz.
+         */
+        QVector<double> oscillationFrequencies;
+        /**
+         * @brief Initial delays of the waves, in degrees.
+         */
+        QVector<double> initialDelays;
+        /**
+         * @brief Attenuation factors of the waves, in units per second.
+         */
+        QVector<double> attenuationFactors;
+        /**
+         * @brief Number of periods of all the waves.
+         */
+        int numberOfPeriods;
+        /**
+         * @brief Sampling frequency of all the waves, in hertz.
+         */
+        double samplingFrequency;
+    };
+
+    /**
+     * @brief Summary of the samples of one run.
+     */
+    struct Summary
+    {
+        /**
+         * @brief Index of the run in the grid.
+         */
+        qint64 index;
+        /**
+         * @brief Number of samples.
+         */
+        qint64 sampleCount;
+        /**
+         * @brief Largest absolute elongation.
+         */
+        double peak;
+        /**
+         * @brief Root mean square of the elongation.
+         */
+        double rms;
+        /**
+         * @brief Energy of the wave: sum of the squared elongations times the sampling period, in units^2 * seconds.
+         */
+        double energy;
+        /**
+         * @brief Number of sign changes between consecutive non-zero samples.
+         */
+        qint64 zeroCrossings;
+    };
+
+    /**
+     * @brief Constructor.
+     */
+    SweepEngine();
+
+    /**
+     * @brief Sets the grid of parameters to solve.
+     * @param grid Grid of parameters.
+     */
+    void setGrid(const Grid &grid);
+    /**
+     * @brief Gets the number of runs of the grid.
+     * @return Number of runs.
+     */
+    qint64 runCount() const;
+    /**
+     * @brief Gets the parameters of a run. The attenuation factor varies fastest, then the amplitude,
+     * the initial delay, and the oscillation frequency slowest.
+     * @param index Index of the run.
+     * @return Parameters of the wave.
+     */
+    WaveFile::Parameters runParameters(qint64 index) const;
+
+    /**
+     * @brief Solves and summarizes a range of runs of the grid, blocking until done or cancelled.
+     * @param first Index of the first run.
+     * @param count Number of runs, or -1 for all the runs from the first one.
+     * @param threadCount Number of threads, or 0 for one per core.
+     * @return Summaries of the runs, in order, or an empty vector if cancelled or the range is invalid.
+     */
+    QVector<Summary> solve(qint64 first = 0, qint64 count = -1, int threadCount = 0);
+    /**
+     * @brief Stops the current solve before its next run. Can be called from any thread.
+     */
+    void cancel();
+    /**
+     * @brief Writes summaries as CSV lines, with the parameters of their runs, without header.
+     * Numbers are written with DoubleConversion::toShortest, so the same runs always give the same bytes.
+     * @param device Device open for writing.
+     * @param summaries Summaries.
+     * @return true if all the lines are written, or false otherwise.
+     */
+    bool writeSummaries(QIODevice *device, const QVector<Summary> &summaries) const;
+    /**
+     * @brief Gets the header line of the CSV written by writeSummaries.
+     * @return Header, with line feed.
+     */
+    static QByteArray summaryHeader();
+
+    /**
+     * @brief Generates and summarizes the samples of a wave in the calling thread.
+     * @param parameters Parameters of the wave.
+     * @param buffer Buffer for a chunk of samples.
+     * @param bufferSize Size of the buffer, in samples.
+     * @return Summary of the wave. Its index is not set.
+     */
+    static Summary summarize(const WaveFile::Parameters &parameters, double *buffer, int bufferSize);
+    /**
+     * @brief Gets evenly spaced values, to fill the lists of a grid.
+     * @param from First value.
+     * @param to Last value.
+     * @param count Number of values.
+     * @return Values.
+     */
+    static QVector<double> range(double from, double to, int count);
+
+private:
+    /**
+     * @brief Number of samples generated at once by each thread.
+     */
+    static const int ChunkSize = 4096;
+
+    /**
+     * @brief Grid of parameters.
+     */
+    Grid m_grid;
+    /**
+     * @brief Non-zero when the solve has to stop.
+     */
+    QAtomicInt m_cancelRequested;
+};
+
+#endif // SWEEPENGINE_H
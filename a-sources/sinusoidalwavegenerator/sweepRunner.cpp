@@ -0,0 +1,352 @@
+#include "sweepRunner.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <cstring>
+#include "csvImporter.h"
+#include "doubleConversion.h"
+#include "perfCounters.h"
+#include "sampleExporter.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Writes a list of values exactly, separated by commas.
+     * @param values Values.
+     * @return Text of the list.
+     */
+    QByteArray valueList(const QVector<double> &values)
+    {
+        QByteArray text;
+        char number[DoubleConversion::MaxLength];
+        for (int i = 0; i < values.size(); ++i)
+        {
+            if (i > 0)
+                text.append(',');
+            text.append(number, DoubleConversion::toShortest(values.at(i), number));
+        }
+        return text;
+    }
+
+    /**
+     * @brief Reads a list of values separated by commas, written by valueList().
+     * @param text Text of the list.
+     * @param values Set to the values.
+     * @return true if there is at least one value and all are valid, or false otherwise.
+     */
+    bool parseValueList(const QByteArray &text, QVector<double> &values)
+    {
+        values.clear();
+        const char *p = text.constData();
+        const char *end = p + text.size();
+        while (p != end)
+        {
+            double value = 0.0;
+            p = DoubleConversion::parse(p, end, value);
+            if (p == NULL || (p != end && *p++ != ','))
+                return false;
+            values.append(value);
+        }
+        return !values.isEmpty() && *(end - 1) != ',';
+    }
+
+    /**
+     * @brief Reads the run index at the start of a summary line.
+     * @param begin Start of the line.
+     * @param end End of the text.
+     * @return Index, or -1 if there is none.
+     */
+    qint64 lineIndex(const char *begin, const char *end)
+    {
+        const char *comma = static_cast<const char *>(memchr(begin, ',', end - begin));
+        if (comma == NULL)
+            return -1;
+        bool ok = false;
+        qint64 index = QByteArray::fromRawData(begin, comma - begin).toLongLong(&ok);
+        return ok ? index : -1;
+    }
+}
+
+SweepRunner::SweepRunner(QObject *parent)
+    : QObject(parent),
+      m_grid(),
+      m_gridText(),
+      m_runCount(0),
+      m_processCount(QThread::idealThreadCount()),
+      m_shardCount(4 * QThread::idealThreadCount()),
+      m_shardDirectory(),
+      m_directory(),
+      m_failed(false),
+      m_loop(NULL)
+{
+    m_grid.numberOfPeriods = 1;
+    m_grid.samplingFrequency = 1000.0;
+    m_gridText = gridText(m_grid);
+}
+
+void SweepRunner::setGrid(const SweepEngine::Grid &grid)
+{
+    m_grid = grid;
+    m_gridText = gridText(grid);
+    SweepEngine engine;
+    engine.setGrid(grid);
+    m_runCount = engine.runCount();
+}
+
+void SweepRunner::setWorkers(int processCount, int shardCount)
+{
+    m_processCount = (processCount > 0) ? processCount : QThread::idealThreadCount();
+    m_processCount = qMax(m_processCount, 1);
+    m_shardCount = (shardCount > 0) ? shardCount : 4 * m_processCount;
+}
+
+void SweepRunner::setShardDirectory(const QString &directory)
+{
+    m_shardDirectory = directory;
+}
+
+int SweepRunner::shardCount() const
+{
+    // No empty shards, but at least one so that an empty grid still gives a file
+    return (int)qBound((qint64)1, (qint64)m_shardCount, qMax(m_runCount, (qint64)1));
+}
+
+QString SweepRunner::shardFileName(const QString &directory, int shard) const
+{
+    // Shards of another grid or sharding never have the same name
+    int digits = QString::number(shardCount() - 1).size();
+    return QDir(directory).filePath(QString("sweep_%1_%2_of_%3.csv").arg(gridHash()).arg(shard, digits, 10, QChar('0')).arg(shardCount()));
+}
+
+QString SweepRunner::gridFileName(const QString &directory) const
+{
+    return QDir(directory).filePath(QString("sweep_%1.grid").arg(gridHash()));
+}
+
+QString SweepRunner::gridHash() const
+{
+    return QString::fromLatin1(QCryptographicHash::hash(m_gridText, QCryptographicHash::Md5).toHex().left(12));
+}
+
+bool SweepRunner::run(const QString &fileName)
+{
+    SWG_PERF_SCOPE("SweepRunner::run");
+    SWG_TRACE_SCOPE_ARG("SweepRunner::run", shardCount());
+
+    QTemporaryDir temporaryDirectory;
+    m_directory = m_shardDirectory.isEmpty() ? temporaryDirectory.path() : m_shardDirectory;
+    if ((m_shardDirectory.isEmpty() && !temporaryDirectory.isValid()) || !QDir().mkpath(m_directory))
+        return false;
+
+    // The grid is given to the workers in a file. Saved atomically, since other nodes sharing the
+    // directory can be reading the same file
+    QSaveFile gridFile(gridFileName(m_directory));
+    if (!gridFile.open(QIODevice::WriteOnly) || gridFile.write(m_gridText) != m_gridText.size() || !gridFile.commit())
+        return false;
+
+    // Shards left by an earlier run, here or on another node, are not solved again
+    m_pending.clear();
+    m_attempts = QVector<int>(shardCount(), 0);
+    m_failed = false;
+    for (int shard = 0; shard < shardCount(); ++shard)
+    {
+        qint64 first = 0;
+        qint64 count = 0;
+        shardRange(m_runCount, shard, shardCount(), first, count);
+        if (!isShardComplete(shardFileName(m_directory, shard), first, count))
+            m_pending.enqueue(shard);
+    }
+    SWG_PERF_VALUE("SweepRunner::run resumed shards", shardCount() - m_pending.size());
+
+    // The workers are started and checked from the event loop, until none is running
+    QEventLoop loop;
+    m_loop = &loop;
+    QMetaObject::invokeMethod(this, "startShards", Qt::QueuedConnection);
+    loop.exec();
+    m_loop = NULL;
+
+    return !m_failed && merge(fileName);
+}
+
+void SweepRunner::shardRange(qint64 runCount, int shard, int shardCount, qint64 &first, qint64 &count)
+{
+    first = runCount / shardCount * shard + qMin((qint64)shard, runCount % shardCount);
+    count = runCount / shardCount + ((shard < runCount % shardCount) ? 1 : 0);
+}
+
+QByteArray SweepRunner::gridText(const SweepEngine::Grid &grid)
+{
+    char number[DoubleConversion::MaxLength];
+    QByteArray text;
+    text.append("amplitude=").append(valueList(grid.amplitudes)).append('\n');
+    text.append("frequency=").append(valueList(grid.oscillationFrequencies)).append('\n');
+    text.append("delay=").append(valueList(grid.initialDelays)).append('\n');
+    text.append("attenuation=").append(valueList(grid.attenuationFactors)).append('\n');
+    text.append("periods=").append(QByteArray::number(grid.numberOfPeriods)).append('\n');
+    text.append("sampling-frequency=").append(number, DoubleConversion::toShortest(grid.samplingFrequency, number)).append('\n');
+    return text;
+}
+
+bool SweepRunner::readGridFile(const QString &fileName, SweepEngine::Grid &grid)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // The lines written by gridText(), in the same order
+    QList<QByteArray> lines = file.readAll().split('\n');
+    QStringList names = QStringList() << "amplitude" << "frequency" << "delay" << "attenuation" << "periods" << "sampling-frequency";
+    if (lines.size() != names.size() + 1 || !lines.last().isEmpty())
+        return false;
+    QList<QByteArray> values;
+    for (int i = 0; i < names.size(); ++i)
+    {
+        QByteArray name = names.at(i).toLatin1() + '=';
+        if (!lines.at(i).startsWith(name))
+            return false;
+        values.append(lines.at(i).mid(name.size()));
+    }
+
+    bool ok = false;
+    QVector<double> samplingFrequency;
+    grid.numberOfPeriods = values.at(4).toInt(&ok);
+    bool valid = ok && grid.numberOfPeriods >= 0;
+    valid = valid && parseValueList(values.at(0), grid.amplitudes);
+    valid = valid && parseValueList(values.at(1), grid.oscillationFrequencies);
+    valid = valid && parseValueList(values.at(2), grid.initialDelays);
+    valid = valid && parseValueList(values.at(3), grid.attenuationFactors);
+    valid = valid && parseValueList(values.at(5), samplingFrequency) && samplingFrequency.size() == 1;
+    grid.samplingFrequency = samplingFrequency.value(0);
+    return valid && grid.samplingFrequency > 0.0;
+}
+
+bool SweepRunner::isShardComplete(const QString &fileName, qint64 first, qint64 count)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    if (file.size() == 0)
+        return count == 0;
+
+    // Complete lines, as many as runs, from the first run to the last one
+    const char *begin = reinterpret_cast<const char *>(file.map(0, file.size()));
+    if (begin == NULL)
+        return false;
+    const char *end = begin + file.size();
+    if (*(end - 1) != '\n' || CsvImporter::countLines(begin, end) != count)
+        return false;
+    const char *lastLine = end - 1;
+    while (lastLine != begin && *(lastLine - 1) != '\n')
+        --lastLine;
+    return lineIndex(begin, end) == first && lineIndex(lastLine, end) == first + count - 1;
+}
+
+void SweepRunner::startShards()
+{
+    // The cores are shared by the workers
+    int threadCount = qMax(1, QThread::idealThreadCount() / m_processCount);
+    while (!m_failed && !m_pending.isEmpty() && m_running.size() < m_processCount)
+    {
+        int shard = m_pending.dequeue();
+        ++m_attempts[shard];
+        SWG_TRACE_SCOPE_ARG("SweepRunner::startShard", shard);
+
+        QStringList arguments;
+        arguments << "--headless" << "--grid-file" << gridFileName(m_directory)
+                  << "--shard" << QString("%1/%2").arg(shard).arg(shardCount())
+                  << "--threads" << QString::number(threadCount)
+                  << "--summaries" << shardFileName(m_directory, shard);
+        QProcess *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onWorkerFinished(int,QProcess::ExitStatus)));
+        // errorOccurred() replaces the overloaded error() signal from Qt 5.6, which the Qt 5.4 builds lack
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+        connect(process, SIGNAL(errorOccurred(QProcess::ProcessError)), this, SLOT(onWorkerError(QProcess::ProcessError)));
+#else
+        connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onWorkerError(QProcess::ProcessError)));
+#endif
+        m_running.insert(process, shard);
+        process->start(QCoreApplication::applicationFilePath(), arguments);
+    }
+
+    if (m_running.isEmpty() && m_loop != NULL)
+        m_loop->quit();
+}
+
+void SweepRunner::onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (process == NULL || !m_running.contains(process))
+        return;
+
+    qint64 first = 0;
+    qint64 count = 0;
+    int shard = m_running.value(process);
+    shardRange(m_runCount, shard, shardCount(), first, count);
+    finishShard(process, exitStatus == QProcess::NormalExit && exitCode == 0 && isShardComplete(shardFileName(m_directory, shard), first, count));
+}
+
+void SweepRunner::onWorkerError(QProcess::ProcessError error)
+{
+    // Other errors are followed by finished()
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (process != NULL && error == QProcess::FailedToStart)
+        finishShard(process, false);
+}
+
+void SweepRunner::finishShard(QProcess *process, bool succeeded)
+{
+    if (!m_running.contains(process))
+        return;
+    int shard = m_running.take(process);
+    process->deleteLater();
+
+    // Failed shards go to the end of the queue. The running workers are left to finish, so that
+    // their shards are kept in the directory for the next run
+    if (!succeeded)
+    {
+        SWG_PERF_VALUE("SweepRunner::run failed shards", 1);
+        if (m_attempts.at(shard) < MaxAttempts)
+            m_pending.enqueue(shard);
+        else
+            m_failed = true;
+    }
+
+    // Started from the event loop, since this can be called from QProcess::start
+    QMetaObject::invokeMethod(this, "startShards", Qt::QueuedConnection);
+}
+
+bool SweepRunner::merge(const QString &fileName) const
+{
+    SWG_TRACE_SCOPE("SweepRunner::merge");
+
+    QFile output(fileName);
+    if (!SampleExporter::openFile(output, fileName))
+        return false;
+    QByteArray header = SweepEngine::summaryHeader();
+    bool written = output.write(header) == header.size();
+
+    QByteArray block;
+    for (int shard = 0; shard < shardCount() && written; ++shard)
+    {
+        QFile input(shardFileName(m_directory, shard));
+        written = input.open(QIODevice::ReadOnly);
+        while (written && !input.atEnd())
+        {
+            block = input.read(MergeBlockSize);
+            written = !block.isEmpty() && output.write(block) == block.size();
+        }
+    }
+    written = output.flush() && written;
+
+    // A file that is not completely written is removed
+    if (!written && fileName != "-")
+        output.remove();
+    return written;
+}
@@ -0,0 +1,212 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <QEventLoop>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QQueue>
+#include <QStringList>
+#include <QVector>
+#include "sweepEngine.h"
+
+/**
+ * @brief Solves a sweep too large for one process by sharding its grid across worker processes.
+ *
+ * The runs of the grid are split into contiguous shards, more of them than workers so that a slow or
+ * failed shard costs little. Each shard is solved by a headless instance of this application
+ * ("--headless --grid-file file --shard i/n --summaries file"), which writes the summaries of its runs, in order, to
+ * its own file of the shard directory and renames it into place only when it is complete. A shard
+ * whose worker crashes, exits with an error or leaves an incomplete file is started again, up to
+ * MaxAttempts times. When all the shards are complete, their files are concatenated in order after
+ * the header, which gives the same bytes as solving the whole grid in one process.
+ *
+ * The grid is written once to a file of the shard directory, which the workers read, since its values
+ * can be too many for a command line. The shard files are named after the text of that file and the
+ * number of shards. Shards already complete in the
+ * directory are not solved again, so an interrupted sweep resumes where it stopped, and other nodes
+ * sharing the directory can solve shards with the same command line as the workers.
+ */
+class SweepRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Maximum number of times a shard is started before the sweep fails.
+     */
+    static const int MaxAttempts = 3;
+
+    /**
+     * @brief Constructor.
+     * @param parent Parent object.
+     */
+    SweepRunner(QObject *parent = 0);
+
+    /**
+     * @brief Sets the grid of parameters to solve.
+     * @param grid Grid of parameters.
+     */
+    void setGrid(const SweepEngine::Grid &grid);
+    /**
+     * @brief Sets the number of worker processes and of shards.
+     * @param processCount Number of worker processes running at once, or 0 for one per core.
+     * @param shardCount Number of shards, or 0 for four per worker process.
+     */
+    void setWorkers(int processCount, int shardCount = 0);
+    /**
+     * @brief Sets the directory of the shard files.
+     * @param directory Directory, kept after the sweep, or an empty string for a temporary one.
+     */
+    void setShardDirectory(const QString &directory);
+    /**
+     * @brief Gets the number of shards, once the workers are set.
+     * @return Number of shards.
+     */
+    int shardCount() const;
+    /**
+     * @brief Gets the file of a shard in a directory.
+     * @param directory Directory of the shard files.
+     * @param shard Index of the shard.
+     * @return Full path of the file.
+     */
+    QString shardFileName(const QString &directory, int shard) const;
+    /**
+     * @brief Gets the file of the grid in a directory.
+     * @param directory Directory of the shard files.
+     * @return Full path of the file.
+     */
+    QString gridFileName(const QString &directory) const;
+
+    /**
+     * @brief Solves the grid with the worker processes and writes the merged summaries, blocking
+     * until done. Runs an event loop meanwhile.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @return true if all the shards are solved and the file is correctly written, or false otherwise.
+     */
+    bool run(const QString &fileName);
+
+    /**
+     * @brief Gets the range of runs of a shard. The shards have the same size, give or take a run.
+     * @param runCount Number of runs of the grid.
+     * @param shard Index of the shard.
+     * @param shardCount Number of shards.
+     * @param first Set to the index of the first run.
+     * @param count Set to the number of runs.
+     */
+    static void shardRange(qint64 runCount, int shard, int shardCount, qint64 &first, qint64 &count);
+    /**
+     * @brief Gets the text of the file that gives a grid to the workers, with the values written exactly.
+     * @param grid Grid of parameters.
+     * @return Text, one "name=values" line per parameter.
+     */
+    static QByteArray gridText(const SweepEngine::Grid &grid);
+    /**
+     * @brief Reads a grid written by the coordinator.
+     * @param fileName Full path of the file.
+     * @param grid Set to the grid of parameters.
+     * @return true if the file is read and all the values are valid, or false otherwise.
+     */
+    static bool readGridFile(const QString &fileName, SweepEngine::Grid &grid);
+    /**
+     * @brief Checks whether a shard file holds all the summaries of its range.
+     * @param fileName Full path of the file.
+     * @param first Index of the first run of the shard.
+     * @param count Number of runs of the shard.
+     * @return true if complete, or false otherwise.
+     */
+    static bool isShardComplete(const QString &fileName, qint64 first, qint64 count);
+
+private slots:
+    /**
+     * @brief Starts pending shards while there are free workers, and stops the event loop when
+     * nothing runs anymore.
+     */
+    void startShards();
+    /**
+     * @brief Checks the shard of a worker that has exited.
+     * @param exitCode Exit code of the worker.
+     * @param exitStatus Whether the worker exited normally.
+     */
+    void onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    /**
+     * @brief Handles a worker that could not be started, which does not report finishing.
+     * @param error Error of the process.
+     */
+    void onWorkerError(QProcess::ProcessError error);
+
+private:
+    /**
+     * @brief Records the end of a worker, and queues its shard again if it failed.
+     * @param process Worker.
+     * @param succeeded Whether the shard file is complete.
+     */
+    void finishShard(QProcess *process, bool succeeded);
+    /**
+     * @brief Concatenates the header and the shard files.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @return true if correctly written, or false otherwise.
+     */
+    bool merge(const QString &fileName) const;
+    /**
+     * @brief Gets the hash of the grid that names its files.
+     * @return 12 hexadecimal digits.
+     */
+    QString gridHash() const;
+
+    /**
+     * @brief Size of the blocks copied from the shard files.
+     */
+    static const int MergeBlockSize = 1 << 20;
+
+    /**
+     * @brief Grid of parameters.
+     */
+    SweepEngine::Grid m_grid;
+    /**
+     * @brief Text of the grid file.
+     */
+    QByteArray m_gridText;
+    /**
+     * @brief Number of runs of the grid.
+     */
+    qint64 m_runCount;
+    /**
+     * @brief Number of worker processes running at once.
+     */
+    int m_processCount;
+    /**
+     * @brief Number of shards.
+     */
+    int m_shardCount;
+    /**
+     * @brief Directory of the shard files set by the user, or empty for a temporary one.
+     */
+    QString m_shardDirectory;
+    /**
+     * @brief Directory of the shard files of the current run.
+     */
+    QString m_directory;
+    /**
+     * @brief Shards waiting for a worker.
+     */
+    QQueue<int> m_pending;
+    /**
+     * @brief Shard of each running worker.
+     */
+    QHash<QProcess *, int> m_running;
+    /**
+     * @brief Number of times each shard was started.
+     */
+    QVector<int> m_attempts;
+    /**
+     * @brief Whether a shard failed MaxAttempts times.
+     */
+    bool m_failed;
+    /**
+     * @brief Event loop of the current run.
+     */
+    QEventLoop *m_loop;
+};
+
+#endif // SWEEPRUNNER_H
@@ -0,0 +1,262 @@
+#include "traceRecorder.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadStorage>
+
+
+namespace
+{
+    /**
+     * @brief Maximum number of events recorded per thread and recording.
+     */
+    const int BufferCapacity = 1 << 16;
+
+    /**
+     * @brief Event recorded by a thread.
+     */
+    struct TraceEvent
+    {
+        /**
+         * @brief Name of the event, a string literal.
+         */
+        const char *name;
+        /**
+         * @brief Begin of the event, in nanoseconds.
+         */
+        qint64 begin;
+        /**
+         * @brief End of the event, in nanoseconds.
+         */
+        qint64 end;
+        /**
+         * @brief Argument of the event, or -1 for none.
+         */
+        int argument;
+    };
+
+    /**
+     * @brief Events of one thread. Only the owner thread writes it; the count is published with release
+     * semantics after each event, so a reader sees complete events up to the count it reads.
+     */
+    struct TraceBuffer
+    {
+        TraceBuffer(int threadId, const QString &threadName)
+            : events(new TraceEvent[BufferCapacity]),
+              count(0),
+              dropped(0),
+              session(0),
+              threadId(threadId),
+              threadName(threadName)
+        {
+        }
+
+        /**
+         * @brief Events, BufferCapacity elements. Never freed, because the buffers live as long as the application.
+         */
+        TraceEvent *events;
+        /**
+         * @brief Number of events of the current recording.
+         */
+        QAtomicInt count;
+        /**
+         * @brief Number of events that did not fit in the buffer.
+         */
+        QAtomicInt dropped;
+        /**
+         * @brief Recording the events belong to. The owner thread empties the buffer when a new one starts.
+         */
+        QAtomicInt session;
+        /**
+         * @brief Identifier of the thread in the trace.
+         */
+        int threadId;
+        /**
+         * @brief Name of the thread in the trace.
+         */
+        QString threadName;
+    };
+
+    /**
+     * @brief Buffer of a thread, stored by value so that QThreadStorage does not delete the buffer when the thread ends.
+     */
+    struct ThreadSlot
+    {
+        ThreadSlot() : buffer(NULL) {}
+
+        /**
+         * @brief Buffer of the thread, or NULL if it has not recorded any event yet.
+         */
+        TraceBuffer *buffer;
+    };
+
+    /**
+     * @brief Clock of the timestamps, started once when the application is loaded.
+     */
+    struct TraceClock
+    {
+        TraceClock() { timer.start(); }
+
+        /**
+         * @brief Timer started at construction.
+         */
+        QElapsedTimer timer;
+    };
+
+    /**
+     * @brief Protects the list of buffers, only taken the first time a thread records an event.
+     */
+    QMutex bufferMutex;
+    /**
+     * @brief Buffers of all the threads that have recorded events.
+     */
+    QList<TraceBuffer *> buffers;
+    /**
+     * @brief Buffer of each thread.
+     */
+    QThreadStorage<ThreadSlot> threadSlots;
+    /**
+     * @brief Clock of the timestamps.
+     */
+    TraceClock traceClock;
+    /**
+     * @brief Number of the current recording.
+     */
+    QAtomicInt currentSession(0);
+
+    /**
+     * @brief Appends a string to a JSON document as a quoted and escaped value.
+     * @param json Document.
+     * @param text String to append.
+     */
+    void appendJsonString(QByteArray &json, const QByteArray &text)
+    {
+        json += '"';
+        for (int i = 0; i < text.size(); ++i)
+        {
+            if (text.at(i) == '"' || text.at(i) == '\\')
+                json += '\\';
+            json += text.at(i);
+        }
+        json += '"';
+    }
+}
+
+QAtomicInt TraceRecorder::s_recording(0);
+
+void TraceRecorder::start()
+{
+    currentSession.fetchAndAddOrdered(1);
+    s_recording.storeRelease(1);
+}
+
+void TraceRecorder::stop()
+{
+    s_recording.storeRelease(0);
+}
+
+qint64 TraceRecorder::now()
+{
+    return traceClock.timer.nsecsElapsed();
+}
+
+void TraceRecorder::record(const char *name, qint64 begin, qint64 end, int argument)
+{
+    // The first event of a thread registers its buffer
+    ThreadSlot &slot = threadSlots.localData();
+    if (slot.buffer == NULL)
+    {
+        QMutexLocker locker(&bufferMutex);
+        QThread *thread = QThread::currentThread();
+        QString threadName = thread->objectName();
+        if (threadName.isEmpty())
+        {
+            if (QCoreApplication::instance() != NULL && thread == QCoreApplication::instance()->thread())
+                threadName = "GUI thread";
+            else
+                threadName = QString("Thread %1").arg(buffers.size() + 1);
+        }
+        slot.buffer = new TraceBuffer(buffers.size() + 1, threadName);
+        buffers.append(slot.buffer);
+    }
+
+    // Empty the buffer if it still holds the events of a previous recording
+    TraceBuffer *buffer = slot.buffer;
+    int session = currentSession.loadAcquire();
+    if (buffer->session.load() != session)
+    {
+        buffer->count.store(0);
+        buffer->dropped.store(0);
+        buffer->session.storeRelease(session);
+    }
+
+    int index = buffer->count.load();
+    if (index >= BufferCapacity)
+    {
+        buffer->dropped.ref();
+        return;
+    }
+    TraceEvent &event = buffer->events[index];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    event.argument = argument;
+    buffer->count.storeRelease(index + 1);
+}
+
+bool TraceRecorder::writeChromeTrace(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QList<TraceBuffer *> threadBuffers;
+    {
+        QMutexLocker locker(&bufferMutex);
+        threadBuffers = buffers;
+    }
+
+    // Complete events ('X') with microsecond timestamps, plus the name of each thread
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    int session = currentSession.loadAcquire();
+    int dropped = 0;
+    QByteArray json;
+    json += "{\"traceEvents\":[\n";
+    bool first = true;
+    char line[256];
+    for (int i = 0; i < threadBuffers.size(); ++i)
+    {
+        TraceBuffer *buffer = threadBuffers.at(i);
+        if (buffer->session.loadAcquire() != session)
+            continue;
+        int count = buffer->count.loadAcquire();
+        dropped += buffer->dropped.load();
+
+        if (!first)
+            json += ",\n";
+        first = false;
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(buffer->threadId) + ",\"args\":{\"name\":";
+        appendJsonString(json, buffer->threadName.toUtf8());
+        json += "}}";
+
+        for (int j = 0; j < count; ++j)
+        {
+            const TraceEvent &event = buffer->events[j];
+            json += ",\n{\"name\":";
+            appendJsonString(json, QByteArray(event.name));
+            qsnprintf(line, sizeof(line), ",\"cat\":\"swg\",\"ph\":\"X\",\"pid\":%s,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                      pid.constData(), buffer->threadId, event.begin / 1e3, (event.end - event.begin) / 1e3);
+            json += line;
+            if (event.argument >= 0)
+                json += ",\"args\":{\"value\":" + QByteArray::number(event.argument) + "}";
+            json += '}';
+        }
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" + QByteArray::number(dropped) + "}}\n";
+
+    return file.write(json) == json.size();
+}
@@ -0,0 +1,113 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+/**
+ * @brief Records timestamped events of every thread and writes them as a chrome://tracing timeline.
+ *
+ * Events are recorded with SWG_TRACE_SCOPE, which records the begin and end of the enclosing scope.
+ * Each thread writes to its own fixed-size buffer, so recording takes no lock and never allocates;
+ * when a buffer is full its further events are counted as dropped. The macros expand to nothing
+ * unless SWG_TRACING is defined (qmake CONFIG += tracing), and otherwise only test a flag while
+ * recording is stopped.
+ */
+class TraceRecorder
+{
+public:
+    /**
+     * @brief Discards the events recorded so far and starts recording.
+     */
+    static void start();
+    /**
+     * @brief Stops recording. The events are kept until the next start().
+     */
+    static void stop();
+    /**
+     * @brief Gets whether events are being recorded.
+     * @return true if recording, or false otherwise.
+     */
+    static bool isRecording() { return s_recording.loadAcquire() != 0; }
+    /**
+     * @brief Writes the events of the last recording in the Trace Event Format (JSON), readable by
+     * chrome://tracing and Perfetto.
+     * @param fileName Full path of the file.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    static bool writeChromeTrace(const QString &fileName);
+
+    /**
+     * @brief Records an event of the calling thread. Use SWG_TRACE_SCOPE instead.
+     * @param name Name of the event, a string literal.
+     * @param begin Begin of the event, in nanoseconds of the recording clock.
+     * @param end End of the event, in nanoseconds of the recording clock.
+     * @param argument Value shown as argument of the event, or -1 for none.
+     */
+    static void record(const char *name, qint64 begin, qint64 end, int argument);
+    /**
+     * @brief Gets the current time of the recording clock.
+     * @return Nanoseconds since the application was loaded.
+     */
+    static qint64 now();
+
+private:
+    /**
+     * @brief Non-zero while recording.
+     */
+    static QAtomicInt s_recording;
+};
+
+/**
+ * @brief Records the begin and end of its lifetime as an event of the calling thread.
+ */
+class TraceScope
+{
+public:
+    /**
+     * @brief Constructor. Takes the begin timestamp if recording.
+     * @param name Name of the event, a string literal.
+     * @param argument Value shown as argument of the event, or -1 for none.
+     */
+    explicit TraceScope(const char *name, int argument = -1)
+        : m_name(name),
+          m_argument(argument),
+          m_begin(TraceRecorder::isRecording() ? TraceRecorder::now() : -1)
+    {
+    }
+    /**
+     * @brief Destructor. Records the event if recording started before the scope.
+     */
+    ~TraceScope()
+    {
+        if (m_begin >= 0 && TraceRecorder::isRecording())
+            TraceRecorder::record(m_name, m_begin, TraceRecorder::now(), m_argument);
+    }
+
+private:
+    /**
+     * @brief Name of the event.
+     */
+    const char *m_name;
+    /**
+     * @brief Argument of the event.
+     */
+    int m_argument;
+    /**
+     * @brief Begin of the event, or -1 if not recording.
+     */
+    qint64 m_begin;
+};
+
+#define SWG_TRACE_CONCATENATE_(a, b) a##b
+#define SWG_TRACE_CONCATENATE(a, b) SWG_TRACE_CONCATENATE_(a, b)
+
+#ifdef SWG_TRACING
+#define SWG_TRACE_SCOPE(name) TraceScope SWG_TRACE_CONCATENATE(traceScope, __LINE__)(name)
+#define SWG_TRACE_SCOPE_ARG(name, argument) TraceScope SWG_TRACE_CONCATENATE(traceScope, __LINE__)(name, argument)
+#else
+#define SWG_TRACE_SCOPE(name)
+#define SWG_TRACE_SCOPE_ARG(name, argument)
+#endif
+
+#endif // TRACERECORDER_H
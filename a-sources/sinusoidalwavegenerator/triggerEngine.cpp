@@ -0,0 +1,203 @@
+#include "triggerEngine.h"
+#include <cfloat>
+
+
+TriggerEngine::TriggerEngine()
+    : m_slope(RisingEdge),
+      m_level(0.0),
+      m_holdoff(0.0),
+      m_sweepLength(0),
+      m_preTriggerLength(0),
+      m_historyKeys(),
+      m_historyValues(),
+      m_historyPosition(0),
+      m_historySize(0),
+      m_hasLastValue(false),
+      m_lastValue(0.0),
+      m_holdoffEnd(-DBL_MAX),
+      m_capturing(false),
+      m_triggerKey(0.0),
+      m_captured(0),
+      m_captureKeys(),
+      m_captureValues(),
+      m_sweepKeys(),
+      m_sweepValues(),
+      m_sweepReady(false)
+{
+}
+
+void TriggerEngine::setSweepLength(int sweepLength, int preTriggerLength)
+{
+    // All the buffers are allocated here, processing samples never allocates
+    m_sweepLength = qMax(sweepLength, 1);
+    m_preTriggerLength = qBound(0, preTriggerLength, m_sweepLength - 1);
+    m_historyKeys.fill(0.0, m_preTriggerLength);
+    m_historyValues.fill(0.0, m_preTriggerLength);
+    m_captureKeys.fill(0.0, m_sweepLength);
+    m_captureValues.fill(0.0, m_sweepLength);
+    m_sweepKeys.fill(0.0, m_sweepLength);
+    m_sweepValues.fill(0.0, m_sweepLength);
+    reset();
+}
+
+void TriggerEngine::reset()
+{
+    m_historyPosition = 0;
+    m_historySize = 0;
+    m_hasLastValue = false;
+    m_lastValue = 0.0;
+    m_holdoffEnd = -DBL_MAX;
+    m_capturing = false;
+    m_triggerKey = 0.0;
+    m_captured = 0;
+    m_sweepReady = false;
+}
+
+int TriggerEngine::process(const double *keys, const double *values, int count)
+{
+    if (m_sweepLength == 0)
+        return 0;
+
+    int sweeps = 0;
+    int i = 0;
+    while (i < count)
+    {
+        if (m_capturing)
+        {
+            // Copy the samples after the trigger until the sweep is complete
+            int n = qMin(m_sweepLength - m_captured, count - i);
+            double *captureKeys = m_captureKeys.data() + m_captured;
+            double *captureValues = m_captureValues.data() + m_captured;
+            for (int j = 0; j < n; ++j)
+            {
+                captureKeys[j] = keys[i + j] - m_triggerKey;
+                captureValues[j] = values[i + j];
+            }
+            m_captured += n;
+            i += n;
+
+            if (m_captured == m_sweepLength)
+            {
+                // Publish the sweep by swapping buffers, so nothing is copied or allocated
+                qSwap(m_captureKeys, m_sweepKeys);
+                qSwap(m_captureValues, m_sweepValues);
+                m_capturing = false;
+                m_sweepReady = true;
+                ++sweeps;
+            }
+            continue;
+        }
+
+        // Skip the samples inside the holdoff time
+        int start = i;
+        while (start < count && keys[start] < m_holdoffEnd)
+            ++start;
+
+        int trigger = (start > 0) ? findCrossing(values, start, count, true, values[start - 1])
+                                  : findCrossing(values, start, count, m_hasLastValue, m_lastValue);
+        if (trigger < 0)
+            break;
+
+        // The trigger is ignored until there are enough previous samples for the pre-trigger
+        if (m_historySize + trigger < m_preTriggerLength)
+        {
+            i = trigger + 1;
+            continue;
+        }
+
+        startCapture(keys, values, trigger);
+        i = trigger;
+    }
+
+    if (count > 0)
+    {
+        m_lastValue = values[count - 1];
+        m_hasLastValue = true;
+        appendToHistory(keys, values, count);
+    }
+
+    return sweeps;
+}
+
+bool TriggerEngine::takeSweep()
+{
+    bool sweepReady = m_sweepReady;
+    m_sweepReady = false;
+    return sweepReady;
+}
+
+int TriggerEngine::findCrossing(const double *values, int from, int count, bool hasPrevious, double previous) const
+{
+    if (from >= count)
+        return -1;
+
+    // Flip the sign of the samples for falling edges, so both slopes are searched as rising crossings
+    double sign = (m_slope == RisingEdge) ? 1.0 : -1.0;
+    double level = sign * m_level;
+    if (hasPrevious && sign * previous < level && sign * values[from] >= level)
+        return from;
+
+    // Test whole blocks without branches, so that the compiler can vectorize the comparisons,
+    // and only look for the exact sample inside the first block that contains a crossing
+    int i = from + 1;
+    for (; i + CrossingBlockSize <= count; i += CrossingBlockSize)
+    {
+        int found = 0;
+        for (int j = 0; j < CrossingBlockSize; ++j)
+            found |= (sign * values[i + j - 1] < level) & (sign * values[i + j] >= level);
+        if (found)
+            break;
+    }
+    for (; i < count; ++i)
+    {
+        if (sign * values[i - 1] < level && sign * values[i] >= level)
+            return i;
+    }
+
+    return -1;
+}
+
+void TriggerEngine::startCapture(const double *keys, const double *values, int trigger)
+{
+    m_triggerKey = keys[trigger];
+    m_holdoffEnd = m_triggerKey + m_holdoff;
+    m_capturing = true;
+    m_captured = 0;
+
+    // Pre-trigger samples from the history, if the block does not have enough of them
+    int fromHistory = qMax(m_preTriggerLength - trigger, 0);
+    int historyStart = m_historyPosition - fromHistory;
+    if (historyStart < 0)
+        historyStart += m_preTriggerLength;
+    for (int j = 0; j < fromHistory; ++j)
+    {
+        int position = (historyStart + j) % m_preTriggerLength;
+        m_captureKeys[m_captured] = m_historyKeys.at(position) - m_triggerKey;
+        m_captureValues[m_captured] = m_historyValues.at(position);
+        ++m_captured;
+    }
+
+    // And the rest from the block
+    for (int j = trigger - (m_preTriggerLength - fromHistory); j < trigger; ++j)
+    {
+        m_captureKeys[m_captured] = keys[j] - m_triggerKey;
+        m_captureValues[m_captured] = values[j];
+        ++m_captured;
+    }
+}
+
+void TriggerEngine::appendToHistory(const double *keys, const double *values, int count)
+{
+    if (m_preTriggerLength == 0)
+        return;
+
+    // Only the last samples can be part of a pre-trigger
+    int n = qMin(count, m_preTriggerLength);
+    for (int j = count - n; j < count; ++j)
+    {
+        m_historyKeys[m_historyPosition] = keys[j];
+        m_historyValues[m_historyPosition] = values[j];
+        m_historyPosition = (m_historyPosition + 1) % m_preTriggerLength;
+    }
+    m_historySize = qMin(m_historySize + n, m_preTriggerLength);
+}
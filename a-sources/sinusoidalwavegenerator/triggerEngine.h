@@ -0,0 +1,221 @@
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include <QVector>
+
+/**
+ * @brief Edge trigger that cuts fixed-size sweeps out of a continuous stream of samples, like an oscilloscope.
+ *
+ * The blocks of samples are scanned for the first crossing of the trigger level with the selected slope.
+ * When one is found, a sweep is captured with a number of samples before the crossing (pre-trigger,
+ * taken from a history of the previous samples) and the rest after it. The keys of the sweep are relative
+ * to the key of the crossing. After a crossing, no other one is accepted until the sweep is complete and
+ * the holdoff time has passed.
+ */
+class TriggerEngine
+{
+public:
+    /**
+     * @brief Slope of the signal that fires the trigger.
+     */
+    enum Slope
+    {
+        RisingEdge,
+        FallingEdge
+    };
+
+    /**
+     * @brief Constructor.
+     */
+    TriggerEngine();
+
+    /**
+     * @brief Gets the slope of the signal that fires the trigger.
+     * @return Trigger slope.
+     */
+    Slope slope() const { return m_slope; }
+    /**
+     * @brief Gets the level the signal has to cross to fire the trigger.
+     * @return Trigger level.
+     */
+    double level() const { return m_level; }
+    /**
+     * @brief Gets the minimum time between two triggers, in the units of the keys.
+     * @return Holdoff time.
+     */
+    double holdoff() const { return m_holdoff; }
+    /**
+     * @brief Gets the number of samples of a sweep.
+     * @return Sweep length.
+     */
+    int sweepLength() const { return m_sweepLength; }
+    /**
+     * @brief Gets the number of samples of a sweep before the trigger.
+     * @return Pre-trigger length.
+     */
+    int preTriggerLength() const { return m_preTriggerLength; }
+    /**
+     * @brief Gets the keys of the last complete sweep, relative to the key of its trigger.
+     * @return Keys of the sweep, with sweepLength() elements once a sweep has been taken.
+     */
+    const QVector<double> &sweepKeys() const { return m_sweepKeys; }
+    /**
+     * @brief Gets the values of the last complete sweep.
+     * @return Values of the sweep, with sweepLength() elements once a sweep has been taken.
+     */
+    const QVector<double> &sweepValues() const { return m_sweepValues; }
+
+    /**
+     * @brief Changes the slope of the signal that fires the trigger.
+     * @param slope New trigger slope.
+     */
+    void setSlope(Slope slope) { m_slope = slope; }
+    /**
+     * @brief Changes the level the signal has to cross to fire the trigger.
+     * @param level New trigger level.
+     */
+    void setLevel(double level) { m_level = level; }
+    /**
+     * @brief Changes the minimum time between two triggers.
+     * @param holdoff New holdoff time, in the units of the keys.
+     */
+    void setHoldoff(double holdoff) { m_holdoff = holdoff; }
+    /**
+     * @brief Changes the size of the sweeps. Discards the sweep being captured and the history.
+     * @param sweepLength Number of samples of a sweep.
+     * @param preTriggerLength Number of samples of a sweep before the trigger, at most sweepLength - 1.
+     */
+    void setSweepLength(int sweepLength, int preTriggerLength);
+    /**
+     * @brief Discards the sweep being captured and the history of samples.
+     */
+    void reset();
+
+    /**
+     * @brief Scans a block of samples for triggers and captures the sweeps.
+     * @param keys Keys of the samples, in ascending order and following the previous block.
+     * @param values Values of the samples.
+     * @param count Number of samples.
+     * @return Number of sweeps completed in this block.
+     */
+    int process(const double *keys, const double *values, int count);
+    /**
+     * @brief Checks whether a sweep has been completed since the last call, and clears the flag.
+     * @return true if sweepKeys() and sweepValues() hold a new sweep, or false otherwise.
+     */
+    bool takeSweep();
+
+private:
+    /**
+     * @brief Number of samples tested at once when looking for a crossing.
+     */
+    static const int CrossingBlockSize = 8;
+
+    /**
+     * @brief Finds the first crossing of the trigger level with the selected slope.
+     * @param values Values of the samples.
+     * @param from Index of the first sample to test.
+     * @param count Number of samples.
+     * @param hasPrevious Whether there is a sample before the one at from.
+     * @param previous Value of the sample before the one at from.
+     * @return Index of the first sample after the crossing, or -1 if there is none.
+     */
+    int findCrossing(const double *values, int from, int count, bool hasPrevious, double previous) const;
+    /**
+     * @brief Starts capturing a sweep, copying the pre-trigger samples from the history and the block.
+     * @param keys Keys of the block.
+     * @param values Values of the block.
+     * @param trigger Index of the trigger in the block.
+     */
+    void startCapture(const double *keys, const double *values, int trigger);
+    /**
+     * @brief Keeps the last samples of a block in the history, for the pre-trigger of later sweeps.
+     * @param keys Keys of the block.
+     * @param values Values of the block.
+     * @param count Number of samples of the block.
+     */
+    void appendToHistory(const double *keys, const double *values, int count);
+
+    /**
+     * @brief Slope of the signal that fires the trigger.
+     */
+    Slope m_slope;
+    /**
+     * @brief Level the signal has to cross to fire the trigger.
+     */
+    double m_level;
+    /**
+     * @brief Minimum time between two triggers.
+     */
+    double m_holdoff;
+    /**
+     * @brief Number of samples of a sweep.
+     */
+    int m_sweepLength;
+    /**
+     * @brief Number of samples of a sweep before the trigger.
+     */
+    int m_preTriggerLength;
+    /**
+     * @brief Keys of the last samples, used as pre-trigger (ring buffer).
+     */
+    QVector<double> m_historyKeys;
+    /**
+     * @brief Values of the last samples, used as pre-trigger (ring buffer).
+     */
+    QVector<double> m_historyValues;
+    /**
+     * @brief Position of the history where the next sample is written.
+     */
+    int m_historyPosition;
+    /**
+     * @brief Number of samples in the history.
+     */
+    int m_historySize;
+    /**
+     * @brief Whether there is a previous sample to detect a crossing at the start of a block.
+     */
+    bool m_hasLastValue;
+    /**
+     * @brief Value of the last sample of the previous block.
+     */
+    double m_lastValue;
+    /**
+     * @brief Key before which no trigger is accepted.
+     */
+    double m_holdoffEnd;
+    /**
+     * @brief Whether a sweep is being captured.
+     */
+    bool m_capturing;
+    /**
+     * @brief Key of the trigger of the sweep being captured.
+     */
+    double m_triggerKey;
+    /**
+     * @brief Number of samples of the sweep being captured.
+     */
+    int m_captured;
+    /**
+     * @brief Keys of the sweep being captured.
+     */
+    QVector<double> m_captureKeys;
+    /**
+     * @brief Values of the sweep being captured.
+     */
+    QVector<double> m_captureValues;
+    /**
+     * @brief Keys of the last complete sweep.
+     */
+    QVector<double> m_sweepKeys;
+    /**
+     * @brief Values of the last complete sweep.
+     */
+    QVector<double> m_sweepValues;
+    /**
+     * @brief Whether a sweep has been completed since the last call to takeSweep().
+     */
+    bool m_sweepReady;
+};
+
+#endif // TRIGGERENGINE_H
@@ -0,0 +1,193 @@
+#include "vectorExporter.h"
+#include <QSet>
+#include <QSvgGenerator>
+#include <cmath>
+#include "perfCounters.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Gets the device pixel of a coordinate along an axis.
+     * @param axis Axis.
+     * @param coordinate Coordinate.
+     * @param resolution Device pixels per plot pixel.
+     * @return Index of the device pixel.
+     */
+    inline qint64 devicePixel(const QCPAxis *axis, double coordinate, double resolution)
+    {
+        return (qint64)std::floor(axis->coordToPixel(coordinate) * resolution);
+    }
+}
+
+bool VectorExporter::save(QCustomPlot *plot, const QString &fileName, Format format, int width, int height, int resolution)
+{
+    SWG_PERF_SCOPE("VectorExporter::save");
+    SWG_TRACE_SCOPE("VectorExporter::save");
+
+    if (width == 0 || height == 0)
+    {
+        width = plot->width();
+        height = plot->height();
+    }
+
+    // Lay the plot out at the size of the document, which is what the axes map to while decimating
+    QRect oldViewport = plot->viewport();
+    plot->setViewport(QRect(0, 0, width, height));
+    plot->plotLayout()->update(QCPLayoutElement::upPreparation);
+    plot->plotLayout()->update(QCPLayoutElement::upMargins);
+    plot->plotLayout()->update(QCPLayoutElement::upLayout);
+
+    // Dense graphs draw their decimation instead, without adaptive sampling on top of it. The original
+    // data is kept with an implicitly shared copy, which costs nothing
+    QList<QCPGraph *> decimatedGraphs;
+    QList<QCPDataMap> originalData;
+    QList<bool> adaptiveSampling;
+    for (int i = 0; i < plot->graphCount(); ++i)
+    {
+        QCPGraph *graph = plot->graph(i);
+        if (!graph->visible() || graph->data()->isEmpty())
+            continue;
+        QCPDataMap *decimated = decimate(graph, resolution / 72.0);
+        if (decimated->size() >= graph->data()->size())
+        {
+            delete decimated;
+            continue;
+        }
+        decimatedGraphs.append(graph);
+        originalData.append(*graph->data());
+        adaptiveSampling.append(graph->adaptiveSampling());
+        graph->setAdaptiveSampling(false);
+        graph->setData(decimated);
+    }
+    plot->setViewport(oldViewport);
+
+    bool saved = false;
+    if (format == PdfFile)
+    {
+        saved = plot->savePdf(fileName, false, width, height);
+    }
+    else
+    {
+        QSvgGenerator generator;
+        generator.setFileName(fileName);
+        generator.setSize(QSize(width, height));
+        generator.setViewBox(QRect(0, 0, width, height));
+        QCPPainter painter;
+        if (painter.begin(&generator))
+        {
+            painter.setMode(QCPPainter::pmVectorized);
+            plot->toPainter(&painter, width, height);
+            saved = painter.end();
+        }
+    }
+
+    // Restore the data, and the layout of the widget
+    for (int i = 0; i < decimatedGraphs.size(); ++i)
+    {
+        decimatedGraphs.at(i)->setData(new QCPDataMap(originalData.at(i)));
+        decimatedGraphs.at(i)->setAdaptiveSampling(adaptiveSampling.at(i));
+    }
+    plot->replot();
+    SWG_PERF_VALUE("VectorExporter::save decimated graphs", decimatedGraphs.size());
+    return saved;
+}
+
+QCPDataMap *VectorExporter::decimate(const QCPGraph *graph, double resolution)
+{
+    SWG_TRACE_SCOPE("VectorExporter::decimate");
+
+    QCPDataMap *decimated = new QCPDataMap();
+    const QCPDataMap *data = graph->data();
+    QCPAxis *keyAxis = graph->keyAxis();
+    QCPAxis *valueAxis = graph->valueAxis();
+    if (data->isEmpty() || keyAxis == NULL || valueAxis == NULL)
+        return decimated;
+
+    // Samples in view, plus one on each side so that the lines reach the borders
+    QCPDataMap::const_iterator begin = data->lowerBound(keyAxis->range().lower);
+    if (begin != data->constBegin())
+        --begin;
+    QCPDataMap::const_iterator end = data->upperBound(keyAxis->range().upper);
+    if (end != data->constEnd())
+        ++end;
+
+    if (!graph->scatterStyle().isNone())
+    {
+        // Scatters: one sample per device pixel, since the others would be drawn over it. The samples
+        // of a column are consecutive, so only the rows of the current column are remembered
+        qint64 column = 0;
+        QSet<qint64> rows;
+        for (QCPDataMap::const_iterator it = begin; it != end; ++it)
+        {
+            double value = it.value().value;
+            if (qIsNaN(value))
+            {
+                decimated->insert(it.key(), it.value());
+                continue;
+            }
+            qint64 pixelColumn = devicePixel(keyAxis, it.key(), resolution);
+            if (pixelColumn != column || it == begin)
+            {
+                column = pixelColumn;
+                rows.clear();
+            }
+            qint64 row = devicePixel(valueAxis, value, resolution);
+            if (!rows.contains(row))
+            {
+                rows.insert(row);
+                decimated->insert(it.key(), it.value());
+            }
+        }
+    }
+    else
+    {
+        // Lines: the first, lowest, highest and last sample of each device pixel column, which draw
+        // the same vertical extent and connect to the neighbouring columns at the same points. Gaps
+        // (NaN) are kept and end the column
+        QCPDataMap::const_iterator first = end;
+        QCPDataMap::const_iterator lowest = end;
+        QCPDataMap::const_iterator highest = end;
+        QCPDataMap::const_iterator last = end;
+        qint64 column = 0;
+        for (QCPDataMap::const_iterator it = begin; ; ++it)
+        {
+            bool gap = (it != end) && qIsNaN(it.value().value);
+            qint64 pixelColumn = (it != end && !gap) ? devicePixel(keyAxis, it.key(), resolution) : 0;
+            if (first != end && (it == end || gap || pixelColumn != column))
+            {
+                decimated->insert(first.key(), first.value());
+                decimated->insert(lowest.key(), lowest.value());
+                decimated->insert(highest.key(), highest.value());
+                decimated->insert(last.key(), last.value());
+                first = end;
+            }
+            if (it == end)
+                break;
+            if (gap)
+            {
+                decimated->insert(it.key(), it.value());
+                continue;
+            }
+
+            if (first == end)
+            {
+                first = it;
+                lowest = it;
+                highest = it;
+                column = pixelColumn;
+            }
+            else if (it.value().value < lowest.value().value)
+            {
+                lowest = it;
+            }
+            else if (it.value().value > highest.value().value)
+            {
+                highest = it;
+            }
+            last = it;
+        }
+    }
+    return decimated;
+}
@@ -0,0 +1,59 @@
+#ifndef VECTOREXPORTER_H
+#define VECTOREXPORTER_H
+
+#include <qcustomplot.h>
+#include <QString>
+
+/**
+ * @brief Saves plots as vector documents (PDF, SVG) whose size depends on their resolution, not on their samples.
+ *
+ * QCustomPlot writes every drawn line segment and scatter of a graph to vector documents, and only
+ * decimates them with its adaptive sampling at one point per plot pixel, which is too coarse for a
+ * document that is zoomed or printed. Before saving, the data of each dense graph is replaced with
+ * its decimation at the resolution of the document: the first, lowest, highest and last sample of
+ * each device pixel column for lines, and one sample per device pixel for scatters, which draws the
+ * same at that resolution. The data is restored afterwards.
+ *
+ * Plot pixels are taken as points (1/72 inch), as QCustomPlot::savePdf does, so a plot of 800x600
+ * pixels is an 800x600 point page, and a resolution of 300 dpi decimates to 300/72 device pixels per
+ * plot pixel. Plottables other than QCPGraph already draw at most a few points per plot pixel.
+ */
+class VectorExporter
+{
+public:
+    /**
+     * @brief Format of the document.
+     */
+    enum Format
+    {
+        PdfFile,    ///< Portable Document Format
+        SvgFile     ///< Scalable Vector Graphics
+    };
+
+    /**
+     * @brief Default resolution of the documents, in dots per inch.
+     */
+    static const int DefaultResolution = 300;
+
+    /**
+     * @brief Saves a plot to a vector document.
+     * @param plot Plot.
+     * @param fileName Full path of the file.
+     * @param format Format of the document.
+     * @param width Width of the document, in points, or 0 to use the width of the plot.
+     * @param height Height of the document, in points, or 0 to use the height of the plot.
+     * @param resolution Resolution the graphs are decimated to, in dots per inch.
+     * @return true if the file is correctly saved, or false otherwise.
+     */
+    static bool save(QCustomPlot *plot, const QString &fileName, Format format, int width = 0, int height = 0, int resolution = DefaultResolution);
+    /**
+     * @brief Decimates the data of a graph in view to a resolution finer than its plot pixels.
+     * The axes have to be laid out at the size the graph is drawn.
+     * @param graph Graph.
+     * @param resolution Device pixels per plot pixel.
+     * @return Decimated data, owned by the caller.
+     */
+    static QCPDataMap *decimate(const QCPGraph *graph, double resolution);
+};
+
+#endif // VECTOREXPORTER_H
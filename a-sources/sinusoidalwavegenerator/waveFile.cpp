@@ -0,0 +1,306 @@
+#include "waveFile.h"
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include "perfCounters.h"
+#include "sampleExporter.h"
+#include "sinusoidalEquation.h"
+#include "traceRecorder.h"
+
+
+namespace
+{
+    /**
+     * @brief Magic at the start of the header.
+     */
+    const char HeaderMagic[] = "SWGWAVE1";
+    /**
+     * @brief Magic at the end of the trailer.
+     */
+    const char TrailerMagic[] = "SWGINDEX";
+    /**
+     * @brief Version of the format.
+     */
+    const quint32 FormatVersion = 1;
+
+    /**
+     * @brief Stores a double as little-endian.
+     * @param value Value.
+     * @param destination Destination, 8 bytes.
+     */
+    void putDouble(double value, uchar *destination)
+    {
+        quint64 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        qToLittleEndian<quint64>(bits, destination);
+    }
+
+    /**
+     * @brief Loads a little-endian double.
+     * @param source Source, 8 bytes.
+     * @return Value.
+     */
+    double getDouble(const uchar *source)
+    {
+        quint64 bits = qFromLittleEndian<quint64>(source);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Loads a column of little-endian doubles.
+     * @param source Source, count * 8 bytes.
+     * @param count Number of values.
+     * @param destination Destination.
+     */
+    void getColumn(const char *source, int count, double *destination)
+    {
+        memcpy(destination, source, count * sizeof(double));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        for (int i = 0; i < count; ++i)
+            destination[i] = getDouble(reinterpret_cast<const uchar *>(source) + i * sizeof(double));
+#endif
+    }
+}
+
+WaveFile::Parameters WaveFile::parameters(SinusoidalEquation *equation)
+{
+    Parameters parameters;
+    parameters.amplitude = equation->amplitude();
+    parameters.oscillationFrequency = equation->oscillationFrequency();
+    parameters.initialDelay = equation->initialDelay();
+    parameters.numberOfPeriods = equation->numberOfPeriods();
+    parameters.samplingFrequency = equation->samplingFrequency() / equation->decimationFactor();
+    parameters.attenuationFactor = equation->attenuationFactor();
+    return parameters;
+}
+
+QByteArray WaveFile::header(const Parameters &parameters)
+{
+    QByteArray header(HeaderSize, '\0');
+    uchar *p = reinterpret_cast<uchar *>(header.data());
+    memcpy(p, HeaderMagic, 8);
+    qToLittleEndian<quint32>(FormatVersion, p + 8);
+    qToLittleEndian<quint32>(ChunkSize, p + 12);
+    putDouble(parameters.amplitude, p + 16);
+    putDouble(parameters.oscillationFrequency, p + 24);
+    putDouble(parameters.initialDelay, p + 32);
+    putDouble(parameters.samplingFrequency, p + 40);
+    putDouble(parameters.attenuationFactor, p + 48);
+    qToLittleEndian<qint32>(parameters.numberOfPeriods, p + 56);
+    return header;
+}
+
+int WaveFile::encodeChunk(const double *times, const double *elongations, int count, char *output, ChunkSummary &summary)
+{
+    // Columns in the output byte order, the same as raw float64 samples
+    SampleConverter converter(Float64, 1.0, false);
+    converter.convert(times, count, output);
+    converter.convert(elongations, count, output + count * sizeof(double));
+
+    // Summary in a single pass over the elongation
+    double minimum = (count > 0) ? elongations[0] : 0.0;
+    double maximum = minimum;
+    double sumOfSquares = 0.0;
+    for (int i = 0; i < count; ++i)
+    {
+        double value = elongations[i];
+        minimum = qMin(minimum, value);
+        maximum = qMax(maximum, value);
+        sumOfSquares += value * value;
+    }
+    summary.count = count;
+    summary.firstTime = (count > 0) ? times[0] : 0.0;
+    summary.lastTime = (count > 0) ? times[count - 1] : 0.0;
+    summary.minimum = minimum;
+    summary.maximum = maximum;
+    summary.rms = (count > 0) ? std::sqrt(sumOfSquares / count) : 0.0;
+    return count * BytesPerSample;
+}
+
+QByteArray WaveFile::index(const QVector<ChunkSummary> &chunks, qint64 indexOffset)
+{
+    QByteArray index(chunks.size() * ChunkSummarySize + TrailerSize, '\0');
+    uchar *p = reinterpret_cast<uchar *>(index.data());
+    for (int i = 0; i < chunks.size(); ++i, p += ChunkSummarySize)
+    {
+        const ChunkSummary &chunk = chunks.at(i);
+        qToLittleEndian<qint64>(chunk.offset, p);
+        qToLittleEndian<qint32>(chunk.count, p + 8);
+        putDouble(chunk.firstTime, p + 16);
+        putDouble(chunk.lastTime, p + 24);
+        putDouble(chunk.minimum, p + 32);
+        putDouble(chunk.maximum, p + 40);
+        putDouble(chunk.rms, p + 48);
+    }
+    qToLittleEndian<qint64>(indexOffset, p);
+    qToLittleEndian<qint64>(chunks.size(), p + 8);
+    memcpy(p + 16, TrailerMagic, 8);
+    return index;
+}
+
+bool WaveFile::write(QIODevice *device, const Parameters &parameters, const QVector<double> &timeVector, const QVector<double> &elongationVector)
+{
+    SWG_PERF_SCOPE("WaveFile::write");
+    SWG_TRACE_SCOPE("WaveFile::write");
+
+    QByteArray data = header(parameters);
+    if (device->write(data) != data.size())
+        return false;
+
+    int count = qMin(timeVector.size(), elongationVector.size());
+    QByteArray buffer(ChunkSize * BytesPerSample, Qt::Uninitialized);
+    QVector<ChunkSummary> chunks;
+    chunks.reserve(count / ChunkSize + 1);
+    qint64 offset = HeaderSize;
+    for (int i = 0; i < count; i += ChunkSize)
+    {
+        ChunkSummary summary;
+        summary.offset = offset;
+        int bytes = encodeChunk(timeVector.constData() + i, elongationVector.constData() + i, qMin(ChunkSize, count - i), buffer.data(), summary);
+        if (device->write(buffer.constData(), bytes) != bytes)
+            return false;
+        chunks.append(summary);
+        offset += bytes;
+    }
+
+    data = index(chunks, offset);
+    return device->write(data) == data.size();
+}
+
+bool WaveFile::write(const QString &fileName, const Parameters &parameters, const QVector<double> &timeVector, const QVector<double> &elongationVector)
+{
+    QFile file(fileName);
+    if (!SampleExporter::openFile(file, fileName))
+        return false;
+
+    bool written = write(&file, parameters, timeVector, elongationVector);
+    return file.flush() && written;
+}
+
+WaveFileReader::WaveFileReader()
+    : m_file(),
+      m_parameters(),
+      m_chunks(),
+      m_sampleCount(0)
+{
+}
+
+bool WaveFileReader::open(const QString &fileName)
+{
+    SWG_TRACE_SCOPE("WaveFileReader::open");
+
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    // Header
+    QByteArray header = m_file.read(WaveFile::HeaderSize);
+    const uchar *p = reinterpret_cast<const uchar *>(header.constData());
+    if (header.size() != WaveFile::HeaderSize || memcmp(p, HeaderMagic, 8) != 0 || qFromLittleEndian<quint32>(p + 8) != FormatVersion)
+    {
+        close();
+        return false;
+    }
+    m_parameters.amplitude = getDouble(p + 16);
+    m_parameters.oscillationFrequency = getDouble(p + 24);
+    m_parameters.initialDelay = getDouble(p + 32);
+    m_parameters.samplingFrequency = getDouble(p + 40);
+    m_parameters.attenuationFactor = getDouble(p + 48);
+    m_parameters.numberOfPeriods = qFromLittleEndian<qint32>(p + 56);
+
+    // Trailer, which locates the index
+    qint64 fileSize = m_file.size();
+    QByteArray trailer;
+    if (fileSize >= WaveFile::HeaderSize + WaveFile::TrailerSize && m_file.seek(fileSize - WaveFile::TrailerSize))
+        trailer = m_file.read(WaveFile::TrailerSize);
+    p = reinterpret_cast<const uchar *>(trailer.constData());
+    if (trailer.size() != WaveFile::TrailerSize || memcmp(p + 16, TrailerMagic, 8) != 0)
+    {
+        close();
+        return false;
+    }
+    qint64 indexOffset = qFromLittleEndian<qint64>(p);
+    qint64 chunkCount = qFromLittleEndian<qint64>(p + 8);
+    if (chunkCount < 0 || indexOffset < WaveFile::HeaderSize || indexOffset + chunkCount * WaveFile::ChunkSummarySize != fileSize - WaveFile::TrailerSize)
+    {
+        close();
+        return false;
+    }
+
+    // Index
+    QByteArray index;
+    if (m_file.seek(indexOffset))
+        index = m_file.read(chunkCount * WaveFile::ChunkSummarySize);
+    if (index.size() != chunkCount * WaveFile::ChunkSummarySize)
+    {
+        close();
+        return false;
+    }
+    m_chunks.resize((int)chunkCount);
+    p = reinterpret_cast<const uchar *>(index.constData());
+    for (int i = 0; i < m_chunks.size(); ++i, p += WaveFile::ChunkSummarySize)
+    {
+        WaveFile::ChunkSummary &chunk = m_chunks[i];
+        chunk.offset = qFromLittleEndian<qint64>(p);
+        chunk.count = qFromLittleEndian<qint32>(p + 8);
+        chunk.firstTime = getDouble(p + 16);
+        chunk.lastTime = getDouble(p + 24);
+        chunk.minimum = getDouble(p + 32);
+        chunk.maximum = getDouble(p + 40);
+        chunk.rms = getDouble(p + 48);
+        if (chunk.count < 0 || chunk.count > WaveFile::ChunkSize || chunk.offset < WaveFile::HeaderSize
+                || chunk.offset + (qint64)chunk.count * WaveFile::BytesPerSample > indexOffset)
+        {
+            close();
+            return false;
+        }
+        m_sampleCount += chunk.count;
+    }
+    return true;
+}
+
+void WaveFileReader::close()
+{
+    m_file.close();
+    m_chunks.clear();
+    m_sampleCount = 0;
+}
+
+bool WaveFileReader::readChunks(int first, int count, QVector<double> &timeVector, QVector<double> &elongationVector)
+{
+    SWG_PERF_SCOPE("WaveFileReader::readChunks");
+    SWG_TRACE_SCOPE_ARG("WaveFileReader::readChunks", count);
+
+    timeVector.clear();
+    elongationVector.clear();
+    if (first < 0 || count < 0 || first + count > m_chunks.size())
+        return false;
+
+    int samples = 0;
+    for (int i = first; i < first + count; ++i)
+        samples += m_chunks.at(i).count;
+    timeVector.resize(samples);
+    elongationVector.resize(samples);
+
+    // Each chunk is read at once and its columns copied to the vectors
+    QByteArray buffer(WaveFile::ChunkSize * WaveFile::BytesPerSample, Qt::Uninitialized);
+    int position = 0;
+    for (int i = first; i < first + count; ++i)
+    {
+        const WaveFile::ChunkSummary &chunk = m_chunks.at(i);
+        qint64 bytes = (qint64)chunk.count * WaveFile::BytesPerSample;
+        if (!m_file.seek(chunk.offset) || m_file.read(buffer.data(), bytes) != bytes)
+        {
+            timeVector.clear();
+            elongationVector.clear();
+            return false;
+        }
+        getColumn(buffer.constData(), chunk.count, timeVector.data() + position);
+        getColumn(buffer.constData() + chunk.count * sizeof(double), chunk.count, elongationVector.data() + position);
+        position += chunk.count;
+    }
+    return true;
+}
@@ -0,0 +1,236 @@
+#ifndef WAVEFILE_H
+#define WAVEFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+class SinusoidalEquation;
+
+/**
+ * @brief Native waveform file (.swg): the wave parameters, the samples in chunks and an index of the chunks.
+ *
+ * All the values are little-endian. The file is made of:
+ * - A header of HeaderSize bytes: magic "SWGWAVE1", version, samples per chunk and the parameters of the wave.
+ * - The chunks, of ChunkSize samples except the last one. Each chunk is columnar: all its times, then
+ *   all its elongations, as doubles.
+ * - The index: one ChunkSummarySize entry per chunk with its offset, number of samples, first and last
+ *   time, and minimum, maximum and RMS of the elongation.
+ * - A trailer of TrailerSize bytes: offset of the index, number of chunks and magic "SWGINDEX".
+ *
+ * The index goes at the end, so files can be written in a single pass while the samples are generated,
+ * and read back by looking only at the trailer and the index until some samples are needed.
+ */
+class WaveFile
+{
+public:
+    /**
+     * @brief Parameters of the wave, as in SinusoidalEquation.
+     */
+    struct Parameters
+    {
+        /**
+         * @brief Amplitude of the wave.
+         */
+        double amplitude;
+        /**
+         * @brief Oscillation frequency of the wave, in hertz.
+         */
+        double oscillationFrequency;
+        /**
+         * @brief Initial delay of the wave, in degrees.
+         */
+        double initialDelay;
+        /**
+         * @brief Number of periods of the wave.
+         */
+        int numberOfPeriods;
+        /**
+         * @brief Sampling frequency of the stored samples, in hertz, or 0 if they are not uniformly sampled.
+         */
+        double samplingFrequency;
+        /**
+         * @brief Attenuation factor of the wave, in units per second.
+         */
+        double attenuationFactor;
+    };
+
+    /**
+     * @brief Entry of the index, describing one chunk.
+     */
+    struct ChunkSummary
+    {
+        /**
+         * @brief Offset of the chunk from the start of the file, in bytes.
+         */
+        qint64 offset;
+        /**
+         * @brief Number of samples of the chunk.
+         */
+        int count;
+        /**
+         * @brief Time of the first sample, in seconds.
+         */
+        double firstTime;
+        /**
+         * @brief Time of the last sample, in seconds.
+         */
+        double lastTime;
+        /**
+         * @brief Minimum elongation.
+         */
+        double minimum;
+        /**
+         * @brief Maximum elongation.
+         */
+        double maximum;
+        /**
+         * @brief Root mean square of the elongation.
+         */
+        double rms;
+    };
+
+    /**
+     * @brief Number of samples of each chunk, except the last one.
+     */
+    static const int ChunkSize = 1 << 16;
+    /**
+     * @brief Bytes taken by each sample in a chunk: time and elongation.
+     */
+    static const int BytesPerSample = 2 * sizeof(double);
+    /**
+     * @brief Size of the header, in bytes.
+     */
+    static const int HeaderSize = 64;
+    /**
+     * @brief Size of each entry of the index, in bytes.
+     */
+    static const int ChunkSummarySize = 56;
+    /**
+     * @brief Size of the trailer, in bytes.
+     */
+    static const int TrailerSize = 24;
+
+    /**
+     * @brief Gets the parameters of a solved equation, with the sampling frequency of its samples,
+     * which is lower than the requested one if they were decimated.
+     * @param equation Equation.
+     * @return Parameters.
+     */
+    static Parameters parameters(SinusoidalEquation *equation);
+    /**
+     * @brief Gets the header of a file.
+     * @param parameters Parameters of the wave.
+     * @return Header, HeaderSize bytes.
+     */
+    static QByteArray header(const Parameters &parameters);
+    /**
+     * @brief Encodes a chunk and summarizes it for the index.
+     * @param times Time of each sample, in seconds.
+     * @param elongations Elongation of each sample.
+     * @param count Number of samples, at most ChunkSize.
+     * @param output Buffer of at least count * BytesPerSample bytes.
+     * @param summary Output summary of the chunk. Its offset is not set.
+     * @return Number of bytes written.
+     */
+    static int encodeChunk(const double *times, const double *elongations, int count, char *output, ChunkSummary &summary);
+    /**
+     * @brief Gets the index and the trailer that close a file.
+     * @param chunks Summaries of all the chunks, in order.
+     * @param indexOffset Offset of the index from the start of the file, in bytes.
+     * @return Index followed by the trailer.
+     */
+    static QByteArray index(const QVector<ChunkSummary> &chunks, qint64 indexOffset);
+    /**
+     * @brief Writes a whole file with the given samples.
+     * @param device Device open for writing, at the start of the file.
+     * @param parameters Parameters of the wave.
+     * @param timeVector Time of each sample, in seconds.
+     * @param elongationVector Elongation of each sample.
+     * @return true if the file is completely written, or false otherwise.
+     */
+    static bool write(QIODevice *device, const Parameters &parameters, const QVector<double> &timeVector, const QVector<double> &elongationVector);
+    /**
+     * @brief Writes a whole file with the given samples.
+     * @param fileName Full path of the file, or '-' for the standard output.
+     * @param parameters Parameters of the wave.
+     * @param timeVector Time of each sample, in seconds.
+     * @param elongationVector Elongation of each sample.
+     * @return true if the file is correctly written, or false otherwise.
+     */
+    static bool write(const QString &fileName, const Parameters &parameters, const QVector<double> &timeVector, const QVector<double> &elongationVector);
+};
+
+/**
+ * @brief Reads waveform files. Opening reads the header and the index only; samples are read by chunks on demand.
+ */
+class WaveFileReader
+{
+public:
+    /**
+     * @brief Constructor.
+     */
+    WaveFileReader();
+
+    /**
+     * @brief Opens a file and reads its header and index.
+     * @param fileName Full path of the file.
+     * @return true if the file is a valid waveform file, or false otherwise.
+     */
+    bool open(const QString &fileName);
+    /**
+     * @brief Closes the file.
+     */
+    void close();
+    /**
+     * @brief Gets whether a file is open.
+     * @return true if open, or false otherwise.
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+    /**
+     * @brief Gets the parameters of the wave stored in the file.
+     * @return Parameters.
+     */
+    const WaveFile::Parameters &parameters() const { return m_parameters; }
+    /**
+     * @brief Gets the index of the file.
+     * @return Summary of each chunk, in order.
+     */
+    const QVector<WaveFile::ChunkSummary> &chunks() const { return m_chunks; }
+    /**
+     * @brief Gets the number of samples of the file.
+     * @return Number of samples.
+     */
+    qint64 sampleCount() const { return m_sampleCount; }
+    /**
+     * @brief Reads the samples of consecutive chunks.
+     * @param first Index of the first chunk.
+     * @param count Number of chunks.
+     * @param timeVector Output time of each sample, in seconds.
+     * @param elongationVector Output elongation of each sample.
+     * @return true if the chunks are read, or false otherwise.
+     */
+    bool readChunks(int first, int count, QVector<double> &timeVector, QVector<double> &elongationVector);
+
+private:
+    /**
+     * @brief File being read.
+     */
+    QFile m_file;
+    /**
+     * @brief Parameters of the wave stored in the file.
+     */
+    WaveFile::Parameters m_parameters;
+    /**
+     * @brief Index of the file.
+     */
+    QVector<WaveFile::ChunkSummary> m_chunks;
+    /**
+     * @brief Number of samples of the file.
+     */
+    qint64 m_sampleCount;
+};
+
+#endif // WAVEFILE_H
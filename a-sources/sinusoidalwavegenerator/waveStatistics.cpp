@@ -0,0 +1,64 @@
+#include "waveStatistics.h"
+#include <cmath>
+
+
+WaveStatistics::WaveStatistics()
+    : m_count(0),
+      m_mean(0.0),
+      m_m2(0.0),
+      m_peak(0.0),
+      m_zeroCrossings(0),
+      m_firstSign(0),
+      m_lastSign(0)
+{
+}
+
+void WaveStatistics::merge(const WaveStatistics &next)
+{
+    if (next.m_count == 0)
+        return;
+    if (m_count == 0)
+    {
+        *this = next;
+        return;
+    }
+
+    // Chan's update of the mean and the squared differences of two sets
+    qint64 count = m_count + next.m_count;
+    double delta = next.m_mean - m_mean;
+    m_mean += delta * ((double)next.m_count / count);
+    m_m2 += next.m_m2 + delta * delta * ((double)m_count * next.m_count / count);
+    m_count = count;
+    m_peak = qMax(m_peak, next.m_peak);
+
+    // The chunks can cross zero between them
+    m_zeroCrossings += next.m_zeroCrossings;
+    if (m_lastSign != 0 && next.m_firstSign != 0 && m_lastSign != next.m_firstSign)
+        ++m_zeroCrossings;
+    if (m_firstSign == 0)
+        m_firstSign = next.m_firstSign;
+    if (next.m_lastSign != 0)
+        m_lastSign = next.m_lastSign;
+}
+
+void WaveStatistics::clear()
+{
+    *this = WaveStatistics();
+}
+
+double WaveStatistics::sumOfSquares() const
+{
+    // Both terms are positive, so nothing cancels
+    return m_count * m_mean * m_mean + m_m2;
+}
+
+double WaveStatistics::rms() const
+{
+    return (m_count > 0) ? std::sqrt(sumOfSquares() / m_count) : 0.0;
+}
+
+double WaveStatistics::crestFactor() const
+{
+    double value = rms();
+    return (value > 0.0) ? m_peak / value : 0.0;
+}
@@ -0,0 +1,123 @@
+#ifndef WAVESTATISTICS_H
+#define WAVESTATISTICS_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Running statistics of a sequence of samples, updated as they are generated.
+ *
+ * The mean and the squares are accumulated with Welford's method, which does not lose precision with
+ * long sequences or a large offset the way a plain sum of squares does. Statistics of consecutive
+ * chunks of a sequence, accumulated separately (for instance by different threads), are merged into
+ * those of the whole sequence with merge(), including the zero crossing between the chunks.
+ */
+class WaveStatistics
+{
+public:
+    /**
+     * @brief Constructor. No samples.
+     */
+    WaveStatistics();
+
+    /**
+     * @brief Adds the next sample of the sequence.
+     * @param value Sample.
+     */
+    inline void add(double value)
+    {
+        ++m_count;
+        double delta = value - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (value - m_mean);
+        double magnitude = qAbs(value);
+        if (magnitude > m_peak)
+            m_peak = magnitude;
+
+        int sign = (value > 0.0) ? 1 : (value < 0.0) ? -1 : 0;
+        if (sign != 0)
+        {
+            if (m_firstSign == 0)
+                m_firstSign = sign;
+            else if (sign != m_lastSign)
+                ++m_zeroCrossings;
+            m_lastSign = sign;
+        }
+    }
+    /**
+     * @brief Adds the statistics of the samples that follow these ones in the sequence.
+     * @param next Statistics of the next samples.
+     */
+    void merge(const WaveStatistics &next);
+    /**
+     * @brief Removes all the samples.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of samples.
+     * @return Number of samples.
+     */
+    qint64 count() const { return m_count; }
+    /**
+     * @brief Gets the largest absolute value of the samples.
+     * @return Peak, or 0 without samples.
+     */
+    double peak() const { return m_peak; }
+    /**
+     * @brief Gets the mean of the samples.
+     * @return Mean, or 0 without samples.
+     */
+    double mean() const { return m_mean; }
+    /**
+     * @brief Gets the sum of the squared samples.
+     * @return Sum of squares.
+     */
+    double sumOfSquares() const;
+    /**
+     * @brief Gets the root mean square of the samples.
+     * @return RMS, or 0 without samples.
+     */
+    double rms() const;
+    /**
+     * @brief Gets the ratio of the peak to the RMS.
+     * @return Crest factor, or 0 if the RMS is 0.
+     */
+    double crestFactor() const;
+    /**
+     * @brief Gets the number of sign changes between consecutive non-zero samples.
+     * @return Number of zero crossings.
+     */
+    qint64 zeroCrossings() const { return m_zeroCrossings; }
+
+private:
+    /**
+     * @brief Number of samples.
+     */
+    qint64 m_count;
+    /**
+     * @brief Mean of the samples.
+     */
+    double m_mean;
+    /**
+     * @brief Sum of the squared differences to the mean.
+     */
+    double m_m2;
+    /**
+     * @brief Largest absolute value.
+     */
+    double m_peak;
+    /**
+     * @brief Number of sign changes between consecutive non-zero samples.
+     */
+    qint64 m_zeroCrossings;
+    /**
+     * @brief Sign of the first non-zero sample, or 0 if there is none.
+     */
+    int m_firstSign;
+    /**
+     * @brief Sign of the last non-zero sample, or 0 if there is none.
+     */
+    int m_lastSign;
+};
+
+#endif // WAVESTATISTICS_H